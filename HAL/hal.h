@@ -21,6 +21,14 @@
     #include "tm4c1294/hal_mpu_tm4c.h"
 
 
+#elif defined(__BOARD_HOST__)
+
+    //  Stand-ins for running parts of the libraries on a PC
+    #include "host/hal_common_host.h"
+    #include "host/hal_mpu_host.h"
+    #include "host/hal_eeprom_host.h"
+
+
 #elif __BOARD_ATMEGA328P__
 //TODO: Arduino support
     #include "atmega328p_hal.h"
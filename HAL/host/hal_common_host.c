@@ -0,0 +1,70 @@
+/**
+ * hal_common_host.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "hal_common_host.h"
+
+#if defined(__BOARD_HOST__)     //  Compile only if building for PC
+
+//  Simulated time in us
+static uint64_t _timeUS = 0;
+
+
+/**
+ * Wait for given time, advances simulated time
+ * @param us Time in microseconds
+ */
+void HAL_DelayUS(uint32_t us)
+{
+    _timeUS += us;
+}
+
+/**
+ * Nothing to set up, simulated time starts at 0
+ */
+void HAL_TS_InitSysTick()
+{
+}
+
+/**
+ * Get time since start in milliseconds
+ * Reading takes 1us, so loops waiting for time to pass always finish
+ * @return Time in ms
+ */
+uint32_t HAL_TS_GetTimeMS()
+{
+    _timeUS++;
+    return (uint32_t)(_timeUS / 1000);
+}
+
+/**
+ * Get time since start in microseconds
+ * Reading takes 1us, so loops waiting for time to pass always finish
+ * @return Time in us, wraps around like the one on the board
+ */
+uint32_t HAL_TS_GetTimeUS()
+{
+    _timeUS++;
+    return (uint32_t)_timeUS;
+}
+
+/**
+ * Used to mark unused arguments, does nothing
+ */
+void UNUSED(int32_t arg)
+{
+    (void)arg;
+}
+
+/**
+ * Get simulated time without advancing it
+ * @return Time in us since start
+ */
+uint64_t HAL_HOST_GetTimeUS()
+{
+    return _timeUS;
+}
+
+#endif  /* __BOARD_HOST__ */
@@ -0,0 +1,40 @@
+/**
+ * hal_common_host.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Stand-in for common board functions of TM4C1294 when running on a PC.
+ *  Time is simulated: it only advances with delays, with bus transactions of
+ *  simulated MPU (hal_mpu_host.h) and by 1us on every reading of the clock,
+ *  so runs are repeatable and don't depend on speed of the PC. Interface is
+ *  the same as the one in tm4c1294/hal_common_tm4c.h.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+#if !defined(ROVERKERNEL_HAL_HOST_HAL_COMMON_HOST_H_) && defined(__BOARD_HOST__)
+#define ROVERKERNEL_HAL_HOST_HAL_COMMON_HOST_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern void         HAL_DelayUS(uint32_t us);
+extern void         HAL_TS_InitSysTick();
+extern uint32_t     HAL_TS_GetTimeMS();
+extern uint32_t     HAL_TS_GetTimeUS();
+extern void         UNUSED (int32_t arg);
+
+//  Simulated time in us since start, read without advancing it
+extern uint64_t     HAL_HOST_GetTimeUS();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROVERKERNEL_HAL_HOST_HAL_COMMON_HOST_H_ */
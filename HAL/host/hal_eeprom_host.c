@@ -0,0 +1,95 @@
+/**
+ * hal_eeprom_host.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "hal_eeprom_host.h"
+
+#if defined(__BOARD_HOST__)     //  Compile only if building for PC
+
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * Open file holding EEPROM content, create it if it doesn't exist yet
+ * New file is filled with 0xFF, as erased EEPROM would be
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if file can't be created
+ */
+uint8_t HAL_EEPROM_Init()
+{
+    uint8_t erased[64];
+    uint32_t i;
+    FILE *f = fopen(HAL_EEPROM_FILE, "rb");
+
+    if (f != NULL)
+    {
+        fclose(f);
+        return HAL_OK;
+    }
+
+    f = fopen(HAL_EEPROM_FILE, "wb");
+    if (f == NULL)
+        return HAL_EEPROM_ERROR;
+    memset(erased, 0xFF, sizeof(erased));
+    for (i = 0; i < HAL_EEPROM_SIZE; i += sizeof(erased))
+        fwrite(erased, 1, sizeof(erased), f);
+    fclose(f);
+
+    return HAL_OK;
+}
+
+/**
+ * Read block of data from EEPROM file
+ * @param addr Byte address in EEPROM, multiple of 4
+ * @param data Buffer to hold data
+ * @param len Length of data in bytes, multiple of 4
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if block is outside of EEPROM
+ *         or file can't be read
+ */
+uint8_t HAL_EEPROM_Read(uint32_t addr, uint32_t *data, uint32_t len)
+{
+    FILE *f;
+    size_t n;
+
+    if ((addr + len) > HAL_EEPROM_SIZE)
+        return HAL_EEPROM_ERROR;
+
+    f = fopen(HAL_EEPROM_FILE, "rb");
+    if (f == NULL)
+        return HAL_EEPROM_ERROR;
+    fseek(f, addr, SEEK_SET);
+    n = fread(data, 1, len, f);
+    fclose(f);
+
+    return (n == len) ? HAL_OK : HAL_EEPROM_ERROR;
+}
+
+/**
+ * Write block of data into EEPROM file
+ * @param addr Byte address in EEPROM, multiple of 4
+ * @param data Data to write
+ * @param len Length of data in bytes, multiple of 4
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if block is outside of EEPROM
+ *         or file can't be written
+ */
+uint8_t HAL_EEPROM_Write(uint32_t addr, const uint32_t *data, uint32_t len)
+{
+    FILE *f;
+    size_t n;
+
+    if ((addr + len) > HAL_EEPROM_SIZE)
+        return HAL_EEPROM_ERROR;
+
+    f = fopen(HAL_EEPROM_FILE, "r+b");
+    if (f == NULL)
+        return HAL_EEPROM_ERROR;
+    fseek(f, addr, SEEK_SET);
+    n = fwrite(data, 1, len, f);
+    fclose(f);
+
+    return (n == len) ? HAL_OK : HAL_EEPROM_ERROR;
+}
+
+#endif  /* __BOARD_HOST__ */
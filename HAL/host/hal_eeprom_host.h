@@ -0,0 +1,45 @@
+/**
+ * hal_eeprom_host.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Stand-in for on-chip EEPROM of TM4C1294 when running on a PC (e.g. for
+ *  testing), EEPROM content is kept in a file. Interface is the same as the one
+ *  in tm4c1294/hal_common_tm4c.h.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+#if !defined(ROVERKERNEL_HAL_HOST_HAL_EEPROM_HOST_H_) && defined(__BOARD_HOST__)
+#define ROVERKERNEL_HAL_HOST_HAL_EEPROM_HOST_H_
+
+#define HAL_OK                  0
+#define HAL_EEPROM_ERROR        1
+
+//  File holding EEPROM content, created on first use
+#ifndef HAL_EEPROM_FILE
+#define HAL_EEPROM_FILE         "eeprom.bin"
+#endif
+//  Size of EEPROM in bytes, same as on TM4C1294
+#define HAL_EEPROM_SIZE         6144
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern uint8_t      HAL_EEPROM_Init();
+extern uint8_t      HAL_EEPROM_Read(uint32_t addr, uint32_t *data,
+                                    uint32_t len);
+extern uint8_t      HAL_EEPROM_Write(uint32_t addr, const uint32_t *data,
+                                     uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROVERKERNEL_HAL_HOST_HAL_EEPROM_HOST_H_ */
@@ -0,0 +1,672 @@
+/**
+ * hal_mpu_host.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "hal_mpu_host.h"
+
+//  Compile only if building for PC and module is enabled
+#if defined(__HAL_USE_MPU9250__) && defined(__BOARD_HOST__)
+
+#include <stdio.h>
+#include <string.h>
+#include "hal_common_host.h"
+#include "mpu9250/registerMap.h"
+
+//  Bits of registers with side effects
+#define SIM_PWR_RESET       0x80    //  PWR_MGMT_1: device reset
+#define SIM_PWR_SLEEP       0x40    //  PWR_MGMT_1: sleep
+#define SIM_USER_FIFO_EN    0x40    //  USER_CTRL: FIFO enabled
+#define SIM_USER_MST_EN     0x20    //  USER_CTRL: I2C master enabled
+#define SIM_USER_RESETS     0x0F    //  USER_CTRL: self-clearing reset bits
+#define SIM_USER_FIFO_RST   0x04    //  USER_CTRL: FIFO reset
+#define SIM_CFG_FIFO_MODE   0x40    //  CONFIG: full FIFO keeps oldest data
+#define SIM_PIN_BYPASS      0x02    //  INT_PIN_CFG: I2C bypass to AK8963
+#define SIM_INT_RAW_RDY     0x01    //  INT_STATUS: new sample
+#define SIM_INT_FIFO_OFLOW  0x10    //  INT_STATUS: FIFO overflow
+#define SIM_MST_SLV4_DONE   0x40    //  I2C_MST_STATUS: slave 4 finished
+#define SIM_MST_SLV4_NACK   0x10    //  I2C_MST_STATUS: slave 4 not acked
+#define SIM_AK_BITM         0x10    //  AK8963 CNTL, ST2: 16-bit output
+#define SIM_AK_MODE         0x0F    //  AK8963 CNTL: operating mode
+#define SIM_AK_SINGLE       0x01    //  AK8963 CNTL: single measurement mode
+#define SIM_AK_SRST         0x01    //  AK8963 CNTL2: soft reset
+
+#define SIM_FIFO_SIZE       512
+#define SIM_DMP_MEM_SIZE    4096
+#define SIM_EXT_SENS_SIZE   24
+//  Output of temperature sensor, ~24degC
+#define SIM_TEMP            1000
+
+HalMpuSim HAL_MPU_Sim =
+{
+    true, true, true,           //  MPU9250 and AK8963 present, sampling
+    11000, 8, -1,               //  Start-up time (datasheet), 1MHz SPI
+    { 100, -50, 16384 + 200 },  //  Accel: level, with small biases
+    { 40, -20, 13 },            //  Gyro: still, with small biases
+    { 300, -120, 450 },         //  Magnetometer
+    false, 0, 0, 0
+};
+
+//  Factory trim in accel offset registers, bit 0 (temperature compensation)
+//  differs between axes
+static const int16_t _accelTrim[3] = { 0x0F61, (int16_t)0xF0E3, 0x1A24 };
+
+static bool _powered = false;
+//  MPU9250 registers, chip doesn't answer (reads give 0) until _readyAt
+static uint8_t _reg[128];
+static uint64_t _readyAt;
+//  Time of next internal (1kHz) sample, and internal samples since the last
+//  one output, compared to rate divider on every internal sample
+static uint64_t _nextSample;
+static uint32_t _divCount;
+static uint8_t _fifo[SIM_FIFO_SIZE];
+static uint16_t _fifoLen;
+static uint8_t _dmpMem[SIM_DMP_MEM_SIZE];
+//  AK8963 registers, and time of next measurement (period 0 when idle)
+static uint8_t _ak[AK8963_ASAZ + 1];
+static uint64_t _nextMag;
+static uint32_t _magPeriod;
+
+
+/**
+ * Whether MPU9250 answers on the bus at the moment
+ */
+static bool _Answers()
+{
+    return _powered && HAL_MPU_Sim.present
+           && (HAL_HOST_GetTimeUS() >= _readyAt);
+}
+
+/**
+ * Put AK8963 into its power-on state
+ */
+static void _AkReset()
+{
+    memset(_ak, 0, sizeof(_ak));
+    _ak[WHO_AM_I_AK8963] = 0x48;
+    _ak[AK8963_ASAX] = 0xB0;
+    _ak[AK8963_ASAY] = 0xB3;
+    _ak[AK8963_ASAZ] = 0xA7;
+    _magPeriod = 0;
+}
+
+/**
+ * Put MPU9250 registers into their reset state, chip answers again once its
+ * start-up time has passed
+ */
+static void _Reset()
+{
+    uint8_t i;
+
+    memset(_reg, 0, sizeof(_reg));
+    _reg[PWR_MGMT_1] = 0x01;
+    _reg[WHO_AM_I_MPU9250] = 0x71;
+    for (i = 0; i < 3; i++)
+    {
+        _reg[XA_OFFSET_H + 3*i] = (uint8_t)(_accelTrim[i] >> 8);
+        _reg[XA_OFFSET_L + 3*i] = (uint8_t)_accelTrim[i];
+    }
+    _fifoLen = 0;
+    _readyAt = HAL_HOST_GetTimeUS() + HAL_MPU_Sim.startUS;
+    _nextSample = _readyAt;
+    _divCount = 0;
+}
+
+/**
+ * Take one measurement of AK8963. If previous one wasn't read, data overrun
+ * is flagged. Single measurement mode powers down after measurement.
+ */
+static void _AkMeasure()
+{
+    uint8_t i;
+    int16_t v;
+
+    if (_ak[AK8963_ST1] & AK8963_ST1_DRDY)
+        _ak[AK8963_ST1] |= AK8963_ST1_DOR;
+    _ak[AK8963_ST1] |= AK8963_ST1_DRDY;
+    for (i = 0; i < 3; i++)
+    {
+        v = HAL_MPU_Sim.mag[i];
+        if (!(_ak[AK8963_CNTL] & SIM_AK_BITM))
+            v /= 4;
+        _ak[AK8963_XOUT_L + 2*i] = (uint8_t)v;
+        _ak[AK8963_XOUT_H + 2*i] = (uint8_t)(v >> 8);
+    }
+    _ak[AK8963_ST2] = _ak[AK8963_CNTL] & SIM_AK_BITM;
+
+    if ((_ak[AK8963_CNTL] & SIM_AK_MODE) == SIM_AK_SINGLE)
+    {
+        _ak[AK8963_CNTL] &= ~SIM_AK_MODE;
+        _magPeriod = 0;
+    }
+}
+
+/**
+ * Read register of AK8963, reading ST2 ends reading of a measurement
+ */
+static uint8_t _AkRead(uint8_t reg)
+{
+    uint8_t v;
+
+    if (reg > AK8963_ASAZ)
+        return 0;
+    v = _ak[reg];
+    if (reg == AK8963_ST2)
+        _ak[AK8963_ST1] &= ~(AK8963_ST1_DRDY | AK8963_ST1_DOR);
+
+    return v;
+}
+
+/**
+ * Write register of AK8963, writing CNTL changes measurement mode
+ */
+static void _AkWrite(uint8_t reg, uint8_t data)
+{
+    if ((reg == AK8963_CNTL2) && (data & SIM_AK_SRST))
+    {
+        _AkReset();
+        return;
+    }
+    if (reg != AK8963_CNTL)
+        return;
+
+    _ak[AK8963_CNTL] = data;
+    switch (data & SIM_AK_MODE)
+    {
+    case SIM_AK_SINGLE:
+        _magPeriod = 7200;
+        break;
+    case M_8HZ:
+        _magPeriod = 125000;
+        break;
+    case M_100HZ:
+        _magPeriod = 10000;
+        break;
+    default:
+        _magPeriod = 0;
+        break;
+    }
+    _nextMag = HAL_HOST_GetTimeUS() + _magPeriod;
+}
+
+/**
+ * Carry out transaction of I2C master slave 0-4 with AK8963
+ * @param addr I2C_SLVx_ADDR register
+ * @param reg Register of slave
+ * @param data Byte(s) read or to write
+ * @param len Bytes to read (writes are always 1 byte)
+ * @return false if slave didn't acknowledge
+ */
+static bool _Slave(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t len)
+{
+    uint8_t i;
+
+    if (!HAL_MPU_Sim.akPresent || ((addr & ~I2C_SLV_RNW) != AK8963_ADDRESS))
+        return false;
+
+    if (addr & I2C_SLV_RNW)
+        for (i = 0; i < len; i++)
+            data[i] = _AkRead(reg + i);
+    else
+        _AkWrite(reg, data[0]);
+
+    return true;
+}
+
+/**
+ * Add byte to FIFO. When it's full, overflow is flagged and either the new
+ * byte (FIFO_MODE in CONFIG set) or the oldest one is dropped
+ */
+static void _FifoPush(uint8_t b)
+{
+    if (_fifoLen == SIM_FIFO_SIZE)
+    {
+        _reg[INT_STATUS] |= SIM_INT_FIFO_OFLOW;
+        if (_reg[CONFIG] & SIM_CFG_FIFO_MODE)
+            return;
+        memmove(_fifo, _fifo + 1, SIM_FIFO_SIZE - 1);
+        _fifoLen--;
+    }
+    _fifo[_fifoLen++] = b;
+}
+
+/**
+ * Take one sample: update data registers, FIFO and status, and carry out
+ * transactions of I2C master
+ */
+static void _Sample()
+{
+    uint8_t i, len, ext = 0;
+    uint8_t *slv;
+    int16_t out[7];
+    int32_t v, trim;
+
+    HAL_MPU_Sim.samples++;
+
+    //  Accel, temperature and gyro as in data registers. Offset registers
+    //  are added: accel ones in steps of 16g range, relative to factory trim,
+    //  gyro ones in steps of 1000dps range
+    for (i = 0; i < 3; i++)
+    {
+        v = ((int16_t)(_reg[XA_OFFSET_H + 3*i] << 8) | _reg[XA_OFFSET_L + 3*i])
+            & ~1;
+        trim = _accelTrim[i] & ~1;
+        v = (HAL_MPU_Sim.accel[i] + 8 * (v - trim))
+            >> ((_reg[ACCEL_CONFIG] & ACCEL_CONFIG_FS_SEL) >> 3);
+        out[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+
+        v = (int16_t)(_reg[XG_OFFSET_H + 2*i] << 8) | _reg[XG_OFFSET_L + 2*i];
+        v = (HAL_MPU_Sim.gyro[i] + 4 * v)
+            >> ((_reg[GYRO_CONFIG] & GYRO_CONFIG_FS_SEL) >> 3);
+        out[4 + i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+    out[3] = SIM_TEMP;
+
+    for (i = 0; i < 7; i++)
+    {
+        _reg[ACCEL_XOUT_H + 2*i] = (uint8_t)(out[i] >> 8);
+        _reg[ACCEL_XOUT_L + 2*i] = (uint8_t)out[i];
+    }
+    _reg[INT_STATUS] |= SIM_INT_RAW_RDY;
+
+    //  FIFO is filled in order of data registers
+    if (_reg[USER_CTRL] & SIM_USER_FIFO_EN)
+    {
+        if (_reg[FIFO_EN] & 0x08)
+            for (i = ACCEL_XOUT_H; i <= ACCEL_ZOUT_L; i++)
+                _FifoPush(_reg[i]);
+        if (_reg[FIFO_EN] & 0x80)
+            for (i = TEMP_OUT_H; i <= TEMP_OUT_L; i++)
+                _FifoPush(_reg[i]);
+        for (i = 0; i < 3; i++)
+            if (_reg[FIFO_EN] & (0x40 >> i))
+            {
+                _FifoPush(_reg[GYRO_XOUT_H + 2*i]);
+                _FifoPush(_reg[GYRO_XOUT_L + 2*i]);
+            }
+    }
+
+    if (!(_reg[USER_CTRL] & SIM_USER_MST_EN))
+        return;
+
+    //  Slaves 0-3 on every sample, reads fill external sensor data in order
+    for (i = 0; i < 4; i++)
+    {
+        slv = &_reg[I2C_SLV0_ADDR + 3*i];
+        if (!(slv[2] & I2C_SLV_EN))
+            continue;
+        len = slv[2] & I2C_SLV_LENG;
+        if (slv[0] & I2C_SLV_RNW)
+        {
+            if (ext + len > SIM_EXT_SENS_SIZE)
+                len = SIM_EXT_SENS_SIZE - ext;
+            if (!_Slave(slv[0], slv[1], &_reg[EXT_SENS_DATA_00 + ext], len))
+                _reg[I2C_MST_STATUS] |= 1 << i;
+            ext += len;
+        }
+        else if (!_Slave(slv[0], slv[1], &_reg[I2C_SLV0_DO + i], 1))
+            _reg[I2C_MST_STATUS] |= 1 << i;
+    }
+
+    //  Slave 4 carries out a single transaction and disables itself
+    if (_reg[I2C_SLV4_CTRL] & I2C_SLV_EN)
+    {
+        _reg[I2C_SLV4_CTRL] &= ~I2C_SLV_EN;
+        if (_reg[I2C_SLV4_ADDR] & I2C_SLV_RNW)
+            v = _Slave(_reg[I2C_SLV4_ADDR], _reg[I2C_SLV4_REG],
+                       &_reg[I2C_SLV4_DI], 1);
+        else
+            v = _Slave(_reg[I2C_SLV4_ADDR], _reg[I2C_SLV4_REG],
+                       &_reg[I2C_SLV4_DO], 1);
+        _reg[I2C_MST_STATUS] |= SIM_MST_SLV4_DONE | (v ? 0 : SIM_MST_SLV4_NACK);
+    }
+}
+
+/**
+ * Bring simulated sensors up to current time: take all samples of MPU9250
+ * and measurements of AK8963 that are due
+ */
+static void _Update()
+{
+    uint64_t now = HAL_HOST_GetTimeUS();
+
+    if (!_powered)
+        return;
+
+    while (_magPeriod && (_nextMag <= now))
+    {
+        _nextMag += _magPeriod;
+        _AkMeasure();
+    }
+
+    if (!_Answers())
+        return;
+    while (_nextSample <= now)
+    {
+        _nextSample += 1000;
+        if (_divCount++ < _reg[SMPLRT_DIV])
+            continue;
+        _divCount = 0;
+        if (HAL_MPU_Sim.sampling && !(_reg[PWR_MGMT_1] & SIM_PWR_SLEEP))
+            _Sample();
+    }
+}
+
+/**
+ * Current address in DMP memory, given by bank and address registers
+ */
+static uint16_t _DmpAddr()
+{
+    return (((uint16_t)_reg[DMP_BANK] << 8) | _reg[DMP_RW_PNT])
+           % SIM_DMP_MEM_SIZE;
+}
+
+/**
+ * Read register of MPU9250, with side effects of reading it
+ */
+static uint8_t _Read(uint8_t reg)
+{
+    uint8_t v;
+
+    reg &= 0x7F;
+    switch (reg)
+    {
+    case INT_STATUS:
+        v = _reg[reg];
+        _reg[reg] = 0;
+        return v;
+    case I2C_MST_STATUS:
+        v = _reg[reg];
+        _reg[reg] &= 0x80;
+        return v;
+    case FIFO_COUNTH:
+        return _fifoLen >> 8;
+    case FIFO_COUNTL:
+        return _fifoLen & 0xFF;
+    case FIFO_R_W:
+        if (_fifoLen == 0)
+            return 0xFF;
+        v = _fifo[0];
+        memmove(_fifo, _fifo + 1, --_fifoLen);
+        return v;
+    case DMP_REG:
+        v = _dmpMem[_DmpAddr()];
+        _reg[DMP_RW_PNT]++;
+        return v;
+    default:
+        return _reg[reg];
+    }
+}
+
+/**
+ * Write register of MPU9250, with side effects of writing it. Read-only
+ * registers are left as they are.
+ */
+static void _Write(uint8_t reg, uint8_t data)
+{
+    uint16_t addr;
+
+    reg &= 0x7F;
+    switch (reg)
+    {
+    case PWR_MGMT_1:
+        if (data & SIM_PWR_RESET)
+            _Reset();
+        else
+            _reg[reg] = data;
+        break;
+    case USER_CTRL:
+        if (data & SIM_USER_FIFO_RST)
+            _fifoLen = 0;
+        _reg[reg] = data & ~SIM_USER_RESETS;
+        break;
+    case DMP_REG:
+        addr = _DmpAddr();
+        _dmpMem[addr] = (addr == HAL_MPU_Sim.dmpBadAddr) ? (data ^ 0x01) : data;
+        _reg[DMP_RW_PNT]++;
+        break;
+    case I2C_SLV4_DI:
+    case I2C_MST_STATUS:
+    case DMP_INT_STATUS:
+    case INT_STATUS:
+    case FIFO_COUNTH:
+    case FIFO_COUNTL:
+    case FIFO_R_W:
+    case WHO_AM_I_MPU9250:
+        break;
+    default:
+        if ((reg >= ACCEL_XOUT_H) && (reg <= EXT_SENS_DATA_23))
+            break;
+        _reg[reg] = data;
+        break;
+    }
+}
+
+/**
+ * Print bus transaction, up to 8 bytes of its data
+ */
+static void _Trace(uint8_t I2Caddress, uint8_t regAddress, uint16_t length,
+                   const uint8_t *data, bool write, uint8_t retVal)
+{
+    uint16_t i;
+
+    printf("%10.3fms %c %02X:%02X", HAL_HOST_GetTimeUS() / 1000.0,
+           write ? 'W' : 'R', I2Caddress, regAddress);
+    for (i = 0; (i < length) && (i < 8); i++)
+        printf(" %02X", data[i]);
+    if (length > 8)
+        printf(" ... (%u bytes)", length);
+    printf(retVal ? " NACK\n" : "\n");
+}
+
+/**
+ * Carry out bus transaction: takes bus time, brings sensors up to date and
+ * accesses the device at given address. With bypass enabled AK8963 answers on
+ * its own address.
+ * @param I2Caddress Address of device
+ * @param regAddress First register, FIFO and DMP memory are read/written
+ *        through a single register
+ * @param length Number of bytes
+ * @param data Bytes to write, or buffer for bytes read
+ * @param write True to write, false to read
+ * @return 0 on success, 1 if device didn't answer
+ */
+static uint8_t _Transfer(uint8_t I2Caddress, uint8_t regAddress,
+                         uint16_t length, uint8_t *data, bool write)
+{
+    uint16_t i;
+    uint8_t reg;
+    bool ak, anyRead = false;
+
+    HAL_MPU_Sim.transactions++;
+    HAL_MPU_Sim.bytes += length;
+    HAL_DelayUS((2 + length) * HAL_MPU_Sim.busByteUS);
+    _Update();
+
+    ak = (I2Caddress == AK8963_ADDRESS) && HAL_MPU_Sim.akPresent
+         && (_reg[INT_PIN_CFG] & SIM_PIN_BYPASS)
+         && !(_reg[USER_CTRL] & SIM_USER_MST_EN);
+    if (!_Answers() || (!ak && (I2Caddress != MPU9250_ADDRESS)))
+    {
+        if (!write)
+            memset(data, 0, length);
+        if (HAL_MPU_Sim.trace)
+            _Trace(I2Caddress, regAddress, length, data, write, 1);
+        return 1;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        reg = regAddress;
+        if ((regAddress != FIFO_R_W) && (regAddress != DMP_REG))
+            reg += i;
+
+        if (ak && write)
+            _AkWrite(reg, data[i]);
+        else if (ak)
+            data[i] = _AkRead(reg);
+        else if (write)
+            _Write(reg, data[i]);
+        else
+        {
+            data[i] = _Read(reg);
+            anyRead = true;
+        }
+    }
+
+    //  With any-read-to-clear, every read clears interrupt status
+    if (anyRead && (_reg[INT_PIN_CFG] & INT_PIN_CFG_ANYRD_2CLR))
+        _reg[INT_STATUS] = 0;
+
+    if (HAL_MPU_Sim.trace)
+        _Trace(I2Caddress, regAddress, length, data, write, 0);
+    return 0;
+}
+
+
+/**
+ * Nothing to set up, sensor is powered with HAL_MPU_PowerSwitch()
+ */
+void HAL_MPU_Init()
+{
+}
+
+/**
+ * Power sensor on or off. Powering on resets both MPU9250 and AK8963 and
+ * clears DMP memory
+ * @param powerState true to power the sensor on
+ */
+void HAL_MPU_PowerSwitch(bool powerState)
+{
+    if (powerState && !_powered)
+    {
+        _powered = true;
+        _Reset();
+        _AkReset();
+        //  DMP memory doesn't keep firmware without power
+        memset(_dmpMem, 0, sizeof(_dmpMem));
+    }
+    else if (!powerState)
+        _powered = false;
+}
+
+/**
+ * Check whether an enabled interrupt is pending (level of INT pin)
+ * @return true if an enabled interrupt is pending
+ */
+bool HAL_MPU_DataAvail()
+{
+    _Update();
+    return (_reg[INT_STATUS] & _reg[INT_ENABLE]) != 0;
+}
+
+/**
+ * Interrupts aren't raised by the simulator, poll HAL_MPU_DataAvail() instead
+ */
+void HAL_MPU_IntInit(void((*custHook)(void)))
+{
+    (void)custHook;
+}
+
+/**
+ * Interrupts aren't raised by the simulator
+ */
+void HAL_MPU_IntEnable(bool enable)
+{
+    (void)enable;
+}
+
+/**
+ * Interrupts aren't raised by the simulator
+ */
+void HAL_MPU_IntClear()
+{
+}
+
+/**
+ * Write one byte of data to I2C bus and wait until transmission is over
+ * @param I2Caddress 7-bit address of I2C device (8. bit is for R/W)
+ * @param regAddress address of register in I2C device to write into
+ * @param data data to write into the register of I2C device
+ */
+void HAL_MPU_WriteByte(uint8_t I2Caddress, uint8_t regAddress, uint8_t data)
+{
+    _Transfer(I2Caddress, regAddress, 1, &data, true);
+}
+
+/**
+ * Write multiple bytes of data to I2C bus
+ * @param I2Caddress 7-bit address of I2C device (8. bit is for R/W)
+ * @param regAddress address of register in I2C device to write into
+ * @param length number of bytes to write
+ * @param data pointer to data to write into the register of I2C device
+ * @return 0 on success, 1 if device didn't answer
+ */
+uint8_t HAL_MPU_WriteBytes(uint8_t I2Caddress, uint8_t regAddress,
+                           uint16_t length, uint8_t *data)
+{
+    return _Transfer(I2Caddress, regAddress, length, data, true);
+}
+
+/**
+ * Read one byte of data from I2C device
+ * @param I2Caddress 7-bit address of I2C device (8. bit is for R/W)
+ * @param regAddress address of register in I2C device to read from
+ * @return byte read from the register, 0 if device didn't answer
+ */
+uint8_t HAL_MPU_ReadByte(uint8_t I2Caddress, uint8_t regAddress)
+{
+    uint8_t data;
+
+    _Transfer(I2Caddress, regAddress, 1, &data, false);
+    return data;
+}
+
+/**
+ * Read multiple bytes from I2C device
+ * @param I2Caddress 7-bit address of I2C device (8. bit is for R/W)
+ * @param regAddress address of register in I2C device to read from
+ * @param length number of bytes to read
+ * @param data pointer to buffer to hold bytes read
+ * @return 0 on success, 1 if device didn't answer
+ */
+uint8_t HAL_MPU_ReadBytes(uint8_t I2Caddress, uint8_t regAddress,
+                          uint16_t length, uint8_t* data)
+{
+    return _Transfer(I2Caddress, regAddress, length, data, false);
+}
+
+/**
+ * Get register of simulated MPU9250, without side effects of reading it
+ * @param regAddress Address of register
+ * @return Value of register as of current simulated time
+ */
+uint8_t HAL_MPU_SimReg(uint8_t regAddress)
+{
+    _Update();
+    return _reg[regAddress & 0x7F];
+}
+
+/**
+ * Get register of simulated AK8963, without side effects of reading it
+ * @param regAddress Address of register
+ * @return Value of register as of current simulated time
+ */
+uint8_t HAL_MPU_SimAkReg(uint8_t regAddress)
+{
+    _Update();
+    return (regAddress <= AK8963_ASAZ) ? _ak[regAddress] : 0;
+}
+
+/**
+ * Get byte of DMP memory of simulated MPU9250
+ * @param memAddress Address in DMP memory (bank << 8 | address)
+ * @return Content of memory
+ */
+uint8_t HAL_MPU_SimDmpMem(uint16_t memAddress)
+{
+    return _dmpMem[memAddress % SIM_DMP_MEM_SIZE];
+}
+
+#endif  /* __HAL_USE_MPU9250__ && __BOARD_HOST__ */
@@ -0,0 +1,84 @@
+/**
+ * hal_mpu_host.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Stand-in for MPU9250 HAL of TM4C1294 when running on a PC: a simulated
+ *  MPU9250 with AK8963 behind it, so that initialization, calibration and DMP
+ *  firmware loading can be run and timed without the board. Interface is the
+ *  same as the one in tm4c1294/hal_mpu_tm4c.h, with HAL_MPU_Sim* added to set
+ *  up the simulated sensor and inspect its registers.
+ *
+ *  Simulated are: start-up and reset time (reads return 0 meanwhile), sampling
+ *  at 1kHz/(1 + SMPLRT_DIV) into data registers, INT_STATUS and FIFO (accel,
+ *  temperature, gyro), user offset registers, I2C master with slaves 0-4
+ *  carried out once per sample, bypass to AK8963, AK8963 measurements and DMP
+ *  memory. Divider counts internal 1kHz samples, so a lower one applies from
+ *  the next internal sample. Not simulated: DMP itself, FIFO data from slaves, DLPF (data is
+ *  constant anyway) and other internal sampling rates. Every bus transaction
+ *  takes (2 + length) * busByteUS of simulated time (hal_common_host.h).
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_HAL_HOST_HAL_MPU_HOST_H_) && defined(__HAL_USE_MPU9250__) \
+    && defined(__BOARD_HOST__)
+#define ROVERKERNEL_HAL_HOST_HAL_MPU_HOST_H_
+
+//  Simulated sensor, fields can be changed at any time
+typedef struct
+{
+    bool     present;       //  MPU9250 answers on the bus
+    bool     sampling;      //  MPU9250 produces samples when not sleeping
+    bool     akPresent;     //  AK8963 answers on auxiliary I2C bus
+    uint32_t startUS;       //  Start-up time after power-on or device reset
+    uint32_t busByteUS;     //  Bus time per byte (8 for 1MHz SPI)
+    int32_t  dmpBadAddr;    //  DMP memory address with a stuck bit, -1 if none
+    int16_t  accel[3];      //  Raw readings at full scale ranges of +-2g,
+    int16_t  gyro[3];       //  +-250dps, and offset registers as after reset
+    int16_t  mag[3];        //  Raw AK8963 reading, 16-bit
+    bool     trace;         //  Print every bus transaction
+    //  Statistics, can be cleared by caller
+    uint32_t transactions;  //  Bus transactions
+    uint32_t bytes;         //  Data bytes transferred
+    uint32_t samples;       //  Samples taken by MPU9250
+} HalMpuSim;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**     MPU9250 - related HW API       */
+    extern void     HAL_MPU_Init();
+    extern void     HAL_MPU_PowerSwitch(bool powerState);
+    extern bool     HAL_MPU_DataAvail();
+    extern void     HAL_MPU_IntInit(void((*custHook)(void)));
+    extern void     HAL_MPU_IntEnable(bool enable);
+    extern void     HAL_MPU_IntClear();
+
+    extern void     HAL_MPU_WriteByte(uint8_t I2Caddress, uint8_t regAddress,
+                                      uint8_t data);
+    extern uint8_t  HAL_MPU_WriteBytes(uint8_t I2Caddress, uint8_t regAddress,
+                                       uint16_t length, uint8_t *data);
+
+    extern uint8_t  HAL_MPU_ReadByte(uint8_t I2Caddress, uint8_t regAddress);
+    extern uint8_t  HAL_MPU_ReadBytes(uint8_t I2Caddress, uint8_t regAddress,
+                                      uint16_t length, uint8_t* data);
+
+/**     Simulated sensor       */
+    extern HalMpuSim HAL_MPU_Sim;
+    extern uint8_t  HAL_MPU_SimReg(uint8_t regAddress);
+    extern uint8_t  HAL_MPU_SimAkReg(uint8_t regAddress);
+    extern uint8_t  HAL_MPU_SimDmpMem(uint16_t memAddress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROVERKERNEL_HAL_HOST_HAL_MPU_HOST_H_ */
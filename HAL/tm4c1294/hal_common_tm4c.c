@@ -12,6 +12,7 @@
 #include "inc/hw_timer.h"
 #include "inc/hw_ints.h"
 #include "inc/hw_gpio.h"
+#include "inc/hw_nvic.h"
 
 #include "driverlib/rom_map.h"
 #include "driverlib/rom.h"
@@ -21,10 +22,15 @@
 #include "driverlib/fpu.h"
 #include "driverlib/interrupt.h"
 #include "driverlib/pwm.h"
+#include "driverlib/systick.h"
+#include "driverlib/eeprom.h"
 
 
 uint32_t g_ui32SysClock;
 
+//  Milliseconds since SysTick timer was started, incremented in SysTick ISR
+static volatile uint32_t _msSinceStartup = 0;
+
 /**
  *  Dummy function to be called to suppress "Unused variable" warnings
  */
@@ -45,6 +51,8 @@ void HAL_BOARD_CLOCK_Init()
     MAP_FPUStackingEnable();
     //  Enable interrupt handler
     MAP_IntMasterEnable();
+    //  Start time base used for timestamps and timeouts
+    HAL_TS_InitSysTick();
 }
 
 /**
@@ -67,6 +75,60 @@ void HAL_DelayUS(uint32_t us)   //1000
     MAP_SysCtlDelay((uint32_t)f);
 }
 
+/**
+ * SysTick interrupt handler, counts milliseconds since startup
+ */
+static void _HAL_TS_SysTickIntHandler()
+{
+    _msSinceStartup++;
+}
+
+/**
+ * Configure SysTick timer to interrupt every 1ms, providing time base for
+ * timestamps and non-blocking timeouts
+ */
+void HAL_TS_InitSysTick()
+{
+    MAP_SysTickPeriodSet(g_ui32SysClock / 1000);
+    SysTickIntRegister(_HAL_TS_SysTickIntHandler);
+    MAP_SysTickIntEnable();
+    MAP_SysTickEnable();
+}
+
+/**
+ * Get time since SysTick timer was started
+ * @return Time in milliseconds (wraps around after ~49 days)
+ */
+uint32_t HAL_TS_GetTimeMS()
+{
+    return _msSinceStartup;
+}
+
+/**
+ * Get time since SysTick timer was started, with microsecond resolution
+ * @return Time in microseconds (wraps around after ~71 minutes)
+ */
+uint32_t HAL_TS_GetTimeUS()
+{
+    uint32_t ms, ticks, period = g_ui32SysClock / 1000;
+
+    //  SysTick counts down from period to 0, re-read if ms counter changed
+    //  while reading the timer
+    do
+    {
+        ms = _msSinceStartup;
+        ticks = period - MAP_SysTickValueGet();
+        //  When called from an interrupt SysTick can't preempt, timer might
+        //  have wrapped without its interrupt being served yet
+        if ((HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_PENDSTSET)
+            && (ticks < (period >> 1)))
+            ticks += period;
+    }
+    while (ms != _msSinceStartup);
+
+    return ms*1000 + ticks / (g_ui32SysClock / 1000000);
+}
+
 /**
  * Calculate load value from timer based on desired time in milliseconds
  * @param ms time in milliseconds
@@ -96,4 +158,54 @@ uint32_t HAL_GetPWM(uint32_t id)
     return MAP_PWMPulseWidthGet(PWM0_BASE, id);
 }
 
+/**
+ * Initialize on-chip EEPROM, has to be called before reading or writing it
+ * Recovers EEPROM from a write interrupted by reset or power loss.
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if EEPROM isn't usable
+ */
+uint8_t HAL_EEPROM_Init()
+{
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while (!MAP_SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0));
+
+    if (MAP_EEPROMInit() != EEPROM_INIT_OK)
+        return HAL_EEPROM_ERROR;
 
+    return HAL_OK;
+}
+
+/**
+ * Read block of data from on-chip EEPROM
+ * @param addr Byte address in EEPROM, multiple of 4
+ * @param data Buffer to hold data
+ * @param len Length of data in bytes, multiple of 4
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if block is outside of EEPROM
+ */
+uint8_t HAL_EEPROM_Read(uint32_t addr, uint32_t *data, uint32_t len)
+{
+    if ((addr + len) > MAP_EEPROMSizeGet())
+        return HAL_EEPROM_ERROR;
+
+    MAP_EEPROMRead(data, addr, len);
+
+    return HAL_OK;
+}
+
+/**
+ * Write block of data into on-chip EEPROM, blocks until it's written
+ * @param addr Byte address in EEPROM, multiple of 4
+ * @param data Data to write
+ * @param len Length of data in bytes, multiple of 4
+ * @return HAL_OK on success, HAL_EEPROM_ERROR if block is outside of EEPROM
+ *         or write failed
+ */
+uint8_t HAL_EEPROM_Write(uint32_t addr, const uint32_t *data, uint32_t len)
+{
+    if ((addr + len) > MAP_EEPROMSizeGet())
+        return HAL_EEPROM_ERROR;
+
+    if (MAP_EEPROMProgram((uint32_t*)data, addr, len) != 0)
+        return HAL_EEPROM_ERROR;
+
+    return HAL_OK;
+}
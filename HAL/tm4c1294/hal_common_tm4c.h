@@ -10,6 +10,7 @@
 #define ROVERKERNEL_HAL_TM4C1294_HAL_COMMON_TM4C_H_
 
 #define HAL_OK                  0
+#define HAL_EEPROM_ERROR        1
 
 #ifdef __cplusplus
 extern "C"
@@ -21,6 +22,9 @@ extern uint32_t g_ui32SysClock;
 
 
 extern void         HAL_DelayUS(uint32_t us);
+extern void         HAL_TS_InitSysTick();
+extern uint32_t     HAL_TS_GetTimeMS();
+extern uint32_t     HAL_TS_GetTimeUS();
 extern void         HAL_BOARD_CLOCK_Init();
 extern void         HAL_BOARD_Reset();
 extern void         UNUSED (int32_t arg);
@@ -29,6 +33,12 @@ extern uint32_t     _TM4CMsToCycles(uint32_t ms);
 extern void         HAL_SetPWM(uint32_t id, uint32_t pwm);
 extern uint32_t     HAL_GetPWM(uint32_t id);
 
+extern uint8_t      HAL_EEPROM_Init();
+extern uint8_t      HAL_EEPROM_Read(uint32_t addr, uint32_t *data,
+                                    uint32_t len);
+extern uint8_t      HAL_EEPROM_Write(uint32_t addr, const uint32_t *data,
+                                     uint32_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -74,8 +74,8 @@ void HAL_MPU_Init(void((*custHook)(void)))
     MAP_GPIOPinTypeGPIOOutput(GPIO_PORTL_BASE, GPIO_PIN_4);
     MAP_GPIOPinWrite(GPIO_PORTL_BASE, GPIO_PIN_4, 0x00);
 
-    //  Configure input pin to receive interrupts from MPU
-    //      (not used as actual interrupt)
+    //  Configure input pin to receive interrupts from MPU (interrupts are
+    //      enabled separately, through HAL_MPU_IntInit/HAL_MPU_IntEnable)
     MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
     MAP_GPIOPinTypeGPIOInput(GPIO_PORTA_BASE, GPIO_PIN_5);
     MAP_GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_5, 0x00);
@@ -107,6 +107,51 @@ bool HAL_MPU_DataAvail()
     return (MAP_GPIOPinRead(GPIO_PORTA_BASE, GPIO_PIN_5) != 0);
 }
 
+/**
+ * Register handler for data-ready interrupt on PA5
+ * Interrupt is triggered on rising edge, MPU has to be configured to drive its
+ * INT pin active high. Interrupt stays disabled until HAL_MPU_IntEnable(true)
+ * @param custHook Function to call on interrupt, has to call HAL_MPU_IntClear
+ */
+void HAL_MPU_IntInit(void((*custHook)(void)))
+{
+    MAP_GPIOIntDisable(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+    MAP_GPIOIntTypeSet(GPIO_PORTA_BASE, GPIO_PIN_5, GPIO_RISING_EDGE);
+    GPIOIntRegister(GPIO_PORTA_BASE, custHook);
+    MAP_GPIOIntClear(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+}
+
+/**
+ * Enable or disable data-ready interrupt on PA5
+ * Stale interrupt flag is cleared before enabling it. If INT pin is already
+ * high (data became ready while interrupt was disabled, and latched pin won't
+ * make another edge until the data is read), handler is run right away.
+ * @param enable Desired state of interrupt
+ */
+void HAL_MPU_IntEnable(bool enable)
+{
+    if (enable)
+    {
+        MAP_GPIOIntClear(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+        MAP_GPIOIntEnable(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+        MAP_IntEnable(INT_GPIOA);
+        //  Edge after clearing the flag pends the interrupt by itself, both
+        //  cases end up in a single call of the handler
+        if (HAL_MPU_DataAvail())
+            MAP_IntPendSet(INT_GPIOA);
+    }
+    else
+        MAP_GPIOIntDisable(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+}
+
+/**
+ * Clear data-ready interrupt flag, call from interrupt handler
+ */
+void HAL_MPU_IntClear()
+{
+    MAP_GPIOIntClear(GPIO_PORTA_BASE, GPIO_INT_PIN_5);
+}
+
 /**
  * Write one byte of data to SPI bus and wait until transmission is over (blocking)
  * @param I2Caddress (NOT USED) Here for compatibility with I2C HAL implementation
@@ -11,7 +11,7 @@
  *  Hardware dependencies:
  *    * Check hwconfig to find out whether HAL uses I2C2(PN4 as SDA and PN5 as
  *      SCL) or SPI2(PD0 as MISO, PD1 as MOSI, PD3 as SCLK, PN2 as CS)
- *    * GPIO PA5 - Data available interrupt pin (normal input, not interrupt pin)
+ *    * GPIO PA5 - Data available interrupt pin (input, can trigger interrupt)
  *    * GPIO PL4 - Power switch for MPU (active high)
  */
 #include "hwconfig.h"
@@ -29,6 +29,9 @@ extern "C"
     extern void     HAL_MPU_Init();
     extern void     HAL_MPU_PowerSwitch(bool powerState);
     extern bool     HAL_MPU_DataAvail();
+    extern void     HAL_MPU_IntInit(void((*custHook)(void)));
+    extern void     HAL_MPU_IntEnable(bool enable);
+    extern void     HAL_MPU_IntClear();
 
     extern void     HAL_MPU_WriteByte(uint8_t I2Caddress, uint8_t regAddress,
                                       uint8_t data);
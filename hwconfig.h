@@ -15,8 +15,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-//  Define platform in use in hal.h
+//  Define platform in use in hal.h. Building with -D__BOARD_HOST__ selects
+//  stand-ins for running the libraries on a PC instead (tools/mpuSim)
+#ifndef __BOARD_HOST__
 #define __BOARD_TM4C1294NCPDT__
+#endif
 
 /*
  * Compile all libraries in debug mode, allowing them to print debug data to
@@ -43,6 +46,29 @@
     //  Operating mode can be with raw sensor values or using DMP firmware
     #define __HAL_USE_MPU9250_NODMP__
     //#define __HAL_USE_MPU9250_DMP__
+
+    //  Sensor configuration when reading raw sensor values (NODMP). Full-scale
+    //  ranges use values from enums in mpu9250/registerMap.h. Mounting tells
+    //  which sensor axis (AXIS_* in mpu9250/sensorAxes.h) is taken as body
+    //  x, y and z axis. AK8963 axes differ from those of accel/gyro: its x is
+    //  accel y, its y is accel x and its z points the opposite way.
+    //  Magnetometer mounting is also used in DMP mode, relative to the IMU one
+    #define MPU_ACCEL_SCALE     AFS_2G
+    #define MPU_GYRO_SCALE      GFS_250DPS
+    #define MPU_MAG_SCALE       MFS_16BITS
+    #define MPU_MOUNT_IMU       AXIS_PX, AXIS_PY, AXIS_PZ
+    #define MPU_MOUNT_MAG       AXIS_PY, AXIS_PX, AXIS_NZ
+    //  Sample rate divider, sensor is sampled at 1kHz/(1 + MPU_SAMPLE_DIV).
+    //  AHRS runs at this rate, consumers can get data at lower rates
+    #define MPU_SAMPLE_DIV      0
+    //  Address of calibration record in on-chip EEPROM (multiple of 4)
+    #define MPU_CAL_EEPROM_ADDR 0
+
+    //  Output rate of quaternions when using DMP firmware in Hz, max. 200
+    #define MPU_DMP_RATE        200
+    //  Address of record of loaded DMP image in on-chip EEPROM, used to verify
+    //  the image on warm start (multiple of 4, after calibration record)
+    #define MPU_DMP_EEPROM_ADDR 128
 #endif
 
 
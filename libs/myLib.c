@@ -195,3 +195,96 @@ void itoa (int32_t num, uint8_t *str)
     }
 }
 
+
+/**
+ * Compute CRC-16/CCITT (polynomial 0x1021) of a block of data
+ * Can be computed over several blocks by passing result of previous call as
+ * crc argument, start with 0xFFFF.
+ * @param crc Initial value or CRC of previous blocks
+ * @param data Block of data
+ * @param len Length of data block
+ * @return CRC of all data so far
+ */
+uint16_t crc16 (uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    uint8_t x;
+
+    //  Byte-wise computation, no lookup table needed
+    while (len--)
+    {
+        x = (crc >> 8) ^ *data++;
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+    }
+
+    return crc;
+}
+
+/**
+ * Encode block of data with Consistent Overhead Byte Stuffing (COBS)
+ * Encoded data contains no zero bytes, so zero can be used to delimit frames.
+ * Every zero is replaced by distance to the next one, cost is at most one byte
+ * per 254 bytes of data.
+ * @param src Data to encode
+ * @param len Length of data
+ * @param dst Buffer for encoded data, at least len + len/254 + 1 bytes long.
+ *        Delimiter isn't appended
+ * @return Length of encoded data
+ */
+uint16_t cobsEncode (const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+    uint16_t code = 0,  //  Position of code byte of current block
+             out = 1;   //  Position of next data byte
+    uint8_t n = 1;      //  Code of current block, 1 + number of data bytes
+
+    while (len--)
+    {
+        if (*src != 0)
+        {
+            dst[out++] = *src;
+            n++;
+        }
+        //  Zero (or full block) ends current block
+        if ((*src++ == 0) || (n == 0xFF))
+        {
+            dst[code] = n;
+            code = out++;
+            n = 1;
+        }
+    }
+    dst[code] = n;
+
+    return out;
+}
+
+/**
+ * Decode block of data encoded with cobsEncode(), without the delimiter
+ * @param src Encoded data
+ * @param len Length of encoded data
+ * @param dst Buffer for decoded data, at least len bytes long
+ * @return Length of decoded data, -1 if data isn't valid COBS
+ */
+int32_t cobsDecode (const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+    uint16_t in = 0, out = 0;
+    uint8_t code, i;
+
+    while (in < len)
+    {
+        code = src[in++];
+        if ((code == 0) || ((in + code - 1) > len))
+            return -1;
+
+        for (i = 1; i < code; i++)
+        {
+            if (src[in] == 0)
+                return -1;
+            dst[out++] = src[in++];
+        }
+        //  Block shorter than max. ends with a zero, except the last one
+        if ((code < 0xFF) && (in < len))
+            dst[out++] = 0;
+    }
+
+    return out;
+}
@@ -40,6 +40,13 @@ int32_t stoiv (volatile uint8_t *nums, volatile uint8_t strLen);
 /*      Functions to convert number to string           */
 void    itoa (int32_t num, uint8_t *str);
 
+/*      Checksums                                       */
+uint16_t crc16 (uint16_t crc, const uint8_t *data, uint16_t len);
+
+/*      Framing of binary data                          */
+uint16_t cobsEncode (const uint8_t *src, uint16_t len, uint8_t *dst);
+int32_t  cobsDecode (const uint8_t *src, uint16_t len, uint8_t *dst);
+
 #ifdef __cplusplus
 }
 #endif
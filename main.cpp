@@ -2,6 +2,113 @@
 #include "libs/myLib.h"
 #include "mpu9250/mpu9250.h"
 #include "serialPort/uartHW.h"
+#include "serialPort/telemetry.h"
+#include "serialPort/command.h"
+
+//  Fields of commands are little-endian (serialPort/tlmProtocol.h)
+#define GET16(p)    ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET32(p)    ((uint32_t)GET16(p) | ((uint32_t)GET16((p) + 2) << 16))
+
+#ifdef __HAL_USE_MPU9250_NODMP__
+//  Set while calibration started by host is running, main loop drives it
+static bool calibrating = false;
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
+
+
+/*
+ * Handlers of commands from host, results of MPU9250 methods (MPU_*) are
+ * the same as command results (CMD_RES_*)
+ */
+//  Output data rate, outputs and raw samples (packed orientation and status
+//  with DMP) are kept at their rates, as they're set in samples. Records
+//  subscribed by host at other rates have to be subscribed again
+static uint8_t CmdSetODR(const uint8_t *p, uint8_t len)
+{
+    uint16_t rate;
+    int8_t retVal;
+
+    if (len != CMD_LEN_ODR)
+        return CMD_RES_ERROR;
+    rate = GET16(p);
+
+#ifdef __HAL_USE_MPU9250_NODMP__
+    const uint16_t div = (rate >= 20) ? rate / 10 : 1;
+
+    retVal = MPU9250::GetI().SetSampleRate(rate);
+    if (retVal == MPU_SUCCESS)
+        retVal = MPU9250::GetI().SetupOutput(0, div, DEC_AVERAGE);
+    if (retVal == MPU_SUCCESS)
+        Telemetry::GetI().Subscribe(TLM_REC_RAW, div);
+#else
+    retVal = MPU9250::GetI().SetDMPRate(rate);
+    if (retVal == MPU_SUCCESS)
+    {
+        Telemetry& tlm = Telemetry::GetI();
+
+        tlm.Subscribe(TLM_REC_QUATP, (rate >= 20) ? rate / 10 : 1);
+        tlm.Subscribe(TLM_REC_STATUS, rate);
+    }
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
+
+    return (uint8_t)retVal;
+}
+
+//  Bandwidth of low-pass filter in the sensor
+static uint8_t CmdSetDLPF(const uint8_t *p, uint8_t len)
+{
+    if (len != CMD_LEN_DLPF)
+        return CMD_RES_ERROR;
+
+    return (uint8_t)MPU9250::GetI().SetDLPF(p[0]);
+}
+
+#ifdef __HAL_USE_MPU9250_NODMP__
+//  Gains of AHRS, time step stays as it is
+static uint8_t CmdSetAHRS(const uint8_t *p, uint8_t len)
+{
+    uint32_t u[2];
+    float k[2];
+
+    if (len != CMD_LEN_AHRS)
+        return CMD_RES_ERROR;
+    u[0] = GET32(p);
+    u[1] = GET32(p + 4);
+    memcpy((void*)k, (void*)u, sizeof(k));
+    //  Also false for NaN
+    if (!((k[0] >= 0.0f) && (k[1] >= 0.0f)))
+        return CMD_RES_ERROR;
+
+    return (uint8_t)MPU9250::GetI().SetupAHRS(0.0f, k[0], k[1]);
+}
+
+//  Calibration of accel/gyro, stored in EEPROM once done
+static uint8_t CmdCalibrate(const uint8_t *p, uint8_t len)
+{
+    uint16_t samples;
+
+    if (len != CMD_LEN_CALIBRATE)
+        return CMD_RES_ERROR;
+    samples = GET16(p);
+    if (samples == 0)
+        return CMD_RES_ERROR;
+    if (calibrating)
+        return CMD_RES_BUSY;
+
+    calibrating = true;
+    return (uint8_t)MPU9250::GetI().StartCalibration(samples);
+}
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
+
+//  Subscription to a telemetry record
+static uint8_t CmdSubscribe(const uint8_t *p, uint8_t len)
+{
+    if (len != CMD_LEN_SUBSCRIBE)
+        return CMD_RES_ERROR;
+
+    if (Telemetry::GetI().Subscribe(p[0], GET16(p + 1)) != STATUS_OK)
+        return CMD_RES_ERROR;
+    return CMD_RES_OK;
+}
 
 
 /**
@@ -10,6 +117,7 @@
 int main(void)
 {
     MPU9250& mpu = MPU9250::GetI();
+    Telemetry& tlm = Telemetry::GetI();
 
     //  Initialize board and FPU
     HAL_BOARD_CLOCK_Init();
@@ -18,54 +126,135 @@ int main(void)
     SerialPort::GetI().InitHW();
     DEBUG_WRITE("Initialized Uart... \n");
 
+    //  Settings which can be changed from host at runtime
+    CmdChannel& cmd = CmdChannel::GetI();
+    cmd.Register(CMD_SET_ODR, CmdSetODR);
+    cmd.Register(CMD_SET_DLPF, CmdSetDLPF);
+#ifdef __HAL_USE_MPU9250_NODMP__
+    cmd.Register(CMD_SET_AHRS, CmdSetAHRS);
+    cmd.Register(CMD_CALIBRATE, CmdCalibrate);
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
+    cmd.Register(CMD_SUBSCRIBE, CmdSubscribe);
+
     //  Initialize hardware used by MPU9250
     mpu.InitHW();
 
     //  Software initialization of MPU9250
     //  Either configure registers for direct sensor readings or load DMP
     //  firmware
-    mpu.InitSW();
+#ifdef __HAL_USE_MPU9250_DMP__
+    //  If only the MCU was restarted MPU still runs the DMP firmware, keep it
+    //  instead of power-cycling the MPU and loading it again
+    if (mpu.WarmStart() == MPU_SUCCESS)
+        DEBUG_WRITE("MPU warm start in %d us\n", mpu.BootTime());
+    else
+#endif  /* __HAL_USE_MPU9250_DMP__ */
+    if (mpu.InitSW() != MPU_SUCCESS)
+        DEBUG_WRITE("MPU initialization failed\n");
+    else
+        DEBUG_WRITE("MPU ready in %d us\n", mpu.BootTime());
 
 #ifdef __HAL_USE_MPU9250_NODMP__
-    //  Set AHRS time step to 1kHz and configure gains
-    // Settings in mpu.InitSW(); are using 200MHz data sampling rate
-    mpu.SetupAHRS(0.005, 0.5, 0.00);
+    //  Restore calibration saved when the last one completed (started from
+    //  host with CMD_CALIBRATE, e.g. tlmCmd cal 1000)
+    if (mpu.LoadCalibration() != MPU_SUCCESS)
+        DEBUG_WRITE("No stored calibration\n");
+    //  Set AHRS time step to sensor sampling time and configure gains
+    //  (1kHz with default MPU_SAMPLE_DIV in hwconfig.h)
+    mpu.SetupAHRS((1 + MPU_SAMPLE_DIV) / 1000.0f, 0.5, 0.00);
+    //  Serial port only needs orientation at 10Hz, averaged over the period
+    mpu.SetupOutput(0, 1000 / (1 + MPU_SAMPLE_DIV) / 10, DEC_AVERAGE);
+    //  Raw samples at 10Hz, packed orientation with every output, status once
+    //  a second (host can change these with CMD_SUBSCRIBE). Compressed stream
+    //  of raw samples is off, at full rate it takes most of the link
+    tlm.Subscribe(TLM_REC_RAW, 1000 / (1 + MPU_SAMPLE_DIV) / 10);
+    tlm.Subscribe(TLM_REC_STATUS, 10);
+    tlm.Subscribe(TLM_REC_RAWZ, 0);
+    tlm.Subscribe(TLM_REC_QUAT, 0);
+    MPUOutput out;
+    int16_t raw[9];
 #endif  /* __HAL_USE_MPU9250_NODMP__ */
 
-    float rpy[3];
-    uint32_t counter = 0;
+#ifdef __HAL_USE_MPU9250_DMP__
+    //  Correct drifting DMP yaw with magnetometer, 2s time constant
+    mpu.SetupMagYaw(2.0f);
+    //  DMP output is read from data-ready interrupt, as soon as it's produced
+    mpu.InterruptMode(true);
+    //  Orientation is sent packed at 10Hz, full quaternion only when host
+    //  asks for it, status once a second (subscriptions count quaternions)
+    tlm.Subscribe(TLM_REC_QUAT, 0);
+    tlm.Subscribe(TLM_REC_QUATP, MPU_DMP_RATE / 10);
+    tlm.Subscribe(TLM_REC_STATUS, MPU_DMP_RATE);
+    MPUStats stats;
+    float q[4];
+    uint32_t seq, lastSeq = 0;
+#endif  /* __HAL_USE_MPU9250_DMP__ */
     while (1)
     {
+#ifdef __HAL_USE_MPU9250_NODMP__
+        //  Calibration reads the sensor itself, and saves the result when done
+        if (calibrating)
+        {
+            if (mpu.CalibrationStep() != MPU_BUSY)
+                calibrating = false;
+        }
         //  Check if MPU toggled interrupt pin
         //  (this example doesn't use actual interrupts, but polling)
-        if (HAL_MPU_DataAvail())
+        else if (HAL_MPU_DataAvail())
         {
 
             //  Read sensor data
             mpu.ReadSensorData();
-            //  Get RPY values
-            mpu.RPY(rpy, true);
+            mpu.RawData(raw, raw + 3, raw + 6);
+            if (tlm.Due(TLM_REC_RAW))
+                tlm.SendRaw(raw, raw + 3, raw + 6);
+            if (tlm.Due(TLM_REC_RAWZ))
+                tlm.PushRaw(raw, raw + 3, raw + 6);
         }
+        //  Refit magnetometer calibration when enough new samples came in
+        mpu.MagCalStep();
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
 
         // INT pin can be held up for max 50us, so delay here to prevent reading the same data twice
         HAL_DelayUS(100);
 
-        if (counter++ > 1000)
+#ifdef __HAL_USE_MPU9250_NODMP__
+        //  Send orientation and status as binary telemetry (see
+        //  serialPort/tlmProtocol.h) when a new output is published, at rates
+        //  set by subscriptions
+        if (mpu.GetOutput(0, &out) == MPU_SUCCESS)
         {
-            // Every 1000 * 100us print out data to prevent spamming uart
-
-            //  Print out sensor measurements
-//            DEBUG_WRITE("{%02d.%03d, %02d.%03d, %02d.%03d, ", _FTOI_(__mpu._gyro[0]), _FTOI_(__mpu._gyro[1]), _FTOI_(__mpu._gyro[2]));
-//            DEBUG_WRITE("%02d.%03d, %02d.%03d, %02d.%03d, ", _FTOI_(__mpu._acc[0]), _FTOI_(__mpu._acc[1]), _FTOI_(__mpu._acc[2]));
-//            DEBUG_WRITE("%02d.%03d, %02d.%03d, %02d.%03d},\n", _FTOI_(__mpu._mag[0]), _FTOI_(__mpu._mag[1]), _FTOI_(__mpu._mag[2]));
-
-            //  Print out orientation
-            //  note: _FTOI_ is just a macro to print float numbers, it takes
-            //  a float a splits it in 2 integers that are printed separately
-
+            if (tlm.Due(TLM_REC_QUAT))
+                tlm.SendQuat(out.quat);
+            if (tlm.Due(TLM_REC_QUATP))
+                tlm.SendQuatPacked(out.quat);
+            if (tlm.Due(TLM_REC_STATUS))
+                tlm.SendStatus(out.seq, 0, (mpu.MagStatus() ? TLM_STATUS_MAG : 0));
+        }
+#else
+        //  Send orientation and status as binary telemetry (see
+        //  serialPort/tlmProtocol.h) when DMP produced a new quaternion, at
+        //  rates set by subscriptions
+        mpu.Quaternion(q, &seq);
+        if (seq != lastSeq)
+        {
+            lastSeq = seq;
+            if (tlm.Due(TLM_REC_QUAT))
+                tlm.SendQuat(q);
+            if (tlm.Due(TLM_REC_QUATP))
+                tlm.SendQuatPacked(q);
 
-            DEBUG_WRITE("%03d.%2d, %03d.%2d, %03d.%2d},\n", _FTOI_(rpy[0]), _FTOI_(rpy[1]), _FTOI_(rpy[2]));
-            counter = 0;
+            //  Check that DMP packets are read as fast as they're produced
+            if (tlm.Due(TLM_REC_STATUS))
+            {
+                mpu.Stats(&stats, false);
+                tlm.SendStatus(stats.packets, (uint16_t)stats.errors,
+                               TLM_STATUS_DMP | TLM_STATUS_MAG);
+            }
         }
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
+
+        //  Carry out commands received from host
+        cmd.Poll();
     }
 }
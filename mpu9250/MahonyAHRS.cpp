@@ -72,11 +72,6 @@ void Mahony::Update(float gx, float gy, float gz, float ax, float ay, float az,
 		return;
 	}
 
-	// Convert gyroscope degrees/sec to radians/sec
-	gx *= 0.0174533f;
-	gy *= 0.0174533f;
-	gz *= 0.0174533f;
-
 	// Compute feedback only if accelerometer measurement valid
 	// (avoids NaN in accelerometer normalisation)
 	if(!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f)))
@@ -168,8 +163,6 @@ void Mahony::Update(float gx, float gy, float gz, float ax, float ay, float az,
 	q1 *= recipNorm;
 	q2 *= recipNorm;
 	q3 *= recipNorm;
-
-	_ComputeAngles();
 }
 
 //------------------------------------------------------------------------------
@@ -182,11 +175,6 @@ void Mahony::UpdateNoMag(float gx, float gy, float gz, float ax, float ay, float
 	float halfex, halfey, halfez;
 	float qa, qb, qc;
 
-	// Convert gyroscope degrees/sec to radians/sec
-	gx *= 0.0174533f;
-	gy *= 0.0174533f;
-	gz *= 0.0174533f;
-
 	// Compute feedback only if accelerometer measurement valid
 	// (avoids NaN in accelerometer normalisation)
 	if(!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
@@ -247,8 +235,6 @@ void Mahony::UpdateNoMag(float gx, float gy, float gz, float ax, float ay, float
 	q1 *= recipNorm;
 	q2 *= recipNorm;
 	q3 *= recipNorm;
-
-	_ComputeAngles();
 }
 
 //------------------------------------------------------------------------------
@@ -269,24 +255,33 @@ float Mahony::_InvSqrt(float x)
 
 //------------------------------------------------------------------------------
 
-void Mahony::_ComputeAngles()
+void Mahony::ComputeAngles()
+{
+    const float q[4] = { q0, q1, q2, q3 };
+
+    QuatToYPR(q, ypr);
+}
+
+//------------------------------------------------------------------------------
+
+void Mahony::QuatToYPR(const float *q, float *ypr)
 {
     // roll (x-axis rotation)
-    float sinr = +2.0 * (q0 * q1 + q2 * q3);
-    float cosr = +1.0 - 2.0 * (q1 * q1 + q2 * q2);
-    ypr[2] = atan2(sinr, cosr);
+    float sinr = +2.0f * (q[0] * q[1] + q[2] * q[3]);
+    float cosr = +1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+    ypr[2] = atan2f(sinr, cosr);
 
     // pitch (y-axis rotation)
-    float sinp = +2.0 * (q0 * q2 - q3 * q1);
-    if (fabs(sinp) >= 1)
-        ypr[1] = copysign(3.14159265 / 2, sinp); // use 90 degrees if out of range
+    float sinp = +2.0f * (q[0] * q[2] - q[3] * q[1]);
+    if (fabsf(sinp) >= 1.0f)
+        ypr[1] = (sinp > 0.0f ? 3.14159265f : -3.14159265f) / 2; // use 90 degrees if out of range
     else
-        ypr[1] = asin(sinp);
+        ypr[1] = asinf(sinp);
 
     // yaw (z-axis rotation)
-    float siny = +2.0 * (q0 * q3 + q1 * q2);
-    float cosy = +1.0 - 2.0 * (q2 * q2 + q3 * q3);
-    ypr[0] = atan2(siny, cosy);
+    float siny = +2.0f * (q[0] * q[3] + q[1] * q[2]);
+    float cosy = +1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3]);
+    ypr[0] = atan2f(siny, cosy);
 }
 
 #endif /* __HAL_USE_MPU9250_NODMP__ */
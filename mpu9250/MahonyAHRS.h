@@ -25,12 +25,18 @@ class Mahony {
              Mahony();
         void InitSW(float sampleTime)
                 { _invSampleFreq = sampleTime; }
+        //  Gyroscope readings are expected in rad/s, accelerometer and
+        //  magnetometer in any (but consistent) units
         void Update(float gx, float gy, float gz, float ax, float ay, float az,
                     float mx, float my, float mz);
         void UpdateNoMag(float gx, float gy, float gz,
                          float ax, float ay, float az);
+        //  Euler angles are not updated with the quaternion, they're only
+        //  computed (into ypr) when asked for
+        void ComputeAngles();
+        static void QuatToYPR(const float *q, float *ypr);
 
-        //  Yaw-Pitch-Raw orientation in radians
+        //  Yaw-Pitch-Raw orientation in radians, see ComputeAngles()
         float ypr[3];
         // Quaternion of sensor frame relative to auxiliary frame
         float q0, q1, q2, q3;
@@ -40,8 +46,6 @@ class Mahony {
 
 
     private:
-        //  Convert quaternions to YPR
-        void            _ComputeAngles();
         static float    _InvSqrt(float x);
 
         float _integralFBx, _integralFBy, _integralFBz;  // integral error terms scaled by Ki
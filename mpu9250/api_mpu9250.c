@@ -9,137 +9,365 @@
 #if defined(__HAL_USE_MPU9250_NODMP__)       //  Compile only if module is enabled
 
 #include "registerMap.h"
+#include "fifoConvert.h"
 #include "HAL/hal.h"
 #include "libs/myLib.h"
 
 //  Local (to this file) variables for holding configuration data
-//  Values are defined as enums in "registerMap.h"
-uint8_t Gscale = GFS_250DPS;
-uint8_t Ascale = AFS_2G;
-uint8_t Mscale = MFS_16BITS;
+//  Values are defined as enums in "registerMap.h", selected in hwconfig.h
+uint8_t Gscale = MPU_GYRO_SCALE;
+uint8_t Ascale = MPU_ACCEL_SCALE;
+uint8_t Mscale = MPU_MAG_SCALE;
 uint8_t Mmode = M_100HZ;
 
+//  States of non-blocking accel/gyro calibration
+#define CAL_S_IDLE          0
+#define CAL_S_RESET         1
+#define CAL_S_CLOCK         2
+#define CAL_S_CONFIG        3
+#define CAL_S_FIFO_START    4
+#define CAL_S_ACCUMULATE    5
+#define CAL_S_FINISH        6
+#define CAL_S_WAIT          7
+
+//  Progress of non-blocking accel/gyro calibration
+static struct
+{
+    uint8_t  state;
+    //  Pending wait: state to continue in, start and length of wait
+    uint8_t  nextState;
+    uint32_t waitStart;
+    uint32_t waitMs;
+    //  Number of samples to average and number of samples accumulated so far
+    uint16_t target;
+    uint16_t samples;
+    //  Accumulated raw readings, accel in [0..2], gyro in [3..5]
+    int64_t  bias[6];
+} _cal;
+
+//  Buffer for draining whole FIFO (512B) in one burst, 42 packets of 12 bytes
+#define CAL_FIFO_PACKETS    42
+static uint8_t _calFifo[CAL_FIFO_PACKETS * FIFO_PACKET_SIZE];
+//  Burst converted per channel, in raw units (unit scale, no bias), so that
+//  sums are exact: 42 int16 values fit into float mantissa
+static FifoConvCoef _calCoef;
+static float _calConv[FIFO_CHANNELS][CAL_FIFO_PACKETS];
+static float * const _calConvOut[FIFO_CHANNELS] =
+{
+    _calConv[0], _calConv[1], _calConv[2], _calConv[3], _calConv[4],
+    _calConv[5]
+};
+
+//  Operations of initialization sequence
+#define INIT_OP_END         0   //  End of table
+#define INIT_OP_WRITE       1   //  Write value into register
+#define INIT_OP_FIELD       2   //  Set field (mask) to value in shadow only
+#define INIT_OP_BURST       3   //  Write value registers from shadow at once
+#define INIT_OP_POLL        4   //  Wait until masked register equals value
+#define INIT_OP_CHECK       5   //  Masked register has to equal value
+#define INIT_OP_DELAY       6   //  Wait for timeout ms
+#define INIT_OP_FILTER      7   //  Set DLPF fields in shadow to runtime
+                                //  setting (setFilterMPU9250()), rate divider
+                                //  to full rate until initialization is over
+
+//  Bus transactions each operation takes (polls when chip is already ready)
+#define INIT_BUS_END        0
+#define INIT_BUS_WRITE      1
+#define INIT_BUS_FIELD      0
+#define INIT_BUS_BURST      1
+#define INIT_BUS_POLL       1
+#define INIT_BUS_CHECK      1
+#define INIT_BUS_DELAY      0
+#define INIT_BUS_FILTER     0
+
+//  Configuration registers are composed in a shadow copy field by field, and
+//  written in bursts. Bits not covered by any field are written with their
+//  reset value (0 for all registers in shadow), so registers never have to be
+//  read back for a read-modify-write
+#define SHADOW_FIRST        SMPLRT_DIV
+#define SHADOW_LAST         INT_ENABLE
+
+//  Single step of initialization sequence. If a poll doesn't match within
+//  timeout (ms) or check fails, sequence stops and returns error
+typedef struct
+{
+    uint8_t op;
+    uint8_t reg;
+    uint8_t mask;
+    uint8_t value;
+    uint8_t timeout;
+    uint8_t error;
+} InitStep;
+
+//  Tables are given as lists of S(op, reg, mask, value, timeout, error) so
+//  that their properties can be checked at compile time:
+//  INIT_TABLE turns list into an array of InitStep, INIT_BUS counts bus
+//  transactions and INIT_SHADOW_ERR counts shadow accesses outside of shadow
+#define INIT_STEP(op, reg, mask, value, timeout, error) \
+    { INIT_OP_##op, reg, mask, value, timeout, error },
+#define INIT_TABLE(name, list) \
+    static const InitStep name[] = { list(INIT_STEP) INIT_STEP(END,0,0,0,0,0) }
+#define INIT_BUS(op, reg, mask, value, timeout, error) \
+    + INIT_BUS_##op
+#define INIT_SHADOW_ERR(op, reg, mask, value, timeout, error) \
+    + (((INIT_OP_##op == INIT_OP_FIELD) || (INIT_OP_##op == INIT_OP_BURST)) \
+       && (((reg) < SHADOW_FIRST) || ((reg) + ((INIT_OP_##op == INIT_OP_BURST) \
+                                   ? (value) - 1 : 0) > SHADOW_LAST)))
+//  Compilation fails if condition is false
+#define INIT_ASSERT(name, cond) typedef char name[(cond) ? 1 : -1]
+
+//  Reset all registers, wait for reset bit (7) to self-clear. ID is checked
+//  too, as reads during reset can return all zeros
+#define INIT_RESET(S) \
+    S(WRITE, PWR_MGMT_1,       0xFF, 0x80, 0, INIT_OK) \
+    S(POLL,  PWR_MGMT_1,       0x80, 0x00, INIT_TIMEOUT_ID, INIT_NO_DEVICE) \
+    S(POLL,  WHO_AM_I_MPU9250, 0xFF, 0x71, INIT_TIMEOUT_ID, INIT_NO_DEVICE)
+
+//  Configure accelerometer and gyroscope: 1kHz sampling rate, bandwidth and
+//  output rate set with setFilterMPU9250() (41/42 Hz and MPU_SAMPLE_DIV by
+//  default) and full scale ranges set in hwconfig.h. Output rate is kept at
+//  1kHz until the last table of initialization is done, as polls here and in
+//  _initAK wait for samples and their timeouts hold for 1kHz only; rate
+//  divider is then written in one burst with the DLPF. Interrupt pin is active
+//  high, push-pull, held high until cleared by reading ANY register, only
+//  data-ready interrupt is enabled. I2C bypass is disabled to allow for SPI.
+//  Clock source is auto selected to be PLL gyroscope reference if ready else
+//  internal oscillator; sleep bit (6) cleared, all sensors enabled. MPU has no
+//  PLL-lock flag, the first sample with the new configuration shows gyro runs
+#define INIT_MPU(S) \
+    S(POLL,  WHO_AM_I_MPU9250, 0xFF, 0x71, INIT_TIMEOUT_ID, INIT_NO_DEVICE) \
+    S(WRITE, PWR_MGMT_1,       0xFF, 0x01, 0, INIT_OK) \
+    S(FIELD, GYRO_CONFIG,      GYRO_CONFIG_FS_SEL, \
+          FIELD_VAL(GYRO_CONFIG_FS_SEL, MPU_GYRO_SCALE), 0, INIT_OK) \
+    S(FIELD, GYRO_CONFIG,      GYRO_CONFIG_FCHOICE_B, 0x00, 0, INIT_OK) \
+    S(FIELD, ACCEL_CONFIG,     ACCEL_CONFIG_FS_SEL, \
+          FIELD_VAL(ACCEL_CONFIG_FS_SEL, MPU_ACCEL_SCALE), 0, INIT_OK) \
+    S(FIELD, ACCEL_CONFIG2,    ACCEL_CONFIG2_FCHOICE_B, 0x00, 0, INIT_OK) \
+    S(FILTER, SMPLRT_DIV,      0, 0, 0, INIT_OK) \
+    S(BURST, SMPLRT_DIV,       0, ACCEL_CONFIG2 - SMPLRT_DIV + 1, 0, INIT_OK) \
+    S(FIELD, INT_PIN_CFG,      INT_PIN_CFG_LATCH_EN | INT_PIN_CFG_ANYRD_2CLR, \
+          INT_PIN_CFG_LATCH_EN | INT_PIN_CFG_ANYRD_2CLR, 0, INIT_OK) \
+    S(FIELD, INT_ENABLE,       INT_ENABLE_RAW_RDY_EN, \
+          INT_ENABLE_RAW_RDY_EN, 0, INIT_OK) \
+    S(BURST, INT_PIN_CFG,      0, INT_ENABLE - INT_PIN_CFG + 1, 0, INIT_OK) \
+    S(POLL,  INT_STATUS,       0x01, 0x01, INIT_TIMEOUT_DATA, INIT_TIMEOUT)
+
+//  Configure AK8963 as a slave of MPU9250, through I2C slave 4. First AK8963
+//  ID is read to check that it responds, then CNTL is written for 16-bit
+//  continuous measurements @ 100Hz. Setup of a slave 4 transaction is written
+//  in one burst ending with I2C_SLV4_CTRL, which starts it; transaction is
+//  done once I2C_SLV4_DONE (bit 6 of I2C_MST_STATUS) is set.
+//  Slave 0 is left configured to read ST1, data and ST2 registers of AK8963
+//  (8 bytes) on every sample of MPU, so readMagData() only has to read them
+//  from MPU. Reading ST2 releases the data latch in AK8963 so that DRDY bit in
+//  the next ST1 read is set only for a new measurement.
+#define INIT_AK(S) \
+    S(WRITE, I2C_MST_CTRL,     0xFF, 0x5D, 0, INIT_OK) \
+    S(WRITE, USER_CTRL,        0xFF, 0x20, 0, INIT_OK) \
+    S(FIELD, I2C_SLV4_ADDR,    0xFF, AK8963_ADDRESS | I2C_SLV_RNW, 0, INIT_OK) \
+    S(FIELD, I2C_SLV4_REG,     0xFF, WHO_AM_I_AK8963, 0, INIT_OK) \
+    S(FIELD, I2C_SLV4_CTRL,    0xFF, I2C_SLV_EN, 0, INIT_OK) \
+    S(BURST, I2C_SLV4_ADDR,    0, I2C_SLV4_CTRL - I2C_SLV4_ADDR + 1, 0, INIT_OK) \
+    S(POLL,  I2C_MST_STATUS,   0x40, 0x40, INIT_TIMEOUT_AUX, INIT_TIMEOUT) \
+    S(CHECK, I2C_SLV4_DI,      0xFF, 0x48, 0, INIT_NO_DEVICE) \
+    S(FIELD, I2C_SLV4_ADDR,    0xFF, AK8963_ADDRESS, 0, INIT_OK) \
+    S(FIELD, I2C_SLV4_REG,     0xFF, AK8963_CNTL, 0, INIT_OK) \
+    S(FIELD, I2C_SLV4_DO,      0xFF, MPU_MAG_SCALE << 4 | M_100HZ, 0, INIT_OK) \
+    S(BURST, I2C_SLV4_ADDR,    0, I2C_SLV4_CTRL - I2C_SLV4_ADDR + 1, 0, INIT_OK) \
+    S(POLL,  I2C_MST_STATUS,   0x40, 0x40, INIT_TIMEOUT_AUX, INIT_TIMEOUT) \
+    S(FIELD, I2C_SLV0_ADDR,    0xFF, AK8963_ADDRESS | I2C_SLV_RNW, 0, INIT_OK) \
+    S(FIELD, I2C_SLV0_REG,     0xFF, AK8963_ST1, 0, INIT_OK) \
+    S(FIELD, I2C_SLV0_CTRL,    0xFF, I2C_SLV_EN | 8, 0, INIT_OK) \
+    S(BURST, I2C_SLV0_ADDR,    0, I2C_SLV0_CTRL - I2C_SLV0_ADDR + 1, 0, INIT_OK)
+
+INIT_TABLE(_initReset, INIT_RESET);
+INIT_TABLE(_initMPU, INIT_MPU);
+INIT_TABLE(_initAK, INIT_AK);
+
+//  Bus transactions of each sequence, and check that all shadow accesses are
+//  inside of shadow
+INIT_ASSERT(_initResetBus, (0 INIT_RESET(INIT_BUS)) == 3);
+INIT_ASSERT(_initMPUBus, (0 INIT_MPU(INIT_BUS)) == 5);
+INIT_ASSERT(_initAKBus, (0 INIT_AK(INIT_BUS)) == 8);
+INIT_ASSERT(_initMPUShadow, (0 INIT_MPU(INIT_SHADOW_ERR)) == 0);
+INIT_ASSERT(_initAKShadow, (0 INIT_AK(INIT_SHADOW_ERR)) == 0);
+
+//  Shadow copy of configuration registers SHADOW_FIRST to SHADOW_LAST, and
+//  whether it holds what's in the chip (set once _initMPU completed, cleared
+//  by anything that reconfigures the chip outside of shadow)
+static uint8_t _shadow[SHADOW_LAST - SHADOW_FIRST + 1];
+static bool _shadowValid = false;
+
+//  Sample rate divider and DLPF_CFG of accel and gyro, changed at runtime with
+//  setFilterMPU9250() and applied by every initialization
+static uint8_t _sampleDiv = MPU_SAMPLE_DIV;
+static uint8_t _dlpfCfg = 0x03;
+
+//  Progress of non-blocking initialization: table being run (0 when idle),
+//  table to continue with once it's done, current step and time it started,
+//  and whether runtime rate divider has to be written once all tables are done
+static struct
+{
+    const InitStep *table;
+    const InitStep *next;
+    uint8_t  step;
+    uint32_t stepStart;
+    bool     rateDue;
+} _init;
+
+static void _CalFinish(float * gyroBias, float * accelBias);
+static void _CalWait(uint32_t ms, uint8_t next);
+static int8_t _InitRun(const InitStep *table);
+static void _FilterShadow(uint8_t div);
+
+
+/**
+ * Reset all registers of MPU9250 to their default values
+ * Returns as soon as reset bit (7) in PWR_MGMT_1 self-clears and the chip
+ * responds with its ID again. Blocking wrapper around initialization state
+ * machine.
+ * @return One of INIT_* codes (except INIT_BUSY)
+ */
+int8_t resetMPU9250()
+{
+    _shadowValid = false;
+    return _InitRun(_initReset);
+}
 
 /**
  * Configure MPU9250 accelerometer and gyroscope
- * Configures gyro for 1kHz sampling rate, 42Hz bandwidth and 200Hz output rate
- * and use full scale readings (+/- 250 dps). Configures accel for 1kHz sampling
- * rate, 200Hz output rate and full scale readings (+/- 16g). Finally, configure
- * interrupt pin to be active high, push-pull, held high until cleared and
- * cleared by reading ANY register. I2C bypass is disabled to allow for SPI.
- * Data-ready interrupts are only allowed.
+ * Blocking wrapper around initialization state machine, see _initMPU table
+ * for the sequence of register accesses.
+ * @return One of INIT_* codes (except INIT_BUSY)
  */
-void initMPU9250()
+int8_t initMPU9250()
 {
-    float gBias[3], aBias[3];
-
-    // Enable on first run to calibrate the sensor.
-    // calibrateMPU9250(gBias, aBias);
-
-    // wake up device
-    // Clear sleep mode bit (6), enable all sensors
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x00);
-    HAL_DelayUS(1000*100); // Wait for all registers to reset
-
-    // Get stable time source
-    // Auto select clock source to be PLL gyroscope reference if ready else
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x01);
-    HAL_DelayUS(1000*200);
-
-    // Configure Gyro and Thermometer
-    // Disable FSYNC and set thermometer and gyro bandwidth to 41 and 42 Hz,
-    // respectively;
-    // minimum delay time for this setting is 5.9 ms, which means sensor fusion
-    // update rates cannot be higher than 1 / 0.0059 = 170 Hz
-    // DLPF_CFG = bits 2:0 = 011; this limits the sample rate to 1000 Hz for both
-    // With the MPU9250, it is possible to get gyro sample rates of 32 kHz (!),
-    // 8 kHz, or 1 kHz
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, CONFIG, 0x03);
-
-    // Set sample rate = gyroscope output rate/(1 + SMPLRT_DIV)
-    // Use a 200 Hz rate; a rate consistent with the filter update rate
-    // determined inset in CONFIG above.
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, SMPLRT_DIV, 0x04);
-
-    // Set gyroscope full scale range
-    // Range selects FS_SEL and AFS_SEL are 0 - 3, so 2-bit values are
-    // left-shifted into positions 4:3
-
-    // get current GYRO_CONFIG register value
-    uint8_t c = HAL_MPU_ReadByte(MPU9250_ADDRESS, GYRO_CONFIG);
-    // c = c & ~0xE0; // Clear self-test bits [7:5]
-    c = c & ~0x02; // Clear Fchoice bits [1:0]
-    c = c & ~0x18; // Clear AFS bits [4:3]
-    c = c | Gscale << 3; // Set full scale range for the gyro
-    // Set Fchoice for the gyro to 11 by writing its inverse to bits 1:0 of
-    // GYRO_CONFIG
-    //c |= 0x03;
-    // Write new GYRO_CONFIG value to register
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, GYRO_CONFIG, c);
-
-    // Set accelerometer full-scale range configuration
-    // Get current ACCEL_CONFIG register value
-    c = HAL_MPU_ReadByte(MPU9250_ADDRESS, ACCEL_CONFIG);
-    // c = c & ~0xE0; // Clear self-test bits [7:5]
-    c = c & ~0x18;  // Clear AFS bits [4:3]
-    c = c | Ascale << 3; // Set full scale range for the accelerometer
-    // Write new ACCEL_CONFIG register value
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, ACCEL_CONFIG, c);
-
-    // Set accelerometer sample rate configuration
-    // It is possible to get a 4 kHz sample rate from the accelerometer by
-    // choosing 1 for accel_fchoice_b bit [3]; in this case the bandwidth is
-    // 1.13 kHz
-    // Get current ACCEL_CONFIG2 register value
-    c = HAL_MPU_ReadByte(MPU9250_ADDRESS, ACCEL_CONFIG2);
-    c = c & ~0x0F; // Clear accel_fchoice_b (bit 3) and A_DLPFG (bits [2:0])
-    c = c | 0x03;  // Set accelerometer rate to 1 kHz and bandwidth to 41 Hz
-    // Write new ACCEL_CONFIG2 register value
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, ACCEL_CONFIG2, c);
-    // The accelerometer, gyro, and thermometer are set to 1 kHz sample rates,
-    // but all these rates are further reduced by a factor of 5 to 200 Hz because
-    // of the SMPLRT_DIV setting
-
-    // Configure Interrupts and Bypass Enable
-    // Set interrupt pin active high, push-pull, hold interrupt pin level HIGH
-    // until interrupt cleared, clear on read of any register, and DISABLE
-    // I2C_BYPASS_EN -> otherwise communication with AK8963 doesn't work when
-    //  using SPI
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, INT_PIN_CFG, 0x30);
-    // Enable data ready (bit 0) interrupt
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, INT_ENABLE, 0x01);
-    HAL_DelayUS(1000*100);
+    return _InitRun(_initMPU);
 }
 
 /**
  * Initialize AK8963 magnetometer. 16bit data @ 100Hz
- * AK8963 is configured as a slave device of MPU9250 and not directly accessible.
- * Every transaction with AK8963 has to be carried through MPU9250 by configuring
- * its I2C slave communication registers. Result of the I2C transaction is also
- * stored internally in MPU and needs to be read as one would normally read
- * MPU registers.
+ * Blocking wrapper around initialization state machine, see _initAK table
+ * for the sequence of register accesses. Requires MPU to be running
+ * (initMPU9250()), as slave 4 transactions are carried out at its sample rate.
+ * MPU is switched to full rate for the time of it.
+ * @return One of INIT_* codes (except INIT_BUSY)
  */
-void initAK8963()
+int8_t initAK8963()
 {
-    //  Initialization uses I2C channel number 4 for writing data
-
-    //  Configure master I2C clock (400kHz) for MPU to talk to slaves
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_MST_CTRL, 0x5D);
-    //  Enable I2C master
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  USER_CTRL, 0x20);
-
-    //  Stop I2C slave number 4
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV4_CTRL, 0x00);
-    //  Set address for I2C4 slave to that of AK8963, writing mode (MSB=0)
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV4_ADDR, AK8963_ADDRESS);
-    //  Select which register is being updated
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV4_REG, AK8963_CNTL);
-    // Set value to write into the register:
-    //      16-bit continuous measurements @ 100Hz
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV4_DO, Mscale << 4 | Mmode);
-    // Trigger write data to slave device 4 -> AK8963
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV4_CTRL, 0x80);
-    HAL_DelayUS(5000);
+    if (_shadowValid && (_shadow[SMPLRT_DIV - SHADOW_FIRST] != 0))
+    {
+        _shadow[SMPLRT_DIV - SHADOW_FIRST] = 0;
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, SMPLRT_DIV, 0);
+        _init.rateDue = true;
+    }
+
+    return _InitRun(_initAK);
+}
+
+/**
+ * Start non-blocking initialization of MPU9250 (and AK8963)
+ * Initialization is carried out by calling initMPU9250Step() until it stops
+ * returning INIT_BUSY. Registers are not reset, so biases written into offset
+ * registers by calibration are kept.
+ * @param mag true to initialize AK8963 once MPU is running
+ */
+void initMPU9250Start(bool mag)
+{
+    _init.table = _initMPU;
+    _init.next = mag ? _initAK : 0;
+    _init.step = 0;
+    _init.stepStart = HAL_TS_GetTimeUS();
+    _init.rateDue = false;
+    _shadowValid = false;
+}
+
+/**
+ * Perform next step of initialization started with initMPU9250Start()
+ * Each call carries out register accesses of the table up to the first one
+ * that has to wait for the chip (poll which doesn't match yet, or delay), and
+ * then returns. A wait takes one register read per call, so no call takes more
+ * than a few bus transactions.
+ * @return INIT_BUSY while running, INIT_OK once device is configured and
+ *         running (or if initialization wasn't started), INIT_NO_DEVICE or
+ *         INIT_TIMEOUT if a check or wait in the sequence failed
+ */
+int8_t initMPU9250Step()
+{
+    const InitStep *st;
+    uint8_t c;
+
+    while (_init.table != 0)
+    {
+        st = &_init.table[_init.step];
+
+        switch (st->op)
+        {
+        case INIT_OP_WRITE:
+            HAL_MPU_WriteByte(MPU9250_ADDRESS, st->reg, st->value);
+            if ((st->reg >= SHADOW_FIRST) && (st->reg <= SHADOW_LAST))
+                _shadow[st->reg - SHADOW_FIRST] = st->value;
+            break;
+        case INIT_OP_FIELD:
+            c = _shadow[st->reg - SHADOW_FIRST];
+            _shadow[st->reg - SHADOW_FIRST] = (c & ~st->mask)
+                                              | (st->value & st->mask);
+            break;
+        case INIT_OP_BURST:
+            HAL_MPU_WriteBytes(MPU9250_ADDRESS, st->reg, st->value,
+                               &_shadow[st->reg - SHADOW_FIRST]);
+            break;
+        case INIT_OP_POLL:
+            if ((HAL_MPU_ReadByte(MPU9250_ADDRESS, st->reg) & st->mask)
+                == st->value)
+                break;
+            //  No match yet, fail only once the timeout expires
+            if ((HAL_TS_GetTimeUS() - _init.stepStart)
+                < ((uint32_t)st->timeout * 1000))
+                return INIT_BUSY;
+            _init.table = 0;
+            _init.rateDue = false;
+            return st->error;
+        case INIT_OP_CHECK:
+            if ((HAL_MPU_ReadByte(MPU9250_ADDRESS, st->reg) & st->mask)
+                == st->value)
+                break;
+            _init.table = 0;
+            _init.rateDue = false;
+            return st->error;
+        case INIT_OP_DELAY:
+            if ((HAL_TS_GetTimeUS() - _init.stepStart)
+                < ((uint32_t)st->timeout * 1000))
+                return INIT_BUSY;
+            break;
+        case INIT_OP_FILTER:
+            _FilterShadow(0);
+            _init.rateDue = true;
+            break;
+        default:    //  INIT_OP_END, continue with next table if there's one
+            //  After the last table, switch to runtime output rate. Settings
+            //  changed meanwhile with setFilterMPU9250() are applied too
+            if ((_init.next == 0) && _init.rateDue)
+            {
+                _FilterShadow(_sampleDiv);
+                HAL_MPU_WriteBytes(MPU9250_ADDRESS, SMPLRT_DIV,
+                                   ACCEL_CONFIG2 - SMPLRT_DIV + 1,
+                                   &_shadow[SMPLRT_DIV - SHADOW_FIRST]);
+                _init.rateDue = false;
+                _shadowValid = true;
+            }
+            _init.table = _init.next;
+            _init.next = 0;
+            _init.step = 0;
+            _init.stepStart = HAL_TS_GetTimeUS();
+            continue;
+        }
+
+        _init.step++;
+        _init.stepStart = HAL_TS_GetTimeUS();
+    }
+
+    return INIT_OK;
 }
 
 /**
@@ -258,44 +486,36 @@ void readGyroData(int16_t * destination)
 
 /**
  * Read raw magnetometer data into a provided buffer
+ * AK8963 runs at 100Hz while MPU samples it at its own output rate, so not
+ * every call gets a new measurement. Buffer is only updated when the sample
+ * is new and valid (DRDY set, HOFL cleared).
  * @param destination Buffer to save x, y, z magnetometer data (min. size = 3)
+ * @return Combination of MAG_STATUS_* flags describing the sample
  */
-void readMagData(int16_t * destination)
+uint8_t readMagData(int16_t * destination)
 {
-    // x,y,z gyro register data, ST2 register stored here, must read ST2 at end
-    // of data acquisition
-    uint8_t rawData[7];
-
-    //  TODO: In case it's necessary to always have new data when calling this
-    //  function, implement hanging function which reads Status1 register and
-    //  checks for DRDY bit -> I noticed it doesn't always work (i.e. new data
-    //  is available but bit is 0)
-
-    //  Stop any ongoing I2C0 operations
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV0_CTRL, 0x00);
-    // Set to read from slave address of AK8963
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV0_ADDR, AK8963_ADDRESS | 0x80);
-
-    // Start reading from X_out, 7 bytes. This will read 6 data registers and
-    //  one status register which will tell whether there was an overflow
-    //  in measurements
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV0_REG, AK8963_XOUT_L);
-    // Read 7 bytes from I2C slave 0
-    HAL_MPU_WriteByte(MPU9250_ADDRESS,  I2C_SLV0_CTRL, 0x87);
-    // Move 7 registers from MPU reg to here
-    HAL_MPU_ReadBytes(MPU9250_ADDRESS, EXT_SENS_DATA_00, 7, rawData);
-
-
-    uint8_t c = 0 & rawData[6]; // End data read by reading ST2 register
-    // Check if magnetic sensor overflow is set, if not then report data
-    if (!(c & 0x08))
+    // ST1, x,y,z mag register data and ST2 register stored here, as read by
+    // I2C slave 0 of MPU (configured in initAK8963())
+    uint8_t rawData[8];
+    uint8_t status;
+
+    // Move 8 registers from MPU reg to here
+    HAL_MPU_ReadBytes(MPU9250_ADDRESS, EXT_SENS_DATA_00, 8, rawData);
+
+    status = (rawData[0] & (AK8963_ST1_DRDY | AK8963_ST1_DOR))
+           | (rawData[7] & AK8963_ST2_HOFL);
+
+    // Report data only if it's new and magnetic sensor didn't overflow
+    if ((status & MAG_STATUS_DRDY) && !(status & MAG_STATUS_HOFL))
     {
       // Turn the MSB and LSB into a signed 16-bit value
-      destination[0] = ((int16_t)rawData[1] << 8) | rawData[0];
+      destination[0] = ((int16_t)rawData[2] << 8) | rawData[1];
       // Data stored as little Endian
-      destination[1] = ((int16_t)rawData[3] << 8) | rawData[2];
-      destination[2] = ((int16_t)rawData[5] << 8) | rawData[4];
+      destination[1] = ((int16_t)rawData[4] << 8) | rawData[3];
+      destination[2] = ((int16_t)rawData[6] << 8) | rawData[5];
     }
+
+    return status;
 }
 
 /**
@@ -311,105 +531,278 @@ int16_t readTempData()
   return ((int16_t)rawData[0] << 8) | rawData[1];
 }
 
+/**
+ * Read bias offsets currently held in MPU's offset registers
+ * @param gyro Buffer of size 3 to hold XG/YG/ZG_OFFSET values
+ * @param accel Buffer of size 3 to hold XA/YA/ZA_OFFSET values (bit 0 is
+ *        temperature compensation flag)
+ */
+void readOffsetsMPU9250(int16_t *gyro, int16_t *accel)
+{
+    uint8_t data[6], ii;
+
+    // Gyro offset registers are consecutive
+    HAL_MPU_ReadBytes(MPU9250_ADDRESS, XG_OFFSET_H, 6, data);
+    for (ii = 0; ii < 3; ii++)
+        gyro[ii] = ((int16_t)data[2*ii] << 8) | data[2*ii+1];
+
+    // Accel offset registers have a reserved register after each axis
+    for (ii = 0; ii < 3; ii++)
+    {
+        HAL_MPU_ReadBytes(MPU9250_ADDRESS, XA_OFFSET_H + 3*ii, 2, data);
+        accel[ii] = ((int16_t)data[0] << 8) | data[1];
+    }
+}
+
+/**
+ * Write bias offsets into MPU's offset registers, e.g. ones obtained by
+ * readOffsetsMPU9250() after calibration. Gyro offsets are written in one
+ * burst, accel offsets in one burst per axis.
+ * @param gyro XG/YG/ZG_OFFSET values
+ * @param accel XA/YA/ZA_OFFSET values
+ */
+void writeOffsetsMPU9250(const int16_t *gyro, const int16_t *accel)
+{
+    uint8_t data[6], ii;
+
+    for (ii = 0; ii < 3; ii++)
+    {
+        data[2*ii] = (gyro[ii] >> 8) & 0xFF;
+        data[2*ii+1] = gyro[ii] & 0xFF;
+    }
+    HAL_MPU_WriteBytes(MPU9250_ADDRESS, XG_OFFSET_H, 6, data);
+
+    for (ii = 0; ii < 3; ii++)
+    {
+        data[0] = (accel[ii] >> 8) & 0xFF;
+        data[1] = accel[ii] & 0xFF;
+        HAL_MPU_WriteBytes(MPU9250_ADDRESS, XA_OFFSET_H + 3*ii, 2, data);
+    }
+}
+
+/**
+ * Set output data rate and bandwidth of accelerometer and gyroscope
+ * Settings are kept and used by every following initialization. Once device
+ * has been initialized (and not reset or calibrated since) they're also
+ * written right away, in one burst together with the rest of configuration
+ * registers from the shadow; otherwise they're only stored, as the shadow
+ * doesn't hold device's configuration.
+ * @param div Sample rate divider, output rate is 1kHz/(1 + div)
+ * @param dlpf DLPF_CFG for both accel and gyro, 1 (184/218Hz) to 6 (5Hz);
+ *        these keep internal sampling rate at 1kHz
+ */
+void setFilterMPU9250(uint8_t div, uint8_t dlpf)
+{
+    _sampleDiv = div;
+    _dlpfCfg = dlpf;
+
+    if (!_shadowValid || (_init.table != 0))
+        return;
+
+    _FilterShadow(_sampleDiv);
+    HAL_MPU_WriteBytes(MPU9250_ADDRESS, SMPLRT_DIV,
+                       ACCEL_CONFIG2 - SMPLRT_DIV + 1,
+                       &_shadow[SMPLRT_DIV - SHADOW_FIRST]);
+}
+
+/**
+ * Get output data rate and bandwidth set with setFilterMPU9250()
+ * @param div Sample rate divider
+ * @param dlpf DLPF_CFG of accel and gyro
+ */
+void getFilterMPU9250(uint8_t *div, uint8_t *dlpf)
+{
+    *div = _sampleDiv;
+    *dlpf = _dlpfCfg;
+}
+
 /**
  * Function which accumulates gyro and accelerometer data after device
  * initialization. It calculates the average of the at-rest readings and then
  * loads the resulting offsets into accelerometer and gyro bias registers.
+ * Blocking wrapper around calibration state machine, averages 40 samples.
  * @param gyroBias
  * @param accelBias
  */
 void calibrateMPU9250(float * gyroBias, float * accelBias)
 {
-    uint8_t data[12]; // data array to hold accelerometer and gyro x, y, z, data
+    calibrateMPU9250Start(40);
+    while (calibrateMPU9250Step(gyroBias, accelBias) == CAL_BUSY);
+}
+
+/**
+ * Start non-blocking calibration of accelerometer and gyroscope
+ * Calibration is carried out by calling calibrateMPU9250Step() until it stops
+ * returning CAL_BUSY. Calibration resets the device and leaves it configured
+ * for calibration, so MPU has to be initialized again once calibration is over.
+ * @param samples Number of samples (at 1kHz) to average for bias estimates
+ */
+void calibrateMPU9250Start(uint16_t samples)
+{
+    static const float zero[FIFO_CHANNELS] = { 0, 0, 0, 0, 0, 0 };
+    static const float unit[FIFO_CHANNELS] = { 1, 1, 1, 1, 1, 1 };
+
+    memset((void*)&_cal, 0, sizeof(_cal));
+    _cal.target = (samples > 0) ? samples : 1;
+    //  Calibration reconfigures the device without the shadow
+    _shadowValid = false;
+    _cal.state = CAL_S_RESET;
+    fifoConvertCoef(&_calCoef, zero, unit);
+}
+
+/**
+ * Perform next step of calibration started with calibrateMPU9250Start()
+ * Each call either issues next part of configuration, checks whether a wait
+ * is over, or drains FIFO in a single burst, and then returns. Should be
+ * called at least every ~40ms while samples are being accumulated, otherwise
+ * MPU's FIFO fills up: whole packets in it are still used, but samples taken
+ * meanwhile are lost, so calibration takes longer.
+ * @param gyroBias Buffer of size 3 to hold gyro bias (deg/s) once done
+ * @param accelBias Buffer of size 3 to hold accel bias (g) once done
+ * @return CAL_BUSY while running, CAL_DONE when biases have been written to
+ *         output buffers and MPU's offset registers, CAL_IDLE if calibration
+ *         wasn't started
+ */
+int8_t calibrateMPU9250Step(float * gyroBias, float * accelBias)
+{
+    uint8_t data[2];
     uint16_t ii, packet_count, fifo_count;
-    int32_t gyro_bias[3]  = {0, 0, 0}, accel_bias[3] = {0, 0, 0};
-
-    // reset device
-    // Write a one to bit 7 reset bit; toggle reset device
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 1<<7);
-    HAL_DelayUS(1000*100);
-
-    // get stable time source; Auto select clock source to be PLL gyroscope
-    // reference if ready else use the internal oscillator, bits 2:0 = 001
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x01);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_2, 0x00);
-    HAL_DelayUS(1000*200);
-
-    // Configure device for bias calculation
-    // Disable all interrupts
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, INT_ENABLE, 0x00);
-    // Disable FIFO
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x00);
-    // Turn on internal clock source
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x00);
-    // Disable I2C master
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, I2C_MST_CTRL, 0x00);
-    // Disable FIFO and I2C master modes
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x00);
-    // Reset FIFO and DMP
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x0C);
-    HAL_DelayUS(1000*15);
-
-    // Configure MPU6050 gyro and accelerometer for bias calculation
-    // Set low-pass filter to 188 Hz
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, CONFIG, 0x01);
-    // Set sample rate to 1 kHz
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, SMPLRT_DIV, 0x00);
-    // Set gyro full-scale to 250 degrees per second, maximum sensitivity
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, GYRO_CONFIG, 0x00);
-    // Set accelerometer full-scale to 2 g, maximum sensitivity
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, ACCEL_CONFIG, 0x00);
+    uint8_t jj;
+    float sum;
+
+    switch (_cal.state)
+    {
+    case CAL_S_RESET:
+        // reset device
+        // Write a one to bit 7 reset bit; toggle reset device
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 1<<7);
+        _CalWait(100, CAL_S_CLOCK);
+        break;
+    case CAL_S_CLOCK:
+        // get stable time source; Auto select clock source to be PLL gyroscope
+        // reference if ready else use the internal oscillator, bits 2:0 = 001
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x01);
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_2, 0x00);
+        _CalWait(200, CAL_S_CONFIG);
+        break;
+    case CAL_S_CONFIG:
+        // Configure device for bias calculation
+        // Disable all interrupts
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, INT_ENABLE, 0x00);
+        // Disable FIFO
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x00);
+        // Turn on internal clock source
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 0x00);
+        // Disable I2C master
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, I2C_MST_CTRL, 0x00);
+        // Disable FIFO and I2C master modes
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x00);
+        // Reset FIFO and DMP
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x0C);
+        _CalWait(15, CAL_S_FIFO_START);
+        break;
+    case CAL_S_FIFO_START:
+        // Configure MPU6050 gyro and accelerometer for bias calculation
+        // Set low-pass filter to 188 Hz. FIFO mode: once FIFO is full, new
+        // samples are dropped instead of the oldest ones, so its head stays
+        // aligned to packets
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, CONFIG, 0x41);
+        // Set sample rate to 1 kHz
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, SMPLRT_DIV, 0x00);
+        // Set gyro full-scale to 250 degrees per second, maximum sensitivity
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, GYRO_CONFIG, 0x00);
+        // Set accelerometer full-scale to 2 g, maximum sensitivity
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, ACCEL_CONFIG, 0x00);
+
+        // Configure FIFO to capture accelerometer and gyro data for bias
+        // calculation
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x40);  // Enable FIFO
+        // Enable gyro and accelerometer sensors for FIFO  (max size 512 bytes
+        // in MPU-9150)
+        HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x78);
+        _cal.state = CAL_S_ACCUMULATE;
+        break;
+    case CAL_S_ACCUMULATE:
+        // Read FIFO sample count
+        HAL_MPU_ReadBytes(MPU9250_ADDRESS, FIFO_COUNTH, 2, &data[0]);
+        fifo_count = ((uint16_t)data[0] << 8) | data[1];
+        // How many sets of full gyro and accelerometer data for averaging
+        packet_count = fifo_count/FIFO_PACKET_SIZE;
+        if (packet_count > CAL_FIFO_PACKETS)
+            packet_count = CAL_FIFO_PACKETS;
+        if (packet_count > (_cal.target - _cal.samples))
+            packet_count = _cal.target - _cal.samples;
+        if (packet_count == 0)
+            break;
+
+        // Drain all complete packets in one burst
+        HAL_MPU_ReadBytes(MPU9250_ADDRESS, FIFO_R_W,
+                          packet_count*FIFO_PACKET_SIZE, _calFifo);
+
+        // If FIFO filled up (before or during the burst), packets read are
+        // still the oldest ones and valid, but it ends with a partial packet:
+        // drop the rest and start filling it again
+        if (HAL_MPU_ReadByte(MPU9250_ADDRESS, INT_STATUS) & 0x10)
+            HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x44);
+
+        // Convert the burst at once into per-channel arrays and sum them to
+        // get accumulated biases. Accel in [0..2], gyro in [3..5]
+        fifoConvert(&_calCoef, _calFifo, packet_count, _calConvOut);
+        for (jj = 0; jj < FIFO_CHANNELS; jj++)
+        {
+            sum = 0.0f;
+            for (ii = 0; ii < packet_count; ii++)
+                sum += _calConv[jj][ii];
+            _cal.bias[jj] += (int32_t)sum;
+        }
+        _cal.samples += packet_count;
+
+        if (_cal.samples >= _cal.target)
+        {
+            // At end of sample accumulation, turn off FIFO sensor read
+            // Disable gyro and accelerometer sensors for FIFO
+            HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x00);
+            _cal.state = CAL_S_FINISH;
+        }
+        break;
+    case CAL_S_FINISH:
+        _CalFinish(gyroBias, accelBias);
+        _cal.state = CAL_S_IDLE;
+        return CAL_DONE;
+    case CAL_S_WAIT:
+        if ((HAL_TS_GetTimeMS() - _cal.waitStart) >= _cal.waitMs)
+            _cal.state = _cal.nextState;
+        break;
+    default:
+        return CAL_IDLE;
+    }
+
+    return CAL_BUSY;
+}
+
+/**
+ * Compute biases from accumulated samples, push them into MPU's offset
+ * registers and provide scaled values to the caller. Last step of calibration.
+ * @param gyroBias Buffer of size 3 to hold gyro bias (deg/s)
+ * @param accelBias Buffer of size 3 to hold accel bias (g)
+ */
+static void _CalFinish(float * gyroBias, float * accelBias)
+{
+    uint8_t data[6];
+    uint16_t ii;
+    int32_t gyro_bias[3], accel_bias[3];
 
     uint16_t  gyrosensitivity  = 131;   // = 131 LSB/degrees/sec
     uint16_t  accelsensitivity = 16384; // = 16384 LSB/g
 
-    // Configure FIFO to capture accelerometer and gyro data for bias calculation
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, USER_CTRL, 0x40);  // Enable FIFO
-    // Enable gyro and accelerometer sensors for FIFO  (max size 512 bytes in
-    // MPU-9150)
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x78);
-    HAL_DelayUS(1000*40);  // accumulate 40 samples in 40 milliseconds = 480 bytes
-
-    // At end of sample accumulation, turn off FIFO sensor read
-    // Disable gyro and accelerometer sensors for FIFO
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, FIFO_EN, 0x00);
-    // Read FIFO sample count
-    HAL_MPU_ReadBytes(MPU9250_ADDRESS, FIFO_COUNTH, 2, &data[0]);
-    fifo_count = ((uint16_t)data[0] << 8) | data[1];
-    // How many sets of full gyro and accelerometer data for averaging
-    packet_count = fifo_count/12;
-
-    for (ii = 0; ii < packet_count; ii++)
+    // Average accumulated sums to get biases
+    for (ii = 0; ii < 3; ii++)
     {
-        int16_t accel_temp[3] = {0, 0, 0}, gyro_temp[3] = {0, 0, 0};
-        // Read data for averaging
-        HAL_MPU_ReadBytes(MPU9250_ADDRESS, FIFO_R_W, 12, &data[0]);
-        // Form signed 16-bit integer for each sample in FIFO
-        accel_temp[0] = (int16_t) (((int16_t)data[0] << 8) | data[1]  );
-        accel_temp[1] = (int16_t) (((int16_t)data[2] << 8) | data[3]  );
-        accel_temp[2] = (int16_t) (((int16_t)data[4] << 8) | data[5]  );
-        gyro_temp[0]  = (int16_t) (((int16_t)data[6] << 8) | data[7]  );
-        gyro_temp[1]  = (int16_t) (((int16_t)data[8] << 8) | data[9]  );
-        gyro_temp[2]  = (int16_t) (((int16_t)data[10] << 8) | data[11]);
-
-        // Sum individual signed 16-bit biases to get accumulated signed 32-bit
-        // biases.
-        accel_bias[0] += (int32_t) accel_temp[0];
-        accel_bias[1] += (int32_t) accel_temp[1];
-        accel_bias[2] += (int32_t) accel_temp[2];
-        gyro_bias[0]  += (int32_t) gyro_temp[0];
-        gyro_bias[1]  += (int32_t) gyro_temp[1];
-        gyro_bias[2]  += (int32_t) gyro_temp[2];
+        accel_bias[ii] = (int32_t)(_cal.bias[ii] / (int64_t)_cal.samples);
+        gyro_bias[ii]  = (int32_t)(_cal.bias[ii+3] / (int64_t)_cal.samples);
     }
-    // Sum individual signed 16-bit biases to get accumulated signed 32-bit biases
-    accel_bias[0] /= (int32_t) packet_count;
-    accel_bias[1] /= (int32_t) packet_count;
-    accel_bias[2] /= (int32_t) packet_count;
-    gyro_bias[0]  /= (int32_t) packet_count;
-    gyro_bias[1]  /= (int32_t) packet_count;
-    gyro_bias[2]  /= (int32_t) packet_count;
-
-    // Sum individual signed 16-bit biases to get accumulated signed 32-bit biases
+
+    // Remove gravity from the z-axis accelerometer bias calculation
     if (accel_bias[2] > 0L)
     {
         accel_bias[2] -= (int32_t) accelsensitivity;
@@ -431,13 +824,9 @@ void calibrateMPU9250(float * gyroBias, float * accelBias)
     data[4] = (-gyro_bias[2]/4  >> 8) & 0xFF;
     data[5] = (-gyro_bias[2]/4)       & 0xFF;
 
-    // Push gyro biases to hardware registers
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, XG_OFFSET_H, data[0]);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, XG_OFFSET_L, data[1]);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, YG_OFFSET_H, data[2]);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, YG_OFFSET_L, data[3]);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, ZG_OFFSET_H, data[4]);
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, ZG_OFFSET_L, data[5]);
+    // Push gyro biases to hardware registers (XG_OFFSET_H..ZG_OFFSET_L are
+    // consecutive registers)
+    HAL_MPU_WriteBytes(MPU9250_ADDRESS, XG_OFFSET_H, 6, data);
 
     // Output scaled gyro biases for display in the main program
     gyroBias[0] = (float) gyro_bias[0]/(float) gyrosensitivity;
@@ -517,4 +906,54 @@ void calibrateMPU9250(float * gyroBias, float * accelBias)
     accelBias[2] = (float)accel_bias[2]/(float)accelsensitivity;
 }
 
+/**
+ * Put calibration into waiting state for given time, after which it continues
+ * with the given state
+ * @param ms Time to wait in milliseconds
+ * @param next State to continue in once the time is up
+ */
+static void _CalWait(uint32_t ms, uint8_t next)
+{
+    _cal.waitStart = HAL_TS_GetTimeMS();
+    _cal.waitMs = ms;
+    _cal.nextState = next;
+    _cal.state = CAL_S_WAIT;
+}
+
+/**
+ * Run initialization table to completion
+ * @param table Table to run
+ * @return One of INIT_* codes (except INIT_BUSY)
+ */
+static int8_t _InitRun(const InitStep *table)
+{
+    int8_t retVal;
+
+    _init.table = table;
+    _init.next = 0;
+    _init.step = 0;
+    _init.stepStart = HAL_TS_GetTimeUS();
+
+    while ((retVal = initMPU9250Step()) == INIT_BUSY)
+        HAL_DelayUS(50);
+
+    return retVal;
+}
+
+/**
+ * Set sample rate divider and DLPF fields in shadow
+ * @param div Sample rate divider, DLPF is set to runtime setting
+ */
+static void _FilterShadow(uint8_t div)
+{
+    uint8_t *c;
+
+    _shadow[SMPLRT_DIV - SHADOW_FIRST] = div;
+    c = &_shadow[CONFIG - SHADOW_FIRST];
+    *c = (*c & ~CONFIG_DLPF_CFG) | FIELD_VAL(CONFIG_DLPF_CFG, _dlpfCfg);
+    c = &_shadow[ACCEL_CONFIG2 - SHADOW_FIRST];
+    *c = (*c & ~ACCEL_CONFIG2_DLPF_CFG)
+         | FIELD_VAL(ACCEL_CONFIG2_DLPF_CFG, _dlpfCfg);
+}
+
 #endif  /* __HAL_USE_MPU9250_NODMP__ */
@@ -15,10 +15,26 @@
  *      Changes to original project were made in order to support SPI interface
  *      instead of commonly used I2C.
  *
- *  @version 1.0.0
+ *  @version 1.1.0
  *  V1.0.0
  *  +Creation of file. Tested reading functions for gyro/mag/accel and
  *  initialization. API tested with both SPI & I2C.
+ *  V1.1.0
+ *  +AK8963 is read continuously through I2C slave 0, readMagData() returns
+ *  data-ready/overflow status of the sample it read
+ *  +Non-blocking calibration of accel/gyro (calibrateMPU9250Start/Step),
+ *  FIFO is drained in bursts so long averaging windows are possible. Full
+ *  FIFO keeps its oldest samples, which are still used
+ *  +Initialization polls for readiness of MPU and AK8963 (with timeouts)
+ *  instead of waiting fixed worst-case delays
+ *  +Initialization sequences are tables of register accesses run by a
+ *  non-blocking state machine (initMPU9250Start/Step)
+ *  +Configuration registers composed field by field in a shadow copy and
+ *  written in bursts, bus transactions of each sequence checked at compile time
+ *  +Reading and writing of accel/gyro offset registers, used to restore stored
+ *  calibration
+ *  +Output rate and bandwidth can be changed at runtime (setFilterMPU9250()),
+ *  initialization runs at full rate and switches to the set rate at the end
  */
 #include "hwconfig.h"
 
@@ -27,13 +43,39 @@
 #define ROVERKERNEL_MPU9250_API_MPU9250_H_
 
 
+//  Status flags of a magnetometer sample, returned by readMagData()
+//  (bits match those in AK8963 ST1/ST2 registers)
+#define MAG_STATUS_DRDY     0x01    //  Sample is new since the last read
+#define MAG_STATUS_DOR      0x02    //  At least one sample was skipped
+#define MAG_STATUS_HOFL     0x08    //  Magnetic sensor overflow, data invalid
+
+//  Return values of resetMPU9250(), initMPU9250(), initAK8963() and
+//  initMPU9250Step()
+#define INIT_OK             0       //  Device is configured and running
+#define INIT_NO_DEVICE      1       //  Device didn't respond with its ID
+#define INIT_TIMEOUT        2       //  Device didn't become ready in time
+#define INIT_BUSY           3       //  Initialization still running
+
+//  Max. time to wait for the device to become ready, in ms
+#define INIT_TIMEOUT_ID     100     //  WHO_AM_I after power-on or reset
+#define INIT_TIMEOUT_DATA   100     //  First sample after configuration
+#define INIT_TIMEOUT_AUX    10      //  Transaction on auxiliary I2C bus
+
+//  Return values of calibrateMPU9250Step()
+#define CAL_DONE            0       //  Calibration finished, biases are valid
+#define CAL_BUSY            1       //  Calibration still running
+#define CAL_IDLE            2       //  No calibration was started
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-    void    initMPU9250();
-    void    initAK8963();
+    int8_t  resetMPU9250();
+    int8_t  initMPU9250();
+    int8_t  initAK8963();
+    void    initMPU9250Start(bool mag);
+    int8_t  initMPU9250Step();
 
     float   getMres();
     float   getGres();
@@ -41,14 +83,20 @@ extern "C"
 
     void    readAccelData(int16_t *);
     void    readGyroData(int16_t *);
-    void    readMagData(int16_t *);
+    uint8_t readMagData(int16_t *);
     int16_t readTempData();
 
 
     void    calibrateMPU9250(float * gyroBias, float * accelBias);
+    void    readOffsetsMPU9250(int16_t *gyro, int16_t *accel);
+    void    writeOffsetsMPU9250(const int16_t *gyro, const int16_t *accel);
+    void    setFilterMPU9250(uint8_t div, uint8_t dlpf);
+    void    getFilterMPU9250(uint8_t *div, uint8_t *dlpf);
+    void    calibrateMPU9250Start(uint16_t samples);
+    int8_t  calibrateMPU9250Step(float * gyroBias, float * accelBias);
     //  TODO:
     //void    MPU9250SelfTest(float * destination);
-    //void    magCalMPU9250(float * dest1, float * dest2);
+    //  Magnetometer calibration is done online, check magCal.h
 #ifdef __cplusplus
 }
 #endif
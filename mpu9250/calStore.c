@@ -0,0 +1,93 @@
+/**
+ * calStore.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "calStore.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)       //  Compile only if module is enabled
+
+#include "HAL/hal.h"
+#include "libs/myLib.h"
+
+//  Record is written as whole words and its size has to fit into size field
+typedef char _calStoreSize[((sizeof(MPUCalRecord) % 4) == 0)
+                           && (sizeof(MPUCalRecord) < 256) ? 1 : -1];
+
+//  Set once EEPROM has been initialized
+static bool _eepromReady = false;
+
+static int8_t _CalStoreInit();
+
+
+/**
+ * Load calibration record from EEPROM
+ * @param rec Buffer to hold the record, content is undefined unless
+ *        CAL_STORE_OK is returned
+ * @return One of CAL_STORE_* codes
+ */
+int8_t calStoreLoad(MPUCalRecord *rec)
+{
+    if (_CalStoreInit() != CAL_STORE_OK)
+        return CAL_STORE_HW_ERR;
+
+    if (HAL_EEPROM_Read(MPU_CAL_EEPROM_ADDR, (uint32_t*)rec,
+                        sizeof(MPUCalRecord)) != HAL_OK)
+        return CAL_STORE_HW_ERR;
+
+    //  Erased EEPROM reads all ones
+    if (rec->magic == 0xFFFF)
+        return CAL_STORE_EMPTY;
+    if ((rec->magic != CAL_STORE_MAGIC) || (rec->version != CAL_STORE_VERSION)
+        || (rec->size != sizeof(MPUCalRecord)))
+        return CAL_STORE_INVALID;
+    if (crc16(0xFFFF, (uint8_t*)rec, sizeof(MPUCalRecord) - sizeof(rec->crc))
+        != rec->crc)
+        return CAL_STORE_INVALID;
+
+    return CAL_STORE_OK;
+}
+
+/**
+ * Store calibration record into EEPROM, replacing the one stored before
+ * Header and CRC of the record are filled in here.
+ * @param rec Record to store
+ * @return One of CAL_STORE_* codes
+ */
+int8_t calStoreSave(MPUCalRecord *rec)
+{
+    if (_CalStoreInit() != CAL_STORE_OK)
+        return CAL_STORE_HW_ERR;
+
+    rec->magic = CAL_STORE_MAGIC;
+    rec->version = CAL_STORE_VERSION;
+    rec->size = sizeof(MPUCalRecord);
+    rec->reserved = 0;
+    rec->crc = crc16(0xFFFF, (uint8_t*)rec,
+                     sizeof(MPUCalRecord) - sizeof(rec->crc));
+
+    if (HAL_EEPROM_Write(MPU_CAL_EEPROM_ADDR, (uint32_t*)rec,
+                         sizeof(MPUCalRecord)) != HAL_OK)
+        return CAL_STORE_HW_ERR;
+
+    return CAL_STORE_OK;
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Initialize EEPROM on first access
+ * @return CAL_STORE_OK if EEPROM is usable, CAL_STORE_HW_ERR otherwise
+ */
+static int8_t _CalStoreInit()
+{
+    if (!_eepromReady)
+        _eepromReady = (HAL_EEPROM_Init() == HAL_OK);
+
+    return _eepromReady ? CAL_STORE_OK : CAL_STORE_HW_ERR;
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
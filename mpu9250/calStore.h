@@ -0,0 +1,65 @@
+/**
+ * calStore.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Persistent storage of sensor calibration in on-chip EEPROM (or a file when
+ *  built for PC, see HAL). Calibration is kept as a single versioned record
+ *  protected by CRC, so an erased, interrupted or outdated record is detected
+ *  and ignored instead of being loaded into the sensor.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_CALSTORE_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_CALSTORE_H_
+
+//  Identification of the record, version changes with its layout
+#define CAL_STORE_MAGIC     0x4D43  //  "CM"
+#define CAL_STORE_VERSION   1
+
+//  Return values of calStoreLoad() and calStoreSave()
+#define CAL_STORE_OK        0       //  Record was read/written
+#define CAL_STORE_EMPTY     1       //  No record stored (EEPROM erased)
+#define CAL_STORE_INVALID   2       //  Bad CRC or unknown version of record
+#define CAL_STORE_HW_ERR    3       //  EEPROM can't be accessed
+
+/**
+ * Calibration record, all fields are written by the user except header
+ * (magic, version, size) and CRC which are filled in by calStoreSave()
+ */
+typedef struct
+{
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  size;              //  Size of record in bytes
+    int16_t  gyroOffset[3];     //  XG/YG/ZG_OFFSET register values
+    int16_t  accelOffset[3];    //  XA/YA/ZA_OFFSET register values
+    int16_t  tempRef;           //  Raw temperature at which it was saved
+    uint8_t  gyroScale;         //  Gscale and Ascale in use when saved
+    uint8_t  accelScale;
+    float    magOffset[3];      //  Hard-iron offset, raw magnetometer units
+    float    magSoftIron[3][3]; //  Soft-iron correction matrix
+    float    gyroBias[3];       //  Online gyro bias estimate, raw gyro units
+    uint16_t reserved;
+    uint16_t crc;               //  CRC-16 of all preceding bytes
+} MPUCalRecord;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    int8_t  calStoreLoad(MPUCalRecord *rec);
+    int8_t  calStoreSave(MPUCalRecord *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROVERKERNEL_MPU9250_CALSTORE_H_ */
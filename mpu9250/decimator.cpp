@@ -0,0 +1,145 @@
+/**
+ * decimator.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "decimator.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)  //  Compile only if module is enabled
+
+#include "libs/myLib.h"
+#include "MahonyAHRS.h"
+
+
+Decimator::Decimator() : divider(0), _mode(DEC_LATEST), _cnt(0), _seq(0),
+                         _pub(0), _read(0)
+{
+    memset((void*)_sum, 0, sizeof(_sum));
+    memset((void*)_out, 0, sizeof(_out));
+}
+
+/**
+ * Configure rate of this consumer
+ * @param divider Publish once every divider input samples, 0 to stop
+ *        publishing
+ * @param mode DEC_AVERAGE or DEC_LATEST
+ */
+void Decimator::Setup(uint16_t divider, uint8_t mode)
+{
+    this->divider = divider;
+    _mode = mode;
+    _cnt = 0;
+    memset((void*)_sum, 0, sizeof(_sum));
+}
+
+/**
+ * Push new input sample, called at full sensor rate
+ * In DEC_LATEST mode only the last sample of a period is looked at.
+ * @param acc Acceleration [x,y,z]
+ * @param gyro Angular rate [x,y,z]
+ * @param mag Magnetic field [x,y,z]
+ * @param quat Attitude quaternion [w,x,y,z]
+ * @return true if a new output was published with this sample
+ */
+bool Decimator::Push(const float *acc, const float *gyro, const float *mag,
+                     const float *quat)
+{
+    uint8_t i;
+
+    _seq++;
+    if (divider == 0)
+        return false;
+
+    if (_mode == DEC_AVERAGE)
+    {
+        //  q and -q are the same attitude, add up the ones on the same side
+        //  as the first quaternion of the period
+        float dot = quat[0]*_sum[9] + quat[1]*_sum[10] + quat[2]*_sum[11]
+                  + quat[3]*_sum[12];
+        float sgn = (dot < 0.0f) ? -1.0f : 1.0f;
+
+        for (i = 0; i < 3; i++)
+        {
+            _sum[i] += acc[i];
+            _sum[3+i] += gyro[i];
+            _sum[6+i] += mag[i];
+        }
+        for (i = 0; i < 4; i++)
+            _sum[9+i] += sgn * quat[i];
+    }
+
+    if (++_cnt < divider)
+        return false;
+
+    if (_mode == DEC_AVERAGE)
+    {
+        float k = 1.0f / (float)_cnt;
+
+        for (i = 0; i < 9; i++)
+            _sum[i] *= k;
+        _Publish(&_sum[0], &_sum[3], &_sum[6], &_sum[9]);
+        memset((void*)_sum, 0, sizeof(_sum));
+    }
+    else
+        _Publish(acc, gyro, mag, quat);
+    _cnt = 0;
+
+    return true;
+}
+
+/**
+ * Get newest published sample, if there's one consumer hasn't seen yet
+ * Safe to call while Push() runs in an interrupt.
+ * @param out Buffer to hold published sample
+ * @return true if a new sample was copied to out, false otherwise
+ */
+bool Decimator::Fetch(MPUOutput *out)
+{
+    uint32_t pub;
+
+    do
+    {
+        pub = _pub;
+        if (pub == _read)
+            return false;
+        memcpy((void*)out, (void*)&_out[pub & 1], sizeof(MPUOutput));
+    //  Copy again if a new sample was published while copying
+    } while (pub != _pub);
+    _read = pub;
+
+    return true;
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Write sample into buffer not visible to consumer and make it visible
+ */
+void Decimator::_Publish(const float *acc, const float *gyro,
+                         const float *mag, const float *quat)
+{
+    MPUOutput &o = _out[(_pub + 1) & 1];
+    float norm = 0.0f;
+    uint8_t i;
+
+    memcpy((void*)o.acc, (void*)acc, sizeof(o.acc));
+    memcpy((void*)o.gyro, (void*)gyro, sizeof(o.gyro));
+    memcpy((void*)o.mag, (void*)mag, sizeof(o.mag));
+
+    //  Averaged quaternion needs normalizing
+    for (i = 0; i < 4; i++)
+        norm += quat[i]*quat[i];
+    norm = (norm > 0.0f) ? 1.0f/sqrtf(norm) : 0.0f;
+    for (i = 0; i < 4; i++)
+        o.quat[i] = quat[i] * norm;
+
+    Mahony::QuatToYPR(o.quat, o.ypr);
+    o.seq = _seq;
+
+    _pub++;
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
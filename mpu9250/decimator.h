@@ -0,0 +1,79 @@
+/**
+ * decimator.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Reduction of sensor output rate for a single consumer. Sensor is read and
+ *  attitude updated at the full output data rate of the MPU, while each
+ *  consumer (telemetry, control loop...) gets its own decimator publishing
+ *  only every N-th input sample. Output is either the average of all samples
+ *  in the period (attitude is averaged as a quaternion) or just the last one.
+ *  Euler angles are computed only when a sample is published.
+ *  Published sample is double-buffered, so it can be fetched from main loop
+ *  while decimator is fed from an interrupt.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_DECIMATOR_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_DECIMATOR_H_
+
+#include <stdint.h>
+
+//  Ways of reducing the rate
+#define DEC_AVERAGE     0   //  Average of all samples in the period
+#define DEC_LATEST      1   //  Last sample of the period
+
+
+/**
+ * Sample published to a consumer
+ */
+struct MPUOutput
+{
+    float    acc[3];    //  Acceleration in body frame, m/s^2
+    float    gyro[3];   //  Angular rate in body frame, rad/s
+    float    mag[3];    //  Magnetic field in body frame, mG
+    float    quat[4];   //  Attitude quaternion [w,x,y,z]
+    float    ypr[3];    //  Yaw-pitch-roll in radians
+    uint32_t seq;       //  Number of input samples up to this one
+};
+
+/**
+ * Rate reduction for one consumer of sensor data
+ */
+class Decimator
+{
+    public:
+        Decimator();
+
+        void    Setup(uint16_t divider, uint8_t mode);
+        bool    Push(const float *acc, const float *gyro, const float *mag,
+                     const float *quat);
+        bool    Fetch(MPUOutput *out);
+
+        //  Publish every divider-th input sample, 0 if decimator is unused
+        uint16_t divider;
+
+    private:
+        void    _Publish(const float *acc, const float *gyro,
+                         const float *mag, const float *quat);
+
+        uint8_t  _mode;
+        //  Samples in current period, and total number of input samples
+        uint16_t _cnt;
+        uint32_t _seq;
+        //  Sums over current period [acc, gyro, mag, quat]
+        float    _sum[13];
+        //  Published samples, _pub counts publications and its LSB selects
+        //  buffer holding the newest one. _read is the last _pub fetched
+        MPUOutput _out[2];
+        volatile uint32_t _pub;
+        uint32_t _read;
+};
+
+#endif /* ROVERKERNEL_MPU9250_DECIMATOR_H_ */
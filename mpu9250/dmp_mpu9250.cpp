@@ -16,6 +16,7 @@
 #include "eMPL/inv_mpu_dmp_motion_driver.h"
 
 #include "registerMap.h"
+#include "sensorAxes.h"
 
 //  Enable debug information printed on serial port
 #define __DEBUG_SESSION__
@@ -67,6 +68,17 @@ struct hal_s {
 };
 static struct hal_s hal = {0};
 
+//  Record of DMP image configured by the last cold start, kept in EEPROM at
+//  MPU_DMP_EEPROM_ADDR. Inverted copy of CRC tells record from erased memory
+#define DMP_IMAGE_MAGIC     0x4449  //  "DI"
+struct dmp_image_s {
+    unsigned short magic;
+    unsigned short crc;
+    unsigned short crcInv;
+    unsigned short reserved;
+};
+static bool eepromReady = false;
+
 ///-----------------------------------------------------------------------------
 ///         DMP related structs --  End
 ///-----------------------------------------------------------------------------
@@ -122,10 +134,81 @@ static inline unsigned short inv_orientation_matrix_to_scalar(
     return scalar;
 }
 
+/**
+ * Get CRC of DMP image configured by the last cold start
+ * @param crc CRC of program area of DMP memory
+ * @return true if a valid record was found in EEPROM
+ */
+static bool dmp_image_load(unsigned short *crc)
+{
+    struct dmp_image_s rec;
+
+    if (!eepromReady)
+        eepromReady = (HAL_EEPROM_Init() == HAL_OK);
+    if (!eepromReady)
+        return false;
+
+    if (HAL_EEPROM_Read(MPU_DMP_EEPROM_ADDR, (uint32_t*)&rec,
+                        sizeof(rec)) != HAL_OK)
+        return false;
+    if ((rec.magic != DMP_IMAGE_MAGIC) || (rec.crc != (unsigned short)~rec.crcInv))
+        return false;
+
+    *crc = rec.crc;
+    return true;
+}
+
+/**
+ * Store CRC of DMP image after a cold start
+ * Record is written only when it changes, i.e. when firmware or DMP
+ * configuration changed, not on every start.
+ * @param crc CRC of program area of DMP memory
+ */
+static void dmp_image_save(unsigned short crc)
+{
+    struct dmp_image_s rec;
+    unsigned short stored;
+
+    if (dmp_image_load(&stored) && (stored == crc))
+        return;
+    if (!eepromReady)
+        return;
+
+    rec.magic = DMP_IMAGE_MAGIC;
+    rec.crc = crc;
+    rec.crcInv = ~crc;
+    rec.reserved = 0;
+    HAL_EEPROM_Write(MPU_DMP_EEPROM_ADDR, (uint32_t*)&rec, sizeof(rec));
+}
+
 ///-----------------------------------------------------------------------------
 ///         DMP related functions --  End
 ///-----------------------------------------------------------------------------
 
+/**
+ * Interrupt handler for data-ready signal of MPU on PA5
+ * DMP raises the interrupt for every packet it puts into FIFO, so packet is
+ * read and processed right after it's produced. Time from interrupt until the
+ * packet is processed is recorded in statistics.
+ */
+void MPUDataHandler(void)
+{
+    MPU9250 &mpu = MPU9250::GetI();
+    uint32_t t = HAL_TS_GetTimeUS(), lat;
+    uint32_t packets = mpu._stats.packets;
+
+    HAL_MPU_IntClear();
+    mpu.ReadSensorData();
+
+    if (mpu._stats.packets != packets)
+    {
+        lat = HAL_TS_GetTimeUS() - t;
+        mpu._stats.latLast = lat;
+        if (lat > mpu._stats.latMax)
+            mpu._stats.latMax = lat;
+    }
+}
+
 
 ///-----------------------------------------------------------------------------
 ///         Functions for returning static instance                     [PUBLIC]
@@ -177,89 +260,227 @@ int8_t MPU9250::InitHW()
  */
 int8_t MPU9250::InitSW()
 {
-    int result;
+    uint32_t start;
 
-    //  Power cycle MPU chip on every SW initialization
+    //  Power cycle MPU chip on every SW initialization. Supply has to
+    //  discharge while switched off, which can't be polled for
     HAL_MPU_PowerSwitch(false);
     HAL_DelayUS(20000);
     HAL_MPU_PowerSwitch(true);
-    HAL_DelayUS(30000);
+    start = HAL_TS_GetTimeUS();
 
-    mpu_init(&int_param);
+    return _InitDMP(false, start);
+}
 
-    //  Get/set hardware configuration. Start gyro.
-    // Wake up all sensors.
-    mpu_set_sensors(INV_XYZ_GYRO | INV_XYZ_ACCEL | INV_XYZ_COMPASS);
-    // Push accel and quaternion data into the FIFO.
-    mpu_configure_fifo(INV_XYZ_ACCEL);
-    mpu_set_sample_rate(50);
+/**
+ * Initialize MPU sensor keeping DMP firmware that's already loaded in it
+ * Meant for a restart of the MCU alone (e.g. by watchdog) while the MPU stayed
+ * powered, power cycle and firmware upload are skipped. Firmware is kept only
+ * if DMP is still running and program area of its memory matches CRC taken at
+ * the last InitSW(), i.e. same firmware configured the same way. Sensors and
+ * DMP are then configured again and FIFO is reset, so reading resumes with
+ * the next packet.
+ * @return MPU_SUCCESS if firmware was kept, MPU_ERROR if InitSW() has to be
+ *         called instead
+ */
+int8_t MPU9250::WarmStart()
+{
+    return _InitDMP(true, HAL_TS_GetTimeUS());
+}
 
-    // Initialize HAL state variables.
-    memset(&hal, 0, sizeof(hal));
-#ifdef __DEBUG_SESSION__
-    DEBUG_WRITE("Trying to load firmware\n");
-#endif
-    result = 7; //  Try loading firmware max 7 times
-    while(result--)
-        if (dmp_load_motion_driver_firmware() == 0)
-            break;
-#ifdef __DEBUG_SESSION__
-        else
-            DEBUG_WRITE("%d,  ", result);
-#endif
+/**
+ * Trigger software reset of the MPU module by writing into corresponding
+ * register. Returns once the sensor has come out of reset.
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Reset()
+{
+    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 1 << 7);
+    if (mpu_wait_ready(100))
+        return MPU_ERROR;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get time it took the MPU to start up in last call to InitSW()
+ * Measured from power-on until the first DMP packet, including firmware upload
+ * (from the call until the first packet for WarmStart())
+ * @return Boot time in us, 0 if MPU wasn't initialized
+ */
+uint32_t MPU9250::BootTime()
+{
+    return _bootTime;
+}
+
+/**
+ * Control power supply of the MPU9250
+ * Enable or disable power supply of the MPU9250 using external MOSFET
+ * @param en Power state
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Enabled(bool en)
+{
+    HAL_MPU_PowerSwitch(en);
+
+    return MPU_SUCCESS;
+}
 
-    if (result <= 0)    //  If loading failed 7 times hang here, DMP not usable
+/**
+ * Set output rate of DMP (rate of quaternions put into FIFO)
+ * Can be called before InitSW(), rate is then applied once firmware is loaded
+ * @param rate Output rate in Hz, 1 to MPU_DMP_MAX_RATE
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetDMPRate(uint16_t rate)
+{
+    int8_t retVal = MPU_SUCCESS;
+
+    if ((rate == 0) || (rate > MPU_DMP_MAX_RATE))
+        return MPU_ERROR;
+
+    _dmpRate = rate;
+    if (hal.dmp_on)
     {
-#ifdef __DEBUG_SESSION__
-        DEBUG_WRITE("   >failed\n");
-#endif
-        //  Hang here if unable to load the firmware
-        while(1);
+        if (_intMode)
+            HAL_MPU_IntEnable(false);
+        if (dmp_set_fifo_rate(rate))
+            retVal = MPU_ERROR;
+        _SetupMag();
+        //  Start from empty FIFO, reading also releases latched INT pin
+        mpu_reset_fifo();
+        if (_intMode)
+            HAL_MPU_IntEnable(true);
     }
 
-#ifdef __DEBUG_SESSION__
-    DEBUG_WRITE(" >Firmware loaded\n");
-    DEBUG_WRITE(" >Updating DMP features...");
-#endif
-    dmp_set_orientation(inv_orientation_matrix_to_scalar(gyro_orientation));
+    return retVal;
+}
 
-    hal.dmp_features = DMP_FEATURE_6X_LP_QUAT | DMP_FEATURE_TAP |
-        DMP_FEATURE_ANDROID_ORIENT | DMP_FEATURE_SEND_RAW_ACCEL | DMP_FEATURE_SEND_CAL_GYRO |
-        DMP_FEATURE_GYRO_CAL;
-    dmp_enable_feature(hal.dmp_features);
+/**
+ * Change bandwidth of the digital low-pass filter of gyro at runtime
+ * DMP samples sensors at 200Hz, so bandwidths above 100Hz only add noise.
+ * Call after InitSW().
+ * @param cfg DLPF_CFG, 1 (188Hz) to 6 (5Hz)
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetDLPF(uint8_t cfg)
+{
+    //  Driver takes bandwidth in Hz and picks DLPF_CFG with it
+    static const uint16_t bandwidth[6] = { 188, 98, 42, 20, 10, 5 };
+    int8_t retVal = MPU_SUCCESS;
+
+    if ((cfg < 1) || (cfg > 6))
+        return MPU_ERROR;
+
+    //  Bus is shared with FIFO reads from interrupt. Packet produced meanwhile
+    //  keeps INT pin latched high, HAL_MPU_IntEnable() then reads it at once
+    if (_intMode)
+        HAL_MPU_IntEnable(false);
+    if (mpu_set_lpf(bandwidth[cfg - 1]))
+        retVal = MPU_ERROR;
+    if (_intMode)
+        HAL_MPU_IntEnable(true);
+
+    return retVal;
+}
 
-    dmp_set_fifo_rate(20);//50
-    mpu_set_dmp_state(1);
-    hal.dmp_on = 1;
-#ifdef __DEBUG_SESSION__
-    DEBUG_WRITE("done\n");
-#endif
+/**
+ * Enable or disable reading of DMP output from data-ready interrupt (PA5)
+ * When enabled, FIFO is read from interrupt as soon as DMP produces a packet,
+ * ReadSensorData() shouldn't be called from main loop then. Call after
+ * InitSW().
+ * @param en true to read sensor from interrupt, false to poll it
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::InterruptMode(bool en)
+{
+    HAL_MPU_IntEnable(false);
+    _intMode = en;
+    if (!en)
+        return MPU_SUCCESS;
+
+    HAL_MPU_IntInit(MPUDataHandler);
+    //  Start from empty FIFO. Reading registers also releases latched INT pin
+    //  so the next packet makes a rising edge
+    if (mpu_reset_fifo())
+    {
+        _intMode = false;
+        return MPU_ERROR;
+    }
+    HAL_MPU_IntEnable(true);
 
     return MPU_SUCCESS;
 }
 
 /**
- * Trigger software reset of the MPU module by writing into corresponding
- * register. Wait for 50ms afterwards for sensor to start up.
+ * Get statistics of reading DMP output
+ * Safe to call while FIFO is read from interrupt.
+ * @param stats Buffer to copy statistics into
+ * @param reset If true, statistics start over from the next read of FIFO
  * @return One of MPU_* error codes
  */
-int8_t MPU9250::Reset()
+int8_t MPU9250::Stats(MPUStats *stats, bool reset)
 {
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 1 << 7);
-    HAL_DelayUS(50000);
+    uint32_t reads;
+
+    //  Copy again if FIFO was read while copying
+    do
+    {
+        reads = _stats.reads;
+        memcpy((void*)stats, (void*)&_stats, sizeof(MPUStats));
+    } while (reads != _stats.reads);
+
+    if (reset)
+        _statsReset = true;
 
     return MPU_SUCCESS;
 }
 
 /**
- * Control power supply of the MPU9250
- * Enable or disable power supply of the MPU9250 using external MOSFET
- * @param en Power state
+ * Configure yaw correction of DMP output using magnetometer
+ * DMP uses only accelerometer and gyroscope, so its yaw drifts. Correction
+ * pulls it towards heading of tilt-compensated magnetic field, with given
+ * time constant. Roll and pitch are not affected. Magnetometer should be
+ * calibrated (SetMagCalibration) for correct heading.
+ * @param tau Time constant of correction in seconds, 0 to disable it
  * @return One of MPU_* error codes
  */
-int8_t MPU9250::Enabled(bool en)
+int8_t MPU9250::SetupMagYaw(float tau)
 {
-    HAL_MPU_PowerSwitch(en);
+    if (tau < 0.0f)
+        return MPU_ERROR;
+
+    _magTau = tau;
+    _SetupMag();
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Set magnetometer calibration, m_cal = softIron * (m_raw - offset)
+ * @param offset Hard-iron offset in raw units [x,y,z] (magnetometer axes)
+ * @param softIron 3x3 soft-iron correction matrix
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetMagCalibration(const float *offset,
+                                  const float softIron[3][3])
+{
+    memcpy((void*)_magOffset, (void*)offset, sizeof(_magOffset));
+    memcpy((void*)_magSoftIron, (void*)softIron, sizeof(_magSoftIron));
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Copy magnetometer calibration in use to user-provided buffers
+ * @param offset Buffer of size 3 to hold hard-iron offset in raw units
+ * @param softIron 3x3 matrix to hold soft-iron correction
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::GetMagCalibration(float *offset, float softIron[3][3])
+{
+    memcpy((void*)offset, (void*)_magOffset, sizeof(_magOffset));
+    memcpy((void*)softIron, (void*)_magSoftIron, sizeof(_magSoftIron));
 
     return MPU_SUCCESS;
 }
@@ -294,76 +515,112 @@ uint8_t MPU9250::GetID()
  */
 int8_t MPU9250::ReadSensorData()
 {
-    int8_t retVal = MPU_ERROR;
-    short gyro[3], accel[3], sensors;
-    unsigned char more = 1;
+    int8_t retVal = MPU_SUCCESS;
+    short gyro[3], accel[3], sensors, newest = 0;
+    unsigned short count, more = 1, packets = 0;
     long quat[4];
-    unsigned long sensor_timestamp;
     int cnt = 0;
 
+    if (_statsReset)
+    {
+        memset((void*)&_stats, 0, sizeof(MPUStats));
+        _statsReset = false;
+    }
+    _stats.reads++;
+
+    //  Make sure the fifo is empty before leaving this loop, in order to
+    //  prevent fifo overflow on consecutive sensor reading. Each call reads
+    //  all packets in the fifo (up to the size of driver's buffer) in one
+    //  burst, so normally a single call empties it
+    while (more && (cnt < 4))
+    {
+        /* The FIFO can contain any combination of gyro, accel, quaternion,
+         * and gesture data. The driver parses the gesture data of every
+         * packet and calls registered callbacks on gesture events, while
+         * only the newest packet is returned. The sensors parameter tells
+         * which data fields were populated, more is non-zero if there are
+         * leftover packets in the FIFO.
+         */
+        cnt++;
+        if (dmp_read_fifo_batch(gyro, accel, quat, &sensors, &count, &more))
+        {
+            //  Only counted, this can run from interrupt and nothing printed
+            //  (or sent as telemetry) may preempt the main loop's output
+            _stats.errors++;
+            retVal = MPU_ERROR;
+            break;
+        }
+        newest |= sensors;
+        _stats.packets += count;
+        packets += count;
+        //  Packets waiting in FIFO when it was first read
+        if (cnt == 1)
+        {
+            _stats.fifoLast = count + more;
+            if (_stats.fifoLast > _stats.fifoMax)
+                _stats.fifoMax = _stats.fifoLast;
+            if (_stats.fifoLast > 1)
+                _stats.late++;
+        }
+    }
 
-     //  Make sure the fifo is empty before leaving this loop, in
-     //  order to prevent fifo overflow on consecutive sensor reading
-     while (cnt < 100)   //Read max 100 packets, if there's more we
-                         //   have a problem
-     {
-         /* This function gets new data from the FIFO when the DMP is in
-           * use. The FIFO can contain any combination of gyro, accel,
-           * quaternion, and gesture data. The sensors parameter tells the
-           * caller which data fields were actually populated with new data.
-           * For example, if sensors == (INV_XYZ_GYRO | INV_WXYZ_QUAT), then
-           * the FIFO isn't being filled with accel data.
-           * The driver parses the gesture data to determine if a gesture
-           * event has occurred; on an event, the application will be notified
-           * via a callback (assuming that a callback function was properly
-           * registered). The more parameter is non-zero if there are
-           * leftover packets in the FIFO.
-           */
-         retVal = dmp_read_fifo(gyro, accel, quat, &sensor_timestamp, &sensors, &more);
-         cnt++;
-#ifdef __DEBUG_SESSION__
-         if (retVal == (-2))
-             DEBUG_WRITE("READ_FIFO returned: %d \n", retVal);
-#endif  /* __DEBUG_SESSION__ */
+    //  Output buffers hold newest packet read, if there was one
+    if (!(newest & INV_WXYZ_QUAT))
+        return retVal;
 
-         if (sensors == 0)   //No data available
-         {
-             retVal = MPU_SUCCESS;
-             break;
-         }
+    //  Extract orientation data, only once for the newest packet. DMP gives
+    //  quaternion as [w,x,y,z]
+    float q[4];
+    for (uint8_t i = 0; i < 4; i++)
+        q[i] = (float)quat[i]/QUAT_SENS;
 
-         //  If reading fifo returned error, move to next packet
-         if (retVal)
-             continue;
+    //  Correct yaw whenever there's a new magnetometer sample. Packets are
+    //  counted rather than reads, as one read can drain several of them
+    //  (polling mode)
+    if (_magEn)
+    {
+        if (packets < (unsigned short)(_magDiv - _magCnt))
+            _magCnt += packets;
+        else
+        {
+            _magCnt = 0;
+            if (_ReadMag() == MPU_SUCCESS)
+                _magYaw.Update(q, (float*)_mag);
+        }
+    }
+    _magYaw.Apply(q, q);
 
-         //  If there was no error, extract orientation data
-         Quaternion qt;
-         qt.x = (float)quat[0]/QUAT_SENS;
-         qt.y = (float)quat[1]/QUAT_SENS;
-         qt.z = (float)quat[2]/QUAT_SENS;
-         qt.w = (float)quat[3]/QUAT_SENS;
+    ::Quaternion qt;
+    qt.w = q[0];
+    qt.x = q[1];
+    qt.y = q[2];
+    qt.z = q[3];
 
-         VectorFloat v;
-         dmp_GetGravity(&v, &qt);
+    VectorFloat v;
+    dmp_GetGravity(&v, &qt);
 
-         dmp_GetYawPitchRoll((float*)(_ypr), &qt, &v);
+    dmp_GetYawPitchRoll((float*)(_ypr), &qt, &v);
 
-         _quat[0] = qt.x;
-         _quat[1] = qt.y;
-         _quat[2] = qt.z;
-         _quat[3] = qt.w;
+    _quatSeq++;
+    _quat[0] = qt.w;
+    _quat[1] = qt.x;
+    _quat[2] = qt.y;
+    _quat[3] = qt.z;
+    _quatSeq++;
 
-         //  Copy to MPU class
-         _gv[0] = v.x;
-         _gv[1] = v.y;
-         _gv[2] = v.z;
+    //  Copy to MPU class
+    _gv[0] = v.x;
+    _gv[1] = v.y;
+    _gv[2] = v.z;
 
-         _acc[0] = (float)accel[0]/32767.0;
-         _acc[1] = (float)accel[1]/32767.0;
-         _acc[2] = (float)accel[2]/32767.0;
-     }
+    if (newest & INV_XYZ_ACCEL)
+    {
+        _acc[0] = (float)accel[0]/32767.0;
+        _acc[1] = (float)accel[1]/32767.0;
+        _acc[2] = (float)accel[2]/32767.0;
+    }
 
-     return retVal;
+    return retVal;
 }
 
 /**
@@ -413,13 +670,250 @@ int8_t MPU9250::Gyroscope(float *gyro)
 /**
  * Copy mag. field strength from internal buffer to user-provided one
  * @param mag Pointer a float array of min. size 3 to store 3-axis mag. field
- *        strength data
+ *        strength data in mG, in accelerometer/gyroscope axes
  * @return One of MPU_* error codes
  */
 int8_t MPU9250::Magnetometer(float *mag)
 {
-    //  Not available
-    mag[0] = mag[1] = mag[2] = 0.0f;
+    memcpy((void*)mag, (void*)_mag, sizeof(float)*3);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Copy attitude quaternion from internal buffer to user-provided one
+ * Quaternion is copied as a whole, never mixing two updates. Don't call from
+ * an interrupt that can preempt ReadSensorData().
+ * @param q Pointer to float buffer of size 4 to hold quaternion [w,x,y,z],
+ *        rotation from body to world frame
+ * @param seq Optional buffer to hold sequence number of the quaternion, it
+ *        changes with every update
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Quaternion(float *q, uint32_t *seq)
+{
+    uint32_t s;
+
+    //  Copy again if attitude was updated while copying
+    do
+    {
+        s = _quatSeq;
+        for (uint8_t i = 0; i < 4; i++)
+            q[i] = _quat[i];
+    } while ((s & 1) || (s != _quatSeq));
+
+    if (seq != 0)
+        *seq = s;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get attitude as rotation matrix, v_world = R * v_body
+ * Computed from a snapshot of quaternion, without any trigonometry.
+ * @param R 3x3 matrix to hold rotation from body to world frame
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::RotationMatrix(float R[3][3])
+{
+    float q[4];
+
+    Quaternion(q);
+    R[0][0] = 1.0f - 2.0f*(q[2]*q[2] + q[3]*q[3]);
+    R[0][1] = 2.0f*(q[1]*q[2] - q[0]*q[3]);
+    R[0][2] = 2.0f*(q[1]*q[3] + q[0]*q[2]);
+    R[1][0] = 2.0f*(q[1]*q[2] + q[0]*q[3]);
+    R[1][1] = 1.0f - 2.0f*(q[1]*q[1] + q[3]*q[3]);
+    R[1][2] = 2.0f*(q[2]*q[3] - q[0]*q[1]);
+    R[2][0] = 2.0f*(q[1]*q[3] - q[0]*q[2]);
+    R[2][1] = 2.0f*(q[2]*q[3] + q[0]*q[1]);
+    R[2][2] = 1.0f - 2.0f*(q[1]*q[1] + q[2]*q[2]);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get direction of gravity in body frame, computed from a snapshot of
+ * quaternion. This is world z axis (up) seen from body, as measured by
+ * accelerometer at rest: [0,0,1] when level.
+ * @param g Pointer to float buffer of size 3 to hold unit gravity vector
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Gravity(float *g)
+{
+    float q[4];
+
+    Quaternion(q);
+    g[0] = 2.0f*(q[1]*q[3] - q[0]*q[2]);
+    g[1] = 2.0f*(q[2]*q[3] + q[0]*q[1]);
+    g[2] = 1.0f - 2.0f*(q[1]*q[1] + q[2]*q[2]);
+
+    return MPU_SUCCESS;
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Initialize MPU sensor and DMP once MPU is powered
+ * @param warm True to keep DMP firmware loaded in MPU (see WarmStart()),
+ *        false to reset the chip and load firmware
+ * @param start Time when initialization started, for measuring boot time
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::_InitDMP(bool warm, uint32_t start)
+{
+    int result;
+    short status;
+    unsigned short crc;
+
+    if (warm)
+    {
+        //  Without a record of the image there's nothing to verify it with
+        if (!dmp_image_load(&crc) || mpu_init_warm(&int_param))
+            return MPU_ERROR;
+    }
+    //  Wait only until chip responds instead of worst-case start-up time
+    else if (mpu_wait_ready(100) || mpu_init(&int_param))
+    {
+#ifdef __DEBUG_SESSION__
+        DEBUG_WRITE("MPU not responding\n");
+#endif
+        return MPU_ERROR;
+    }
+
+    //  Get/set hardware configuration. Start gyro.
+    // Wake up all sensors.
+    mpu_set_sensors(INV_XYZ_GYRO | INV_XYZ_ACCEL | INV_XYZ_COMPASS);
+    //  INT pin active high and latched until any register is read, so every
+    //  DMP packet makes a rising edge on PA5 and HAL_MPU_DataAvail() stays
+    //  true until the packet is read. Set after sensors, as mpu_set_sensors
+    //  turns latching off
+    mpu_set_int_level(0);
+    mpu_set_int_latched(1);
+    // Push accel and quaternion data into the FIFO.
+    mpu_configure_fifo(INV_XYZ_ACCEL);
+    mpu_set_sample_rate(50);
+
+    // Initialize HAL state variables.
+    memset(&hal, 0, sizeof(hal));
+    if (!warm)
+    {
+#ifdef __DEBUG_SESSION__
+        DEBUG_WRITE("Trying to load firmware\n");
+#endif
+        result = 7; //  Try loading firmware max 7 times
+        while(result--)
+            if (dmp_load_motion_driver_firmware() == 0)
+                break;
+#ifdef __DEBUG_SESSION__
+            else
+                DEBUG_WRITE("%d,  ", result);
+#endif
+
+        if (result <= 0)    //  If loading failed 7 times hang here, DMP not usable
+        {
+#ifdef __DEBUG_SESSION__
+            DEBUG_WRITE("   >failed\n");
+#endif
+            //  Hang here if unable to load the firmware
+            while(1);
+        }
+    }
+
+#ifdef __DEBUG_SESSION__
+    DEBUG_WRITE(" >Firmware loaded\n");
+    DEBUG_WRITE(" >Updating DMP features...");
+#endif
+    dmp_set_orientation(inv_orientation_matrix_to_scalar(gyro_orientation));
+
+    hal.dmp_features = DMP_FEATURE_6X_LP_QUAT | DMP_FEATURE_TAP |
+        DMP_FEATURE_ANDROID_ORIENT | DMP_FEATURE_SEND_RAW_ACCEL | DMP_FEATURE_SEND_CAL_GYRO |
+        DMP_FEATURE_GYRO_CAL;
+    dmp_enable_feature(hal.dmp_features);
+
+    //  DMP raises interrupt for every packet put into FIFO
+    dmp_set_fifo_rate(_dmpRate);
+    dmp_set_interrupt_mode(DMP_INT_CONTINUOUS);
+
+    //  Program area now holds firmware with its configuration. On warm start
+    //  it must be as left by the last cold start, after a cold start it's
+    //  remembered for the next warm one
+    if (warm)
+    {
+        if (dmp_verify_motion_driver_firmware(crc))
+            return MPU_ERROR;
+    }
+    else if (dmp_get_firmware_crc(&crc) == 0)
+        dmp_image_save(crc);
+
+    mpu_set_dmp_state(1);
+    hal.dmp_on = 1;
+    //  Magnetometer is read by MPU into its registers (through SLV0) at max.
+    //  rate, it's fetched from there at that rate along with DMP packets
+    mpu_set_compass_sample_rate(100);
+    _SetupMag();
+
+    //  Boot is complete with the first DMP packet, wait for it at most a few
+    //  packet periods
+    do
+    {
+        if (!mpu_get_int_status(&status) && (status & MPU_INT_STATUS_DMP))
+            break;
+        HAL_DelayUS(100);
+    }
+    while ((HAL_TS_GetTimeUS() - start) < 100000);
+    _bootTime = HAL_TS_GetTimeUS() - start;
+#ifdef __DEBUG_SESSION__
+    DEBUG_WRITE("done\n");
+#endif
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Configure reading of magnetometer and yaw correction for current DMP rate
+ */
+void MPU9250::_SetupMag()
+{
+    unsigned short rate = 0, fsr = 0;
+
+    //  Read magnetometer every packet, or less often if DMP is faster
+    if (mpu_get_compass_sample_rate(&rate) || (rate == 0))
+        rate = _dmpRate;
+    _magDiv = (_dmpRate > rate) ? (_dmpRate / rate) : 1;
+    _magCnt = 0;
+
+    //  Full-scale range in uT spans 16-bit output
+    if (mpu_get_compass_fsr(&fsr) == 0)
+        _magScale = (float)fsr * 10.0f / 32760.0f;
+
+    _magYaw.Setup(_magTau, (float)_dmpRate / (float)_magDiv);
+}
+
+/**
+ * Read magnetometer sample from MPU registers, apply calibration and store it
+ * in frame of DMP output (body frame)
+ * @return One of MPU_* error codes, MPU_ERROR if there's no new valid sample
+ */
+int8_t MPU9250::_ReadMag()
+{
+    short raw[3];
+    float m[3], c[3];
+    uint8_t i;
+
+    if (mpu_get_compass_reg(raw, 0))
+        return MPU_ERROR;
+
+    for (i = 0; i < 3; i++)
+        m[i] = (float)raw[i] - _magOffset[i];
+    for (i = 0; i < 3; i++)
+        c[i] = (_magSoftIron[i][0]*m[0] + _magSoftIron[i][1]*m[1]
+                + _magSoftIron[i][2]*m[2]) * _magScale;
+
+    for (i = 0; i < 3; i++)
+        _mag[i] = _magRot[i][0]*c[0] + _magRot[i][1]*c[1] + _magRot[i][2]*c[2];
 
     return MPU_SUCCESS;
 }
@@ -428,13 +922,47 @@ int8_t MPU9250::Magnetometer(float *mag)
 ///                      Class constructor & destructor              [PROTECTED]
 ///-----------------------------------------------------------------------------
 
-MPU9250::MPU9250() :  dT(0), _magEn(true)
+MPU9250::MPU9250() :  dT(0), _magEn(true), _bootTime(0),
+                      _dmpRate(MPU_DMP_RATE), _intMode(false),
+                      _statsReset(false), _magTau(0.0f), _magDiv(1),
+                      _magCnt(0), _magScale(1.5f)
 {
     //  Initialize arrays
     memset((void*)_ypr, 0, 3);
     memset((void*)_acc, 0, 3);
     memset((void*)_gyro, 0, 3);
     memset((void*)_mag, 0, 3);
+    memset((void*)&_stats, 0, sizeof(MPUStats));
+    _quat[0] = 1.0f;
+    _quat[1] = _quat[2] = _quat[3] = 0.0f;
+    _quatSeq = 0;
+    //  No magnetometer calibration
+    memset((void*)_magOffset, 0, sizeof(_magOffset));
+    memset((void*)_magSoftIron, 0, sizeof(_magSoftIron));
+    _magSoftIron[0][0] = _magSoftIron[1][1] = _magSoftIron[2][2] = 1.0f;
+
+    //  Magnetometer-to-body rotation: AK8963 axes into accel/gyro axes as
+    //  given by mountings in hwconfig.h (IMU'*MAG), followed by chip-to-body
+    //  rotation applied by DMP (gyro_orientation)
+    const int8_t imu[3] = { MPU_MOUNT_IMU }, mag[3] = { MPU_MOUNT_MAG };
+    float chip[3][3];
+    uint8_t i, j, k;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            chip[i][j] = 0.0f;
+            for (k = 0; k < 3; k++)
+                if ((AXIS_IDX(imu[k]) == i) && (AXIS_IDX(mag[k]) == j))
+                    chip[i][j] += AXIS_SIGN(imu[k]) * AXIS_SIGN(mag[k]);
+        }
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            _magRot[i][j] = 0.0f;
+            for (k = 0; k < 3; k++)
+                _magRot[i][j] += (float)gyro_orientation[3*i + k] * chip[k][j];
+        }
 }
 
 MPU9250::~MPU9250()
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <math.h>
 #include "libs/helper_3dmath.h"
+#include "libs/myLib.h"
 #include "HAL/hal.h"
 
 
@@ -550,6 +551,54 @@ static int setup_compass(void);
 #define MAX_COMPASS_SAMPLE_RATE (100)
 #endif
 
+/* Value of WHO_AM_I register once the chip responds. */
+#if defined __MPU9250
+#define WHO_AM_I_VALUE      (0x71)
+#elif defined __MPU6500
+#define WHO_AM_I_VALUE      (0x70)
+#else
+#define WHO_AM_I_VALUE      (0x68)
+#endif
+
+/**
+ *  @brief      Poll register until masked value matches.
+ *  Used in place of fixed worst-case delays, register is read every 100us.
+ *  @param[in]  reg         Register address.
+ *  @param[in]  mask        Bits to compare.
+ *  @param[in]  value       Expected value of masked bits.
+ *  @param[in]  timeout_ms  Max. time to wait.
+ *  @return     0 if register matched, -1 on timeout.
+ */
+static int poll_reg(unsigned char reg, unsigned char mask, unsigned char value,
+    unsigned short timeout_ms)
+{
+    unsigned char data;
+    unsigned long ii;
+
+    for (ii = 0; ii < (unsigned long)timeout_ms * 10; ii++) {
+        if (!i2c_read(st.hw->addr, reg, 1, &data) && ((data & mask) == value))
+            return 0;
+        HAL_DelayUS(100);
+    }
+    return -1;
+}
+
+/**
+ *  @brief      Wait until chip is powered up and out of reset.
+ *  Chip is ready once it answers with its ID and device reset bit has
+ *  cleared. Returns as soon as that happens, instead of waiting the worst-case
+ *  start-up time.
+ *  @param[in]  timeout_ms  Max. time to wait.
+ *  @return     0 if chip is ready, -1 on timeout.
+ */
+int mpu_wait_ready(unsigned short timeout_ms)
+{
+    /* ID is checked first, reads during reset can return all zeros. */
+    if (poll_reg(st.reg->who_am_i, 0xFF, WHO_AM_I_VALUE, timeout_ms))
+        return -1;
+    return poll_reg(st.reg->pwr_mgmt_1, BIT_RESET, 0, timeout_ms);
+}
+
 /**
  *  @brief      Enable/disable data ready interrupt.
  *  If the DMP is on, the DMP interrupt is enabled. Otherwise, the data ready
@@ -621,28 +670,14 @@ int mpu_read_reg(unsigned char reg, unsigned char *data)
 }
 
 /**
- *  @brief      Initialize hardware.
- *  Initial configuration:\n
- *  Gyro FSR: +/- 2000DPS\n
- *  Accel FSR +/- 2G\n
- *  DLPF: 42Hz\n
- *  FIFO rate: 50Hz\n
- *  Clock source: Gyro PLL\n
- *  FIFO: Disabled.\n
- *  Data ready interrupt: Disabled, active low, unlatched.
- *  @param[in]  int_param   Platform-specific parameters to interrupt API.
+ *  @brief      Bring chip into initial configuration once it's awake.
+ *  Common part of @e mpu_init and @e mpu_init_warm, DMP memory isn't touched.
  *  @return     0 if successful.
  */
-int mpu_init(struct int_param_s *int_param)
+static int init_chip(void)
 {
     unsigned char data[6];
 
-    /* Reset device. */
-    data[0] = BIT_RESET;
-    if (i2c_write(st.hw->addr, st.reg->pwr_mgmt_1, 1, data))
-        return -1;
-    delay_ms(100);
-
     /* Wake up chip. */
     data[0] = 0x00;
     if (i2c_write(st.hw->addr, st.reg->pwr_mgmt_1, 1, data))
@@ -693,9 +728,6 @@ int mpu_init(struct int_param_s *int_param)
     if (mpu_configure_fifo(0))
         return -1;
 
-    /*if (int_param)
-        reg_int_cb(int_param);*/
-
 #ifdef AK89xx_SECONDARY
     setup_compass();
     if (mpu_set_compass_sample_rate(10))
@@ -710,6 +742,69 @@ int mpu_init(struct int_param_s *int_param)
     return 0;
 }
 
+/**
+ *  @brief      Initialize hardware.
+ *  Initial configuration:\n
+ *  Gyro FSR: +/- 2000DPS\n
+ *  Accel FSR +/- 2G\n
+ *  DLPF: 42Hz\n
+ *  FIFO rate: 50Hz\n
+ *  Clock source: Gyro PLL\n
+ *  FIFO: Disabled.\n
+ *  Data ready interrupt: Disabled, active low, unlatched.
+ *  @param[in]  int_param   Platform-specific parameters to interrupt API.
+ *  @return     0 if successful.
+ */
+int mpu_init(struct int_param_s *int_param)
+{
+    unsigned char data[6];
+
+    /* Reset device. */
+    data[0] = BIT_RESET;
+    if (i2c_write(st.hw->addr, st.reg->pwr_mgmt_1, 1, data))
+        return -1;
+    if (mpu_wait_ready(100))
+        return -1;
+
+    /*if (int_param)
+        reg_int_cb(int_param);*/
+
+    return init_chip();
+}
+
+/**
+ *  @brief      Initialize hardware without resetting the chip.
+ *  Used when only the host was restarted while the chip stayed powered and
+ *  kept running the DMP. Chip is brought into the same configuration as by
+ *  @e mpu_init, but DMP memory is preserved. DMP is stopped and is only
+ *  enabled again once the image is checked with @e mpu_verify_firmware.
+ *  @param[in]  int_param   Platform-specific parameters to interrupt API.
+ *  @return     0 if successful, -1 if chip doesn't respond or isn't running
+ *              the DMP (e.g. it was power-cycled).
+ */
+int mpu_init_warm(struct int_param_s *int_param)
+{
+    unsigned char data;
+
+    /* Chip is already running, it either answers right away or not at all. */
+    if (mpu_wait_ready(10))
+        return -1;
+    /* DMP is disabled after power-on, so if it's enabled memory is kept. */
+    if (i2c_read(st.hw->addr, st.reg->user_ctrl, 1, &data))
+        return -1;
+    if (!(data & BIT_DMP_EN))
+        return -1;
+
+    /* Stop the DMP while chip is reconfigured. */
+    data = 0;
+    if (i2c_write(st.hw->addr, st.reg->int_enable, 1, &data))
+        return -1;
+    if (i2c_write(st.hw->addr, st.reg->user_ctrl, 1, &data))
+        return -1;
+
+    return init_chip();
+}
+
 /**
  *  @brief      Enter low-power accel-only mode.
  *  In low-power accel mode, the chip goes to sleep and only wakes up to sample
@@ -1084,7 +1179,9 @@ int mpu_reset_fifo(void)
         data = BIT_FIFO_RST | BIT_DMP_RST;
         if (i2c_write(st.hw->addr, st.reg->user_ctrl, 1, &data))
             return -1;
-        delay_ms(50);
+        /* Reset bits clear themselves once reset is done. */
+        if (poll_reg(st.reg->user_ctrl, BIT_FIFO_RST | BIT_DMP_RST, 0, 50))
+            return -1;
         data = BIT_DMP_EN | BIT_FIFO_EN;
         if (st.chip_cfg.sensors & INV_XYZ_COMPASS)
             data |= BIT_AUX_IF_EN;
@@ -1633,7 +1730,12 @@ int mpu_set_sensors(unsigned char sensors)
 
     st.chip_cfg.sensors = sensors;
     st.chip_cfg.lp_accel_mode = 0;
-    delay_ms(50);
+    /* Wait for the first sample instead of a fixed 50ms start-up time. If the
+     * data-ready flag never shows up, the full 50ms have passed anyway.
+     */
+    if (sensors)
+        poll_reg(st.reg->int_status, MPU_INT_STATUS_DATA_READY,
+            MPU_INT_STATUS_DATA_READY, 50);
     return 0;
 }
 
@@ -1785,6 +1887,54 @@ int mpu_read_fifo_stream(unsigned short length, unsigned char *data,
     return 0;
 }
 
+/**
+ *  @brief      Get all complete packets from the FIFO in one burst.
+ *  Same as mpu_read_fifo_stream, but FIFO count is read only once and every
+ *  complete packet that fits into the buffer is read in a single transaction.
+ *  @param[in]  length  Length of one packet.
+ *  @param[in]  size    Size of data buffer in bytes.
+ *  @param[out] data    FIFO data, count packets of given length.
+ *  @param[out] count   Number of packets read, 0 if there's no full packet.
+ *  @param[out] more    Number of packets left in FIFO.
+ *  @return     0 if successful.
+ */
+int mpu_read_fifo_batch(unsigned short length, unsigned short size,
+    unsigned char *data, unsigned short *count, unsigned short *more)
+{
+    unsigned char tmp[2];
+    unsigned short fifo_count, packets;
+
+    count[0] = more[0] = 0;
+    if (!st.chip_cfg.dmp_on)
+        return -4;
+    if (!st.chip_cfg.sensors)
+        return -5;
+    if (!length || (size < length))
+        return -1;
+
+    if (i2c_read(st.hw->addr, st.reg->fifo_count_h, 2, tmp))
+        return -1;
+    fifo_count = (tmp[0] << 8) | tmp[1];
+    if (fifo_count > (st.hw->max_fifo >> 1)) {
+        /* FIFO is 50% full, better check overflow bit. */
+        if (i2c_read(st.hw->addr, st.reg->int_status, 1, tmp))
+            return -1;
+        if (tmp[0] & BIT_FIFO_OVERFLOW) {
+            mpu_reset_fifo();
+            return -2;
+        }
+    }
+
+    packets = min(fifo_count / length, size / length);
+    if (!packets)
+        return 0;
+    if (i2c_read(st.hw->addr, st.reg->fifo_r_w, packets * length, data))
+        return -1;
+    count[0] = packets;
+    more[0] = fifo_count / length - packets;
+    return 0;
+}
+
 /**
  *  @brief      Set device to bypass mode.
  *  @param[in]  bypass_on   1 to enable bypass mode.
@@ -2786,8 +2936,43 @@ int mpu_read_mem(unsigned short mem_addr, unsigned short length,
     return 0;
 }
 
+/* Max. size of a chunk of DMP memory accessed at once, must not be larger
+ * than st.hw->bank_size.
+ */
+#define LOAD_CHUNK  (256)
+
+/**
+ *  @brief      Compute CRC of a part of DMP memory.
+ *  Memory is read in chunks aligned to DMP memory banks, so each bank takes
+ *  one read.
+ *  @param[in]  mem_addr    First address to read.
+ *  @param[in]  length      Number of bytes to read.
+ *  @param[out] crc         CRC16 of memory content.
+ *  @return     0 if successful.
+ */
+int mpu_mem_crc(unsigned short mem_addr, unsigned short length,
+    unsigned short *crc)
+{
+    unsigned short ii;
+    unsigned short this_read;
+    /* Buffer is static as it doesn't fit on the stack. */
+    static unsigned char cur[LOAD_CHUNK];
+
+    crc[0] = 0xFFFF;
+    for (ii = mem_addr; ii < mem_addr + length; ii += this_read) {
+        this_read = min(LOAD_CHUNK - (ii % LOAD_CHUNK), mem_addr + length - ii);
+        if (mpu_read_mem(ii, this_read, cur))
+            return -1;
+        crc[0] = crc16(crc[0], cur, this_read);
+    }
+    return 0;
+}
+
 /**
  *  @brief      Load and verify DMP image.
+ *  Image is written in chunks aligned to DMP memory banks, so each bank takes
+ *  one write. Whole image is then read back once and verified against CRC of
+ *  the image.
  *  @param[in]  length      Length of DMP image.
  *  @param[in]  firmware    DMP code.
  *  @param[in]  start_addr  Starting address of DMP code memory.
@@ -2799,9 +2984,8 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
 {
     unsigned short ii;
     unsigned short this_write;
-    /* Must divide evenly into st.hw->bank_size to avoid bank crossings. */
-#define LOAD_CHUNK  (16)
-    unsigned char cur[LOAD_CHUNK], tmp[2];
+    unsigned short crc;
+    unsigned char tmp[2];
 
     if (st.chip_cfg.dmp_loaded)
         /* DMP should only be loaded once. */
@@ -2810,30 +2994,21 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
     if (!firmware)
         return -1;
     //  It was noted that after each operation on DSP memory through mpu_*_mem(),
-    //  a small delay is required in order for MPU to work properly
-    //  TODO: Find better solution than delays
+    //  a small delay is required in order for MPU to work properly, that
+    //  delay is in mpu_write_mem()/mpu_read_mem()
     for (ii = 0; ii < length; ii += this_write) {
-        this_write = min(LOAD_CHUNK, length - ii);
-
-        //  Read current data in memory block
-        mpu_read_mem(ii, this_write, cur);
-        //HAL_DelayUS(100);
-        //  If block already has firmware, skip uploading that block
-        if (!memcmp(firmware+ii, cur, this_write))
-            continue;
-        //  Upload firmware chunk into memory block
+        //  Write up to the end of the current bank
+        this_write = min(LOAD_CHUNK - (ii % LOAD_CHUNK), length - ii);
         if (mpu_write_mem(ii, this_write, (unsigned char*)&firmware[ii]))
             return -1;
-        //HAL_DelayUS(100);
-        //  Read memory block
-        if (mpu_read_mem(ii, this_write, cur))
-            return -1;
-        //HAL_DelayUS(100);
-        //  Verify that block of memory contains required firmware chunk
-        if (memcmp(firmware+ii, cur, this_write))
-            return -2;
     }
 
+    //  Read whole image back and verify it in a single pass
+    if (mpu_mem_crc(0, length, &crc))
+        return -1;
+    if (crc != crc16(0xFFFF, firmware, length))
+        return -2;
+
     /* Set program start address. */
     tmp[0] = start_addr >> 8;
     tmp[1] = start_addr & 0xFF;
@@ -2845,6 +3020,44 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
     return 0;
 }
 
+/**
+ *  @brief      Verify DMP image kept in the chip since it was loaded.
+ *  Used instead of @e mpu_load_firmware after @e mpu_init_warm. Data area of
+ *  DMP memory (below start_addr) is changed by the DMP while it runs, so only
+ *  the program area is checked, against CRC of it read earlier with
+ *  @e mpu_mem_crc. Program area includes configuration written by the DMP
+ *  driver, so the CRC also tells whether DMP was configured the same way.
+ *  @param[in]  length      Length of DMP image.
+ *  @param[in]  start_addr  Starting address of DMP code memory.
+ *  @param[in]  sample_rate Fixed sampling rate used when DMP is enabled.
+ *  @param[in]  crc         Expected CRC of program area.
+ *  @return     0 if successful, -2 if image doesn't match.
+ */
+int mpu_verify_firmware(unsigned short length, unsigned short start_addr,
+    unsigned short sample_rate, unsigned short crc)
+{
+    unsigned short cur;
+    unsigned char tmp[2];
+
+    if (st.chip_cfg.dmp_loaded)
+        return -1;
+
+    if (mpu_mem_crc(start_addr, length - start_addr, &cur))
+        return -1;
+    if (cur != crc)
+        return -2;
+
+    /* Set program start address again, it costs less than reading it. */
+    tmp[0] = start_addr >> 8;
+    tmp[1] = start_addr & 0xFF;
+    if (i2c_write(st.hw->addr, st.reg->prgm_start_h, 2, tmp))
+        return -1;
+
+    st.chip_cfg.dmp_loaded = 1;
+    st.chip_cfg.dmp_sample_rate = sample_rate;
+    return 0;
+}
+
 /**
  *  @brief      Enable/disable DMP support.
  *  @param[in]  enable  1 to turn on the DMP.
@@ -63,6 +63,8 @@ struct int_param_s {
 
 /* Set up APIs */
 int mpu_init(struct int_param_s *int_param);
+int mpu_init_warm(struct int_param_s *int_param);
+int mpu_wait_ready(unsigned short timeout_ms);
 int mpu_init_slave(void);
 int mpu_set_bypass(unsigned char bypass_on);
 
@@ -118,6 +120,8 @@ int mpu_read_fifo(short *gyro, short *accel, unsigned long *timestamp,
     unsigned char *sensors, unsigned char *more);
 int mpu_read_fifo_stream(unsigned short length, unsigned char *data,
     unsigned char *more);
+int mpu_read_fifo_batch(unsigned short length, unsigned short size,
+    unsigned char *data, unsigned short *count, unsigned short *more);
 int mpu_reset_fifo(void);
 
 int mpu_write_mem(unsigned short mem_addr, unsigned short length,
@@ -126,6 +130,10 @@ int mpu_read_mem(unsigned short mem_addr, unsigned short length,
     unsigned char *data);
 int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
     unsigned short start_addr, unsigned short sample_rate);
+int mpu_verify_firmware(unsigned short length, unsigned short start_addr,
+    unsigned short sample_rate, unsigned short crc);
+int mpu_mem_crc(unsigned short mem_addr, unsigned short length,
+    unsigned short *crc);
 
 int mpu_reg_dump(void);
 int mpu_read_reg(unsigned char reg, unsigned char *data);
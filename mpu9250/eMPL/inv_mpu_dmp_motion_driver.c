@@ -440,6 +440,8 @@ static const unsigned short sStartAddress = 0x0400;
                                      DMP_FEATURE_SEND_CAL_GYRO)
 
 #define MAX_PACKET_LENGTH   (32)
+/* Size of buffer used to drain FIFO in a single burst. */
+#define BATCH_BUFFER_SIZE   (512)
 
 #define DMP_SAMPLE_RATE     (200)
 #define GYRO_SF             (46850825LL * 200 / DMP_SAMPLE_RATE)
@@ -459,6 +461,13 @@ struct dmp_s {
     unsigned short feature_mask;
     unsigned short fifo_rate;
     unsigned char packet_length;
+    /* Packet layout, set when features are enabled: sensors present in each
+     * packet (INV_* flags) and offsets of accel, gyro and gesture data.
+     */
+    short sensors;
+    unsigned char accel_ofs;
+    unsigned char gyro_ofs;
+    unsigned char gesture_ofs;
 };
 
 static struct dmp_s dmp = {
@@ -467,7 +476,11 @@ static struct dmp_s dmp = {
     .orient = 0,
     .feature_mask = 0,
     .fifo_rate = 0,
-    .packet_length = 0
+    .packet_length = 0,
+    .sensors = 0,
+    .accel_ofs = 0,
+    .gyro_ofs = 0,
+    .gesture_ofs = 0
 };
 
 /**
@@ -480,6 +493,29 @@ int dmp_load_motion_driver_firmware(void)
         DMP_SAMPLE_RATE);
 }
 
+/**
+ *  @brief      Use DMP image kept in the chip instead of loading it again.
+ *  Call after @e mpu_init_warm and after configuring the DMP the same way as
+ *  when the CRC was taken.
+ *  @param[in]  crc     CRC of program area from @e dmp_get_firmware_crc.
+ *  @return     0 if image is intact.
+ */
+int dmp_verify_motion_driver_firmware(unsigned short crc)
+{
+    return mpu_verify_firmware(DMP_CODE_SIZE, sStartAddress, DMP_SAMPLE_RATE,
+        crc);
+}
+
+/**
+ *  @brief      Get CRC of program area of DMP image in the chip.
+ *  @param[out] crc     CRC16 of program area, including DMP configuration.
+ *  @return     0 if successful.
+ */
+int dmp_get_firmware_crc(unsigned short *crc)
+{
+    return mpu_mem_crc(sStartAddress, DMP_CODE_SIZE - sStartAddress, crc);
+}
+
 /**
  *  @brief      Push gyro and accel orientation to the DMP.
  *  The orientation is represented here as the output of
@@ -1063,13 +1099,24 @@ int dmp_enable_feature(unsigned short mask)
     dmp.feature_mask = mask | DMP_FEATURE_PEDOMETER;
     mpu_reset_fifo();
 
+    /* Packet is [quat][accel][gyro][gesture], cache where each part is. */
     dmp.packet_length = 0;
-    if (mask & DMP_FEATURE_SEND_RAW_ACCEL)
+    dmp.sensors = 0;
+    if (mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT)) {
+        dmp.packet_length += 16;
+        dmp.sensors |= INV_WXYZ_QUAT;
+    }
+    dmp.accel_ofs = dmp.packet_length;
+    if (mask & DMP_FEATURE_SEND_RAW_ACCEL) {
         dmp.packet_length += 6;
-    if (mask & DMP_FEATURE_SEND_ANY_GYRO)
+        dmp.sensors |= INV_XYZ_ACCEL;
+    }
+    dmp.gyro_ofs = dmp.packet_length;
+    if (mask & DMP_FEATURE_SEND_ANY_GYRO) {
         dmp.packet_length += 6;
-    if (mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT))
-        dmp.packet_length += 16;
+        dmp.sensors |= INV_XYZ_GYRO;
+    }
+    dmp.gesture_ofs = dmp.packet_length;
     if (mask & (DMP_FEATURE_TAP | DMP_FEATURE_ANDROID_ORIENT))
         dmp.packet_length += 4;
 
@@ -1211,56 +1258,33 @@ int dmp_set_interrupt_mode(unsigned char mode)
 }
 
 /**
- *  @brief      Get one packet from the FIFO.
- *  If @e sensors does not contain a particular sensor, disregard the data
- *  returned to that pointer.
- *  \n @e sensors can contain a combination of the following flags:
- *  \n INV_X_GYRO, INV_Y_GYRO, INV_Z_GYRO
- *  \n INV_XYZ_GYRO
- *  \n INV_XYZ_ACCEL
- *  \n INV_WXYZ_QUAT
- *  \n If the FIFO has no new data, @e sensors will be zero.
- *  \n If the FIFO is disabled, @e sensors will be zero and this function will
- *  return a non-zero error code.
+ *  @brief      Parse one DMP packet.
+ *  Layout of the packet is the one cached by dmp_enable_feature. Gestures are
+ *  decoded and their callbacks called.
+ *  @param[in]  fifo_data   One packet read from the FIFO.
  *  @param[out] gyro        Gyro data in hardware units.
  *  @param[out] accel       Accel data in hardware units.
- *  @param[out] quat        3-axis quaternion data in hardware units.
- *  @param[out] timestamp   Timestamp in milliseconds.
- *  @param[out] sensors     Mask of sensors read from FIFO.
- *  @param[out] more        Number of remaining packets.
- *  @return     0 if successful.
+ *  @param[out] quat        Quaternion data in hardware units.
+ *  @return     0 if successful, -10 if FIFO is corrupted (FIFO is reset).
  */
-int dmp_read_fifo(short *gyro, short *accel, long *quat,
-    unsigned long *timestamp, short *sensors, unsigned char *more)
+static int parse_packet(const unsigned char *fifo_data, short *gyro,
+    short *accel, long *quat)
 {
-    int retVal;
-    unsigned char fifo_data[MAX_PACKET_LENGTH];
-    unsigned char ii = 0;
-
-    /* TODO: sensors[0] only changes when dmp_enable_feature is called. We can
-     * cache this value and save some cycles.
-     */
-    sensors[0] = 0;
-
-    /* Get a packet. */
-    retVal = mpu_read_fifo_stream(dmp.packet_length, fifo_data, more);
-    if (retVal)
-        return retVal;
+    const unsigned char *ptr;
+    long q[4];
 
-    /* Parse DMP packet. */
-    if (dmp.feature_mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT)) {
+    if (dmp.sensors & INV_WXYZ_QUAT) {
 #ifdef FIFO_CORRUPTION_CHECK
         long quat_q14[4], quat_mag_sq;
 #endif
-        quat[0] = ((long)fifo_data[0] << 24) | ((long)fifo_data[1] << 16) |
+        q[0] = ((long)fifo_data[0] << 24) | ((long)fifo_data[1] << 16) |
             ((long)fifo_data[2] << 8) | fifo_data[3];
-        quat[1] = ((long)fifo_data[4] << 24) | ((long)fifo_data[5] << 16) |
+        q[1] = ((long)fifo_data[4] << 24) | ((long)fifo_data[5] << 16) |
             ((long)fifo_data[6] << 8) | fifo_data[7];
-        quat[2] = ((long)fifo_data[8] << 24) | ((long)fifo_data[9] << 16) |
+        q[2] = ((long)fifo_data[8] << 24) | ((long)fifo_data[9] << 16) |
             ((long)fifo_data[10] << 8) | fifo_data[11];
-        quat[3] = ((long)fifo_data[12] << 24) | ((long)fifo_data[13] << 16) |
+        q[3] = ((long)fifo_data[12] << 24) | ((long)fifo_data[13] << 16) |
             ((long)fifo_data[14] << 8) | fifo_data[15];
-        ii += 16;
 #ifdef FIFO_CORRUPTION_CHECK
         /* We can detect a corrupted FIFO by monitoring the quaternion data and
          * ensuring that the magnitude is always normalized to one. This
@@ -1270,49 +1294,140 @@ int dmp_read_fifo(short *gyro, short *accel, long *quat,
          * Let's start by scaling down the quaternion data to avoid long long
          * math.
          */
-        quat_q14[0] = quat[0] >> 16;
-        quat_q14[1] = quat[1] >> 16;
-        quat_q14[2] = quat[2] >> 16;
-        quat_q14[3] = quat[3] >> 16;
+        quat_q14[0] = q[0] >> 16;
+        quat_q14[1] = q[1] >> 16;
+        quat_q14[2] = q[2] >> 16;
+        quat_q14[3] = q[3] >> 16;
         quat_mag_sq = quat_q14[0] * quat_q14[0] + quat_q14[1] * quat_q14[1] +
             quat_q14[2] * quat_q14[2] + quat_q14[3] * quat_q14[3];
         if ((quat_mag_sq < QUAT_MAG_SQ_MIN) ||
             (quat_mag_sq > QUAT_MAG_SQ_MAX)) {
             /* Quaternion is outside of the acceptable threshold. */
             mpu_reset_fifo();
-            sensors[0] = 0;
             return -10;
         }
-        sensors[0] |= INV_WXYZ_QUAT;
 #endif
+        /* Outputs keep the previous packet if this one is corrupted. */
+        quat[0] = q[0];
+        quat[1] = q[1];
+        quat[2] = q[2];
+        quat[3] = q[3];
     }
 
-    if (dmp.feature_mask & DMP_FEATURE_SEND_RAW_ACCEL) {
-        accel[0] = ((short)fifo_data[ii+0] << 8) | fifo_data[ii+1];
-        accel[1] = ((short)fifo_data[ii+2] << 8) | fifo_data[ii+3];
-        accel[2] = ((short)fifo_data[ii+4] << 8) | fifo_data[ii+5];
-        ii += 6;
-        sensors[0] |= INV_XYZ_ACCEL;
+    if (dmp.sensors & INV_XYZ_ACCEL) {
+        ptr = fifo_data + dmp.accel_ofs;
+        accel[0] = ((short)ptr[0] << 8) | ptr[1];
+        accel[1] = ((short)ptr[2] << 8) | ptr[3];
+        accel[2] = ((short)ptr[4] << 8) | ptr[5];
     }
 
-    if (dmp.feature_mask & DMP_FEATURE_SEND_ANY_GYRO) {
-        gyro[0] = ((short)fifo_data[ii+0] << 8) | fifo_data[ii+1];
-        gyro[1] = ((short)fifo_data[ii+2] << 8) | fifo_data[ii+3];
-        gyro[2] = ((short)fifo_data[ii+4] << 8) | fifo_data[ii+5];
-        ii += 6;
-        sensors[0] |= INV_XYZ_GYRO;
+    if (dmp.sensors & INV_XYZ_GYRO) {
+        ptr = fifo_data + dmp.gyro_ofs;
+        gyro[0] = ((short)ptr[0] << 8) | ptr[1];
+        gyro[1] = ((short)ptr[2] << 8) | ptr[3];
+        gyro[2] = ((short)ptr[4] << 8) | ptr[5];
     }
 
     /* Gesture data is at the end of the DMP packet. Parse it and call
      * the gesture callbacks (if registered).
      */
     if (dmp.feature_mask & (DMP_FEATURE_TAP | DMP_FEATURE_ANDROID_ORIENT))
-        decode_gesture(fifo_data + ii);
+        decode_gesture((unsigned char*)fifo_data + dmp.gesture_ofs);
+
+    return 0;
+}
+
+/**
+ *  @brief      Get one packet from the FIFO.
+ *  If @e sensors does not contain a particular sensor, disregard the data
+ *  returned to that pointer.
+ *  \n @e sensors can contain a combination of the following flags:
+ *  \n INV_X_GYRO, INV_Y_GYRO, INV_Z_GYRO
+ *  \n INV_XYZ_GYRO
+ *  \n INV_XYZ_ACCEL
+ *  \n INV_WXYZ_QUAT
+ *  \n If the FIFO has no new data, @e sensors will be zero.
+ *  \n If the FIFO is disabled, @e sensors will be zero and this function will
+ *  return a non-zero error code.
+ *  @param[out] gyro        Gyro data in hardware units.
+ *  @param[out] accel       Accel data in hardware units.
+ *  @param[out] quat        3-axis quaternion data in hardware units.
+ *  @param[out] timestamp   Timestamp in milliseconds.
+ *  @param[out] sensors     Mask of sensors read from FIFO.
+ *  @param[out] more        Number of remaining packets.
+ *  @return     0 if successful.
+ */
+int dmp_read_fifo(short *gyro, short *accel, long *quat,
+    unsigned long *timestamp, short *sensors, unsigned char *more)
+{
+    int retVal;
+    unsigned char fifo_data[MAX_PACKET_LENGTH];
+
+    sensors[0] = 0;
+
+    /* Get a packet. */
+    retVal = mpu_read_fifo_stream(dmp.packet_length, fifo_data, more);
+    if (retVal)
+        return retVal;
+
+    retVal = parse_packet(fifo_data, gyro, accel, quat);
+    if (retVal)
+        return retVal;
+    sensors[0] = dmp.sensors;
 
     //get_ms(timestamp);
     return 0;
 }
 
+/**
+ *  @brief      Get all complete packets from the FIFO in one burst.
+ *  FIFO count is read only once and all packets are read in a single
+ *  transaction, instead of one packet per call of dmp_read_fifo. Gestures of
+ *  every packet are decoded (and their callbacks called), but only data of the
+ *  newest packet is returned.
+ *  \n If the FIFO has no complete packet, @e sensors and @e count will be
+ *  zero. If there are more packets than fit into the internal buffer, @e more
+ *  is non-zero and the function should be called again.
+ *  @param[out] gyro        Gyro data of newest packet in hardware units.
+ *  @param[out] accel       Accel data of newest packet in hardware units.
+ *  @param[out] quat        Quaternion of newest packet in hardware units.
+ *  @param[out] sensors     Mask of sensors read from FIFO.
+ *  @param[out] count       Number of packets read.
+ *  @param[out] more        Number of remaining packets.
+ *  @return     0 if successful.
+ */
+int dmp_read_fifo_batch(short *gyro, short *accel, long *quat,
+    short *sensors, unsigned short *count, unsigned short *more)
+{
+    /* Static as the whole batch doesn't fit on the stack. */
+    static unsigned char fifo_data[BATCH_BUFFER_SIZE];
+    unsigned short ii;
+    int retVal;
+
+    sensors[0] = 0;
+
+    retVal = mpu_read_fifo_batch(dmp.packet_length, BATCH_BUFFER_SIZE,
+                                 fifo_data, count, more);
+    if (retVal)
+        return retVal;
+
+    /* Packets are in order oldest to newest, the newest one stays in the
+     * output buffers.
+     */
+    for (ii = 0; ii < count[0]; ii++) {
+        retVal = parse_packet(fifo_data + ii * dmp.packet_length,
+                              gyro, accel, quat);
+        if (retVal) {
+            count[0] = more[0] = 0;
+            return retVal;
+        }
+    }
+    if (count[0])
+        sensors[0] = dmp.sensors;
+
+    return 0;
+}
+
 /**
  *  @brief      Register a function to be executed on a tap event.
  *  The tap direction is represented by one of the following:
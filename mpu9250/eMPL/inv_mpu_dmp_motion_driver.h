@@ -59,6 +59,8 @@ extern "C"
 
 /* Set up functions. */
 int dmp_load_motion_driver_firmware(void);
+int dmp_verify_motion_driver_firmware(unsigned short crc);
+int dmp_get_firmware_crc(unsigned short *crc);
 int dmp_set_fifo_rate(unsigned short rate);
 int dmp_get_fifo_rate(unsigned short *rate);
 int dmp_enable_feature(unsigned short mask);
@@ -107,6 +109,8 @@ int dmp_enable_gyro_cal(unsigned char enable);
  */
 int dmp_read_fifo(short *gyro, short *accel, long *quat,
     unsigned long *timestamp, short *sensors, unsigned char *more);
+int dmp_read_fifo_batch(short *gyro, short *accel, long *quat,
+    short *sensors, unsigned short *count, unsigned short *more);
 
 #ifdef __cplusplus
 }
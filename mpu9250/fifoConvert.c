@@ -0,0 +1,208 @@
+/**
+ * fifoConvert.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "fifoConvert.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)  //  Compile only if module is enabled
+
+#include <string.h>
+
+//  Pick implementation: Cortex-M4 DSP extension, SSE2, NEON or plain C
+#if defined(FIFO_CONV_NO_SIMD)
+    #define FIFO_CONV_SCALAR
+#elif defined(__TI_ARM_V7M4__) || \
+      (defined(__ARM_FEATURE_DSP) && !defined(__ARM_NEON))
+    #define FIFO_CONV_M4
+#elif defined(__SSE2__) || defined(_M_X64)
+    #define FIFO_CONV_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #define FIFO_CONV_NEON
+    #include <arm_neon.h>
+#else
+    #define FIFO_CONV_SCALAR
+#endif
+
+
+/**
+ * Compute conversion coefficients
+ * @param coef Coefficients to set up
+ * @param bias Bias of each channel in raw units [ax,ay,az,gx,gy,gz]
+ * @param scale Resolution of each channel [ax,ay,az,gx,gy,gz]
+ */
+void fifoConvertCoef(FifoConvCoef *coef, const float *bias, const float *scale)
+{
+    uint8_t i;
+
+    for (i = 0; i < FIFO_CHANNELS; i++)
+    {
+        coef->scale[i] = scale[i];
+        coef->offset[i] = bias[i] * scale[i];
+    }
+}
+
+/**
+ * Convert single packet with plain C, used by all paths for the leftover
+ * packets
+ */
+static void _ConvertPacket(const FifoConvCoef *coef, const uint8_t *raw,
+                           float * const *out, uint16_t i)
+{
+    uint8_t ch;
+
+    for (ch = 0; ch < FIFO_CHANNELS; ch++)
+    {
+        int16_t v = (int16_t)(((uint16_t)raw[2*ch] << 8) | raw[2*ch + 1]);
+        out[ch][i] = (float)v * coef->scale[ch] - coef->offset[ch];
+    }
+}
+
+#if defined(FIFO_CONV_M4)
+/**
+ * Swap bytes in each halfword of a word (REV16)
+ */
+static inline uint32_t _Rev16(uint32_t x)
+{
+#if defined(__TI_ARM__)
+    return _rev16(x);
+#else
+    uint32_t r;
+    __asm__ ("rev16 %0, %1" : "=r" (r) : "r" (x));
+    return r;
+#endif
+}
+#endif  /* FIFO_CONV_M4 */
+
+/**
+ * Convert block of raw FIFO packets to scaled floats
+ * @param coef Conversion coefficients, see fifoConvertCoef()
+ * @param raw Raw FIFO content, n packets of FIFO_PACKET_SIZE bytes
+ * @param n Number of packets
+ * @param out FIFO_CHANNELS pointers to arrays of (min.) n floats, one per
+ *        channel [ax,ay,az,gx,gy,gz]
+ */
+void fifoConvert(const FifoConvCoef *coef, const uint8_t *raw, uint16_t n,
+                 float * const *out)
+{
+    uint16_t i = 0;
+
+#if defined(FIFO_CONV_M4)
+    //  Words are loaded with memcpy as packets needn't be word-aligned, M4
+    //  handles unaligned LDR so this compiles into a single load
+    for (; i < n; i++, raw += FIFO_PACKET_SIZE)
+    {
+        uint32_t w[3];
+        uint8_t ch;
+
+        memcpy((void*)w, (const void*)raw, sizeof(w));
+        for (ch = 0; ch < 3; ch++)
+        {
+            uint32_t s = _Rev16(w[ch]);
+
+            //  Low halfword is the first channel of the pair (SXTH), high
+            //  halfword the second one (ASR)
+            out[2*ch][i] = (float)(int16_t)s * coef->scale[2*ch]
+                           - coef->offset[2*ch];
+            out[2*ch+1][i] = (float)((int32_t)s >> 16) * coef->scale[2*ch+1]
+                             - coef->offset[2*ch+1];
+        }
+    }
+
+#elif defined(FIFO_CONV_SSE2)
+    //  Two packets (24 bytes, 12 values) per iteration, as three vectors of 4
+    //  values with channels [0..3], [4,5,0,1] and [2..5]
+    {
+        __m128 s0 = _mm_setr_ps(coef->scale[0], coef->scale[1],
+                                coef->scale[2], coef->scale[3]);
+        __m128 s1 = _mm_setr_ps(coef->scale[4], coef->scale[5],
+                                coef->scale[0], coef->scale[1]);
+        __m128 s2 = _mm_setr_ps(coef->scale[2], coef->scale[3],
+                                coef->scale[4], coef->scale[5]);
+        __m128 o0 = _mm_setr_ps(coef->offset[0], coef->offset[1],
+                                coef->offset[2], coef->offset[3]);
+        __m128 o1 = _mm_setr_ps(coef->offset[4], coef->offset[5],
+                                coef->offset[0], coef->offset[1]);
+        __m128 o2 = _mm_setr_ps(coef->offset[2], coef->offset[3],
+                                coef->offset[4], coef->offset[5]);
+
+        for (; (i + 2) <= n; i += 2, raw += 2*FIFO_PACKET_SIZE)
+        {
+            float f[12];
+            __m128i a = _mm_loadu_si128((const __m128i*)raw);
+            __m128i b = _mm_loadl_epi64((const __m128i*)(raw + 16));
+
+            //  Byte swap in each 16-bit lane
+            a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+            b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+            //  Sign extend to 32 bits: place value in upper half, shift down
+            _mm_storeu_ps(f, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+                _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)), s0), o0));
+            _mm_storeu_ps(f + 4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+                _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16)), s1), o1));
+            _mm_storeu_ps(f + 8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+                _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16)), s2), o2));
+
+            out[0][i] = f[0];   out[0][i+1] = f[6];
+            out[1][i] = f[1];   out[1][i+1] = f[7];
+            out[2][i] = f[2];   out[2][i+1] = f[8];
+            out[3][i] = f[3];   out[3][i+1] = f[9];
+            out[4][i] = f[4];   out[4][i+1] = f[10];
+            out[5][i] = f[5];   out[5][i+1] = f[11];
+        }
+    }
+
+#elif defined(FIFO_CONV_NEON)
+    //  Four packets per iteration, loaded as eight 3-halfword structures so
+    //  that accel and gyro alternate in each lane of x/y/z, then separated
+    {
+        uint8_t ch;
+
+        for (; (i + 4) <= n; i += 4, raw += 4*FIFO_PACKET_SIZE)
+        {
+            uint16x8x3_t v = vld3q_u16((const uint16_t*)raw);
+
+            for (ch = 0; ch < 3; ch++)
+            {
+                int16x8_t s = vreinterpretq_s16_u8(
+                                vrev16q_u8(vreinterpretq_u8_u16(v.val[ch])));
+                int16x4x2_t ag = vuzp_s16(vget_low_s16(s), vget_high_s16(s));
+                float32x4_t fa = vcvtq_f32_s32(vmovl_s16(ag.val[0]));
+                float32x4_t fg = vcvtq_f32_s32(vmovl_s16(ag.val[1]));
+
+                vst1q_f32(out[ch] + i, vsubq_f32(
+                    vmulq_n_f32(fa, coef->scale[ch]),
+                    vdupq_n_f32(coef->offset[ch])));
+                vst1q_f32(out[ch+3] + i, vsubq_f32(
+                    vmulq_n_f32(fg, coef->scale[ch+3]),
+                    vdupq_n_f32(coef->offset[ch+3])));
+            }
+        }
+    }
+#endif
+
+    //  Plain C for whatever is left (or everything if there's no SIMD)
+    for (; i < n; i++, raw += FIFO_PACKET_SIZE)
+        _ConvertPacket(coef, raw, out, i);
+}
+
+/**
+ * Get name of the implementation in use
+ * @return "m4", "sse2", "neon" or "scalar"
+ */
+const char* fifoConvertPath()
+{
+#if defined(FIFO_CONV_M4)
+    return "m4";
+#elif defined(FIFO_CONV_SSE2)
+    return "sse2";
+#elif defined(FIFO_CONV_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
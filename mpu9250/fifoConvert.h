@@ -0,0 +1,63 @@
+/**
+ * fifoConvert.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Batch conversion of raw MPU9250 FIFO packets (accelerometer + gyroscope,
+ *  12 big-endian bytes per packet) into scaled, bias-corrected floats stored
+ *  as structure-of-arrays, one array per channel. Each value is turned into
+ *      out = raw*scale - bias*scale
+ *  which is a single multiply-add, byte swap and sign extension are done with
+ *  SIMD instructions where available:
+ *   -Cortex-M4: REV16 swaps both halfwords of a 32-bit word at once, so one
+ *    packet takes 3 word loads instead of 12 byte loads
+ *   -x86 (SSE2) and ARM NEON hosts: several packets are converted per
+ *    iteration in vector registers
+ *  Anything else falls back to plain C, which can also be forced by defining
+ *  FIFO_CONV_NO_SIMD. Channel arrays are in sensor frame, mounting can be
+ *  applied for free by passing the arrays (and scales) permuted.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_FIFOCONVERT_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_FIFOCONVERT_H_
+
+#include <stdint.h>
+
+//  Channels in a FIFO packet [ax,ay,az,gx,gy,gz] and packet size in bytes
+#define FIFO_CHANNELS       6
+#define FIFO_PACKET_SIZE    12
+
+
+/**
+ * Per-channel coefficients used by the conversion, set by fifoConvertCoef()
+ */
+typedef struct
+{
+    float scale[FIFO_CHANNELS];
+    //  Bias multiplied by scale
+    float offset[FIFO_CHANNELS];
+} FifoConvCoef;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void        fifoConvertCoef(FifoConvCoef *coef, const float *bias,
+                                const float *scale);
+    void        fifoConvert(const FifoConvCoef *coef, const uint8_t *raw,
+                            uint16_t n, float * const *out);
+    const char* fifoConvertPath();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROVERKERNEL_MPU9250_FIFOCONVERT_H_ */
@@ -0,0 +1,125 @@
+/**
+ * gyroBias.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "gyroBias.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)  //  Compile only if module is enabled
+
+#include "libs/myLib.h"
+
+//  Default thresholds, in raw units of +/-250dps gyro and +/-2g accel:
+//  gyro std. dev. ~0.3dps, accel std. dev. ~0.02g, gyro mean ~5dps
+#define GB_DEF_GYRO_VAR     1600.0f
+#define GB_DEF_ACC_VAR      108000.0f
+#define GB_DEF_GYRO_MEAN    655.0f
+
+
+GyroBias::GyroBias()
+{
+    SetThresholds(GB_DEF_GYRO_VAR, GB_DEF_ACC_VAR, GB_DEF_GYRO_MEAN);
+    Reset();
+}
+
+/**
+ * Clear bias estimate and content of sliding window
+ */
+void GyroBias::Reset()
+{
+    memset((void*)bias, 0, sizeof(bias));
+    memset((void*)_win, 0, sizeof(_win));
+    memset((void*)_sum, 0, sizeof(_sum));
+    memset((void*)_sumSq, 0, sizeof(_sumSq));
+    _head = 0;
+    _fill = 0;
+    _n = 0;
+    stationary = false;
+}
+
+/**
+ * Set bias estimate, e.g. to one stored before reboot
+ * Estimate continues to follow drift with the smallest gain, as if it had
+ * already converged, so it isn't replaced by the first stationary samples.
+ * @param b Bias in raw gyro units [x,y,z]
+ */
+void GyroBias::Set(const float *b)
+{
+    memcpy((void*)bias, (void*)b, sizeof(bias));
+    _n = GB_MAX_SAMPLES;
+}
+
+/**
+ * Set thresholds used to decide if sensor is stationary. All thresholds are
+ * in raw sensor units (LSB), variances in LSB^2.
+ * @param gyroVar Max. variance of each gyro axis over the window
+ * @param accVar Max. variance of each accel axis over the window
+ * @param gyroMean Max. absolute mean of each gyro axis over the window, keeps
+ *        constant-rate turns from being taken as bias
+ */
+void GyroBias::SetThresholds(float gyroVar, float accVar, float gyroMean)
+{
+    _gyroVarThr = (int64_t)(gyroVar * GB_WINDOW_LEN * GB_WINDOW_LEN);
+    _accVarThr = (int64_t)(accVar * GB_WINDOW_LEN * GB_WINDOW_LEN);
+    _gyroMeanThr = (int32_t)(gyroMean * GB_WINDOW_LEN);
+}
+
+/**
+ * Push new sample into the estimator
+ * Updates sliding window statistics and, if sensor has been stationary over
+ * the whole window, moves bias estimate towards the new gyro sample.
+ * @param gyro Raw gyroscope reading [x,y,z]
+ * @param acc Raw accelerometer reading [x,y,z]
+ * @return true if sensor is stationary and bias was updated
+ */
+bool GyroBias::Update(const int16_t *gyro, const int16_t *acc)
+{
+    int16_t *slot = _win[_head];
+    uint8_t i;
+
+    //  Replace oldest sample in the window with the new one
+    for (i = 0; i < 6; i++)
+    {
+        int32_t newVal = (i < 3) ? gyro[i] : acc[i-3];
+        int32_t oldVal = slot[i];
+
+        _sum[i] += newVal - oldVal;
+        _sumSq[i] += (int64_t)(newVal*newVal) - (int64_t)(oldVal*oldVal);
+        slot[i] = (int16_t)newVal;
+    }
+    _head = (_head + 1) % GB_WINDOW_LEN;
+
+    stationary = false;
+    if (_fill < GB_WINDOW_LEN)
+    {
+        _fill++;
+        return false;
+    }
+
+    //  N^2*variance = N*sum(x^2) - sum(x)^2, compared against N^2*threshold
+    for (i = 0; i < 6; i++)
+    {
+        int64_t var = GB_WINDOW_LEN*_sumSq[i] - (int64_t)_sum[i]*_sum[i];
+
+        if (i < 3)
+        {
+            if ((var > _gyroVarThr) || (abs(_sum[i]) > _gyroMeanThr))
+                return false;
+        }
+        else if (var > _accVarThr)
+            return false;
+    }
+    stationary = true;
+
+    //  Recursive mean, gain starts at 1 and settles at 1/GB_MAX_SAMPLES
+    if (_n < GB_MAX_SAMPLES)
+        _n++;
+    float k = 1.0f / (float)_n;
+    for (i = 0; i < 3; i++)
+        bias[i] += ((float)gyro[i] - bias[i]) * k;
+
+    return true;
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
@@ -0,0 +1,70 @@
+/**
+ * gyroBias.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Online estimator of gyroscope bias. Estimator watches a sliding window of
+ *  raw accelerometer and gyroscope readings and decides that the sensor is
+ *  stationary when variance of both (and mean of gyro) are small enough. While
+ *  stationary, gyro readings are pushed into a recursive mean which tracks the
+ *  bias as it drifts with temperature. Each update is O(1), window sums are
+ *  kept in integers so they never drift away from the true window content.
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +Estimate can be set, e.g. restored after reboot
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_GYROBIAS_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_GYROBIAS_H_
+
+#include <stdint.h>
+
+//  Length of sliding window used for detecting stationary periods (samples)
+#define GB_WINDOW_LEN   32
+//  Max. number of samples the recursive mean averages over, sets how fast the
+//  estimate follows bias drift (1/GB_MAX_SAMPLES is the smallest gain used)
+#define GB_MAX_SAMPLES  2000
+
+
+/**
+ * Gyroscope bias estimator working on raw (int16) sensor readings
+ */
+class GyroBias
+{
+    public:
+        GyroBias();
+
+        void    Reset();
+        void    Set(const float *b);
+        void    SetThresholds(float gyroVar, float accVar, float gyroMean);
+        bool    Update(const int16_t *gyro, const int16_t *acc);
+
+        //  Current bias estimate in raw gyro units [x,y,z]
+        float   bias[3];
+        //  True if sensor was stationary during the last window
+        bool    stationary;
+
+    private:
+        //  Sliding window of raw samples, gyro in [0..2], accel in [3..5]
+        int16_t _win[GB_WINDOW_LEN][6];
+        //  Running sum and sum of squares of the values in the window
+        int32_t _sum[6];
+        int64_t _sumSq[6];
+        //  Next position to write in window, number of valid samples in it
+        uint16_t _head, _fill;
+        //  Number of samples averaged by the recursive mean
+        uint16_t _n;
+
+        //  Stationary thresholds, all in raw units (variance is scaled by
+        //  GB_WINDOW_LEN^2 to avoid divisions in Update)
+        int64_t _gyroVarThr, _accVarThr;
+        int32_t _gyroMeanThr;
+};
+
+#endif /* ROVERKERNEL_MPU9250_GYROBIAS_H_ */
@@ -0,0 +1,319 @@
+/**
+ * magCal.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "magCal.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)  //  Compile only if module is enabled
+
+#include "libs/myLib.h"
+
+//  Initial value of covariance diagonal - confidence in the sphere guess
+#define MC_P_INIT       100.0f
+//  Covariance diagonal when starting from a known calibration (Seed())
+#define MC_P_SEED       1.0f
+//  Min. value of covariance diagonal, fit keeps following roughly the last few
+//  thousand accepted samples instead of freezing
+#define MC_P_MIN        1e-4f
+//  Default min. step between accepted samples, raw units (~15mG at 16-bit)
+#define MC_DEF_STEP     100.0f
+//  Number of Jacobi sweeps when diagonalizing 3x3 matrix
+#define MC_JACOBI_SWEEPS    8
+
+
+MagCal::MagCal() : _minStep(MC_DEF_STEP), _seeded(false)
+{
+    Reset();
+}
+
+/**
+ * Drop current fit and start again from a unit sphere
+ */
+void MagCal::Reset()
+{
+    memset((void*)_theta, 0, sizeof(_theta));
+    memset((void*)_P, 0, sizeof(_P));
+    memset((void*)_last, 0, sizeof(_last));
+
+    for (uint8_t i = 0; i < MC_PARAMS; i++)
+        _P[i][i] = MC_P_INIT;
+    //  x^2 + y^2 + z^2 = 1 in normalized units
+    _theta[0] = _theta[1] = _theta[2] = 1.0f;
+
+    _scale = 0.0f;
+    samples = 0;
+    _seeded = false;
+}
+
+/**
+ * Drop current fit and start again from a known calibration
+ * Calibration doesn't hold field strength (soft-iron matrix has unit
+ * determinant), so the fit is set up from it once the first sample arrives.
+ * Samples still have to be collected before Solve() gives a result, which
+ * then stays close to this calibration along axes the sensor doesn't rotate
+ * around.
+ * @param offset Hard-iron offset in raw units
+ * @param softIron Soft-iron correction matrix
+ */
+void MagCal::Seed(const float *offset, const float softIron[3][3])
+{
+    Reset();
+    memcpy((void*)_seedOffset, (void*)offset, sizeof(_seedOffset));
+    memcpy((void*)_seedSoftIron, (void*)softIron, sizeof(_seedSoftIron));
+    _seeded = true;
+}
+
+/**
+ * Push new raw magnetometer sample into the fit
+ * Samples too close to the previously accepted one are ignored.
+ * @param mag Raw magnetometer reading [x,y,z]
+ * @return true if sample was accepted and fit updated
+ */
+bool MagCal::Update(const int16_t *mag)
+{
+    float phi[MC_PARAMS], Pphi[MC_PARAMS];
+    float x, y, z, denom, err;
+    uint8_t i, j;
+
+    //  Gate samples on distance from the last accepted one
+    x = (float)(mag[0] - _last[0]);
+    y = (float)(mag[1] - _last[1]);
+    z = (float)(mag[2] - _last[2]);
+    if ((_scale != 0.0f) && ((x*x + y*y + z*z) < (_minStep*_minStep)))
+        return false;
+
+    //  First sample sets normalization, so fitted values stay around 1
+    if (_scale == 0.0f)
+    {
+        x = sqrtf((float)mag[0]*mag[0] + (float)mag[1]*mag[1]
+                  + (float)mag[2]*mag[2]);
+        if (x < 1.0f)
+            return false;
+        _scale = 1.0f / x;
+        if (_seeded)
+            _ApplySeed(mag);
+    }
+
+    memcpy((void*)_last, (void*)mag, sizeof(_last));
+
+    x = (float)mag[0] * _scale;
+    y = (float)mag[1] * _scale;
+    z = (float)mag[2] * _scale;
+
+    //  Regressor for ellipsoid equation
+    phi[0] = x*x;
+    phi[1] = y*y;
+    phi[2] = z*z;
+    phi[3] = 2.0f*x*y;
+    phi[4] = 2.0f*x*z;
+    phi[5] = 2.0f*y*z;
+    phi[6] = 2.0f*x;
+    phi[7] = 2.0f*y;
+    phi[8] = 2.0f*z;
+
+    //  RLS update: k = P*phi / (1 + phi'*P*phi), theta += k*(1 - phi'*theta)
+    //  P -= k*phi'*P (P is symmetric so phi'*P = (P*phi)')
+    denom = 1.0f;
+    err = 1.0f;
+    for (i = 0; i < MC_PARAMS; i++)
+    {
+        Pphi[i] = 0.0f;
+        for (j = 0; j < MC_PARAMS; j++)
+            Pphi[i] += _P[i][j] * phi[j];
+        denom += phi[i] * Pphi[i];
+        err -= phi[i] * _theta[i];
+    }
+    denom = 1.0f / denom;
+
+    for (i = 0; i < MC_PARAMS; i++)
+    {
+        _theta[i] += Pphi[i] * denom * err;
+        for (j = i; j < MC_PARAMS; j++)
+        {
+            _P[i][j] -= Pphi[i] * Pphi[j] * denom;
+            _P[j][i] = _P[i][j];
+        }
+    }
+    //  Covariance floor, raising the diagonal keeps P positive-definite
+    for (i = 0; i < MC_PARAMS; i++)
+        if (_P[i][i] < MC_P_MIN)
+            _P[i][i] = MC_P_MIN;
+
+    samples++;
+    return true;
+}
+
+/**
+ * Set fit to ellipsoid given by seed calibration, with radius of the sample
+ * (in calibrated units) and in units normalized by _scale:
+ * (m - c)'*A*(m - c) = 1, A = softIron'*softIron/r^2, m = x/_scale
+ * Fit stays a sphere if ellipsoid doesn't contain origin, as such can't be
+ * expressed by fitted equation.
+ * @param mag Raw magnetometer reading [x,y,z]
+ */
+void MagCal::_ApplySeed(const int16_t *mag)
+{
+    float A[3][3], Ac[3], v[3], r2 = 0.0f, k = 1.0f;
+    uint8_t i, j, l;
+
+    for (i = 0; i < 3; i++)
+    {
+        v[i] = 0.0f;
+        for (j = 0; j < 3; j++)
+            v[i] += _seedSoftIron[i][j] * ((float)mag[j] - _seedOffset[j]);
+        r2 += v[i] * v[i];
+    }
+    if (r2 < 1.0f)
+        return;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            A[i][j] = 0.0f;
+            for (l = 0; l < 3; l++)
+                A[i][j] += _seedSoftIron[l][i] * _seedSoftIron[l][j];
+            A[i][j] /= r2;
+        }
+    for (i = 0; i < 3; i++)
+    {
+        Ac[i] = A[i][0]*_seedOffset[0] + A[i][1]*_seedOffset[1]
+              + A[i][2]*_seedOffset[2];
+        k -= _seedOffset[i] * Ac[i];
+    }
+    if (k <= 0.0f)
+        return;
+
+    //  x'*A/(s^2*k)*x - 2*x'*A*c/(s*k) = 1
+    k = 1.0f / k;
+    _theta[0] = A[0][0] * k / (_scale * _scale);
+    _theta[1] = A[1][1] * k / (_scale * _scale);
+    _theta[2] = A[2][2] * k / (_scale * _scale);
+    _theta[3] = A[0][1] * k / (_scale * _scale);
+    _theta[4] = A[0][2] * k / (_scale * _scale);
+    _theta[5] = A[1][2] * k / (_scale * _scale);
+    for (i = 0; i < 3; i++)
+        _theta[6 + i] = -Ac[i] * k / _scale;
+
+    for (i = 0; i < MC_PARAMS; i++)
+        _P[i][i] = MC_P_SEED;
+}
+
+/**
+ * Compute hard- and soft-iron correction from the current fit
+ * Soft-iron matrix has unit determinant, so calibrated readings keep the
+ * average field strength of raw ones.
+ * @param offset Buffer of size 3 to hold hard-iron offset in raw units
+ * @param softIron 3x3 matrix to hold soft-iron correction
+ * @return true if fit is usable and outputs were written, false otherwise
+ */
+bool MagCal::Solve(float *offset, float softIron[3][3])
+{
+    float A[3][3], inv[3][3], V[3][3], c[3], det, k, g;
+    uint8_t i, j, l, sweep;
+
+    if (samples < MC_MIN_SAMPLES)
+        return false;
+
+    A[0][0] = _theta[0];    A[0][1] = _theta[3];    A[0][2] = _theta[4];
+    A[1][0] = _theta[3];    A[1][1] = _theta[1];    A[1][2] = _theta[5];
+    A[2][0] = _theta[4];    A[2][1] = _theta[5];    A[2][2] = _theta[2];
+
+    //  Center of ellipsoid: A*c = -[g,h,i]
+    inv[0][0] = A[1][1]*A[2][2] - A[1][2]*A[2][1];
+    inv[0][1] = A[0][2]*A[2][1] - A[0][1]*A[2][2];
+    inv[0][2] = A[0][1]*A[1][2] - A[0][2]*A[1][1];
+    inv[1][0] = A[1][2]*A[2][0] - A[1][0]*A[2][2];
+    inv[1][1] = A[0][0]*A[2][2] - A[0][2]*A[2][0];
+    inv[1][2] = A[0][2]*A[1][0] - A[0][0]*A[1][2];
+    inv[2][0] = A[1][0]*A[2][1] - A[1][1]*A[2][0];
+    inv[2][1] = A[0][1]*A[2][0] - A[0][0]*A[2][1];
+    inv[2][2] = A[0][0]*A[1][1] - A[0][1]*A[1][0];
+    det = A[0][0]*inv[0][0] + A[0][1]*inv[1][0] + A[0][2]*inv[2][0];
+    if (det <= 0.0f)
+        return false;
+
+    for (i = 0; i < 3; i++)
+        c[i] = -(inv[i][0]*_theta[6] + inv[i][1]*_theta[7]
+                 + inv[i][2]*_theta[8]) / det;
+
+    //  (m-c)'*A*(m-c) = 1 + c'*A*c = k, scale A so right side becomes 1
+    k = 1.0f;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            k += c[i] * A[i][j] * c[j];
+    if (k <= 0.0f)
+        return false;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            A[i][j] /= k;
+
+    //  Diagonalize A = V*D*V' with Jacobi rotations, D ends up on diagonal
+    memset((void*)V, 0, sizeof(V));
+    V[0][0] = V[1][1] = V[2][2] = 1.0f;
+    for (sweep = 0; sweep < MC_JACOBI_SWEEPS; sweep++)
+        for (i = 0; i < 2; i++)
+            for (j = i+1; j < 3; j++)
+            {
+                float theta, t, cs, sn;
+
+                if (fabsf(A[i][j]) < 1e-9f)
+                    continue;
+                theta = (A[j][j] - A[i][i]) / (2.0f * A[i][j]);
+                t = (theta >= 0.0f ? 1.0f : -1.0f)
+                    / (fabsf(theta) + sqrtf(theta*theta + 1.0f));
+                cs = 1.0f / sqrtf(t*t + 1.0f);
+                sn = t * cs;
+
+                for (l = 0; l < 3; l++)
+                {
+                    float a = A[l][i], b = A[l][j];
+                    A[l][i] = cs*a - sn*b;
+                    A[l][j] = sn*a + cs*b;
+                }
+                for (l = 0; l < 3; l++)
+                {
+                    float a = A[i][l], b = A[j][l];
+                    A[i][l] = cs*a - sn*b;
+                    A[j][l] = sn*a + cs*b;
+                }
+                for (l = 0; l < 3; l++)
+                {
+                    float a = V[l][i], b = V[l][j];
+                    V[l][i] = cs*a - sn*b;
+                    V[l][j] = sn*a + cs*b;
+                }
+            }
+
+    //  Reject fits which are not an ellipsoid or are too elongated to be
+    //  a distorted sphere
+    float dMin = A[0][0], dMax = A[0][0];
+    for (i = 1; i < 3; i++)
+    {
+        if (A[i][i] < dMin) dMin = A[i][i];
+        if (A[i][i] > dMax) dMax = A[i][i];
+    }
+    if ((dMin <= 0.0f)
+        || (dMax > dMin * MC_MAX_AXIS_RATIO * MC_MAX_AXIS_RATIO))
+        return false;
+
+    //  softIron = sqrt(A) scaled to unit determinant = V*sqrt(D)*V' * g
+    g = powf(A[0][0]*A[1][1]*A[2][2], -1.0f/6.0f);
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            softIron[i][j] = 0.0f;
+            for (l = 0; l < 3; l++)
+                softIron[i][j] += V[i][l] * sqrtf(A[l][l]) * V[j][l];
+            softIron[i][j] *= g;
+        }
+
+    //  Center back to raw units
+    for (i = 0; i < 3; i++)
+        offset[i] = c[i] / _scale;
+
+    return true;
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
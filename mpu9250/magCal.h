@@ -0,0 +1,80 @@
+/**
+ * magCal.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Online hard/soft-iron calibration of magnetometer. Raw magnetometer samples
+ *  are fitted to a general ellipsoid
+ *      a*x^2 + b*y^2 + c*z^2 + 2d*xy + 2e*xz + 2f*yz + 2g*x + 2h*y + 2i*z = 1
+ *  using recursive least squares (RLS), so memory use is fixed (9 parameters
+ *  and their 9x9 covariance) and no samples are stored. Fit starts from a
+ *  sphere centered in origin, so axes the sensor never rotates around (e.g.
+ *  rover driving on flat ground) stay close to that guess instead of making
+ *  the fit degenerate. A known calibration (e.g. stored one) can be given as
+ *  the starting point instead (Seed), with more confidence than the sphere.
+ *  Covariance is kept above a floor, so the fit never
+ *  stops adapting (hard-iron offset drifts over time) and rounding errors over
+ *  long runs can't make it lose positive-definiteness.
+ *  Solving the fit gives hard-iron offset and a symmetric soft-iron matrix
+ *  with unit determinant, mapping the ellipsoid back onto a sphere:
+ *      m_cal = softIron * (m_raw - offset)
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_MAGCAL_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_MAGCAL_H_
+
+#include <stdint.h>
+
+//  Number of parameters of ellipsoid fit
+#define MC_PARAMS       9
+//  Min. number of accepted samples before a fit is considered usable
+#define MC_MIN_SAMPLES  150
+//  Max. ratio between longest and shortest axis of a usable ellipsoid
+#define MC_MAX_AXIS_RATIO   3.0f
+
+
+/**
+ * Streaming ellipsoid-fit magnetometer calibrator
+ */
+class MagCal
+{
+    public:
+        MagCal();
+
+        void    Reset();
+        void    Seed(const float *offset, const float softIron[3][3]);
+        void    SetGate(float minStep)
+                    { _minStep = minStep; }
+        bool    Update(const int16_t *mag);
+        bool    Solve(float *offset, float softIron[3][3]);
+
+        //  Number of samples accepted into the fit
+        uint32_t samples;
+
+    private:
+        //  Ellipsoid parameters [a,b,c,d,e,f,g,h,i] and their covariance, fit
+        //  is done on samples normalized by _scale to keep RLS well-conditioned
+        float   _theta[MC_PARAMS];
+        float   _P[MC_PARAMS][MC_PARAMS];
+        float   _scale;
+        //  Last accepted sample and min. distance (raw units) a new one has to
+        //  be away from it, so that a stationary sensor doesn't skew the fit
+        int16_t _last[3];
+        float   _minStep;
+        //  Calibration to start the fit from once the first sample gives
+        //  field strength, and whether there's one
+        float   _seedOffset[3];
+        float   _seedSoftIron[3][3];
+        bool    _seeded;
+
+        void    _ApplySeed(const int16_t *mag);
+};
+
+#endif /* ROVERKERNEL_MPU9250_MAGCAL_H_ */
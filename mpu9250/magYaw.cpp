@@ -0,0 +1,110 @@
+/**
+ * magYaw.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "magYaw.h"
+
+#if defined(__HAL_USE_MPU9250_DMP__)    //  Compile only if module is enabled
+
+#include "libs/myLib.h"
+
+
+MagYaw::MagYaw() : yaw(0.0f), _k(0.0f), _c(1.0f), _s(0.0f), _init(false)
+{
+}
+
+/**
+ * Configure speed of correction
+ * @param tau Time constant of correction in seconds, 0 disables correction
+ * @param rate Rate of magnetometer samples passed to Update() in Hz
+ */
+void MagYaw::Setup(float tau, float rate)
+{
+    if ((tau <= 0.0f) || (rate <= 0.0f))
+        _k = 0.0f;
+    else
+        _k = 1.0f / (tau * rate + 1.0f);
+    Reset();
+}
+
+/**
+ * Drop correction, next magnetometer sample sets the heading directly
+ */
+void MagYaw::Reset()
+{
+    yaw = 0.0f;
+    _c = 1.0f;
+    _s = 0.0f;
+    _init = false;
+}
+
+/**
+ * Update correction with new magnetometer sample
+ * Magnetic field is rotated into world frame with uncorrected quaternion, and
+ * correction is moved towards the one that brings its horizontal part onto
+ * world x axis.
+ * @param q DMP quaternion [w,x,y,z], rotation from body to world frame
+ * @param mag Magnetic field in body frame, any units
+ */
+void MagYaw::Update(const float *q, const float *mag)
+{
+    float mx, my, err;
+
+    if (_k == 0.0f)
+        return;
+
+    //  First two rows of rotation matrix of q applied to mag
+    mx = (1.0f - 2.0f*(q[2]*q[2] + q[3]*q[3]))*mag[0]
+       + 2.0f*(q[1]*q[2] - q[0]*q[3])*mag[1]
+       + 2.0f*(q[1]*q[3] + q[0]*q[2])*mag[2];
+    my = 2.0f*(q[1]*q[2] + q[0]*q[3])*mag[0]
+       + (1.0f - 2.0f*(q[1]*q[1] + q[3]*q[3]))*mag[1]
+       + 2.0f*(q[2]*q[3] - q[0]*q[1])*mag[2];
+    //  Field (nearly) vertical, heading undefined
+    if ((mx == 0.0f) && (my == 0.0f))
+        return;
+
+    //  Correction that would zero the heading, and the step towards it
+    //  taken along the shorter way around the circle
+    err = -atan2f(my, mx) - yaw;
+    if (err > PI_CONST)
+        err -= 2.0f*PI_CONST;
+    else if (err < -PI_CONST)
+        err += 2.0f*PI_CONST;
+
+    if (_init)
+        yaw += _k * err;
+    else
+        yaw += err;
+    _init = true;
+
+    if (yaw > PI_CONST)
+        yaw -= 2.0f*PI_CONST;
+    else if (yaw < -PI_CONST)
+        yaw += 2.0f*PI_CONST;
+
+    _c = cosf(yaw/2.0f);
+    _s = sinf(yaw/2.0f);
+}
+
+/**
+ * Apply correction to a quaternion, out = [c,0,0,s] * q
+ * @param q DMP quaternion [w,x,y,z]
+ * @param out Corrected quaternion [w,x,y,z], can be the same buffer as q
+ */
+void MagYaw::Apply(const float *q, float *out)
+{
+    float w = _c*q[0] - _s*q[3];
+    float x = _c*q[1] - _s*q[2];
+    float y = _c*q[2] + _s*q[1];
+    float z = _c*q[3] + _s*q[0];
+
+    out[0] = w;
+    out[1] = x;
+    out[2] = y;
+    out[3] = z;
+}
+
+#endif  /* __HAL_USE_MPU9250_DMP__ */
@@ -0,0 +1,54 @@
+/**
+ * magYaw.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Magnetometer heading correction for 6-axis quaternion produced by DMP. DMP
+ *  fuses only accelerometer and gyroscope, so its yaw drifts. Here magnetic
+ *  field is tilt-compensated by rotating it into world frame with DMP
+ *  quaternion, and its heading is used to slowly rotate the quaternion around
+ *  world z axis (complementary filter on yaw only). Roll and pitch from DMP
+ *  are left untouched. Correction costs one quaternion product per packet,
+ *  trigonometry is done only for new magnetometer samples.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_MAGYAW_H_) && defined(__HAL_USE_MPU9250_DMP__)
+#define ROVERKERNEL_MPU9250_MAGYAW_H_
+
+#include <stdint.h>
+
+
+/**
+ * Complementary yaw correction of a quaternion using magnetometer
+ */
+class MagYaw
+{
+    public:
+        MagYaw();
+
+        void    Setup(float tau, float rate);
+        void    Reset();
+        void    Update(const float *q, const float *mag);
+        void    Apply(const float *q, float *out);
+
+        //  Current correction around world z axis in radians
+        float   yaw;
+
+    private:
+        //  Part of heading error corrected with each magnetometer sample, 0
+        //  if correction is disabled
+        float   _k;
+        //  Cosine and sine of half of yaw, quaternion of the correction
+        float   _c, _s;
+        //  False until the first magnetometer sample is used
+        bool    _init;
+};
+
+#endif /* ROVERKERNEL_MPU9250_MAGYAW_H_ */
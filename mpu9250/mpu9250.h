@@ -1,142 +1,328 @@
-/**
- * MPU9250.h
- *
- *  Created on: 25. 3. 2015.
- *      Author: Vedran Mikov
- *
- *  @version V3.1.0
- *  V1.0 - 25.3.2016
- *  +MPU9250 library now implemented as a C++ object
- *  V1.1 - 25.6.2016
- *  +New class Orientation added in order to provide single interface for position data
- *  V1.2 - 25.2.2017
- *  +Integration with task scheduler
- *  V1.2.1 - 11.3.2017
- *  +Changed MPU9250 class into a singleton
- *  V3.0 - 29.5.2017
- *  +Completely rewriting MPU9250 class, uses built-in digital motion processor
- *  instead of reading raw sensor data.
- *  V3.0.1 - 2.7.2017
- *  +Change include paths for better portability, new way of printing to debug
- *  +Integration with event logger
- *  V3.0.2 - 2.9.2017
- *  +Added soft-reboot for resetting only event logger status
- *  +Moved data processing from ISR to task-scheduler callback
- *  V3.0.3 - 21.9.2017
- *  *Fixed FIFO overflow error in MPU causing occasional glitches when reading
- *  sensor data
- *  V3.0.4 - 13.12.2017
- *  +HAL and hardware support power cycling of MPU. Added power-cycle step in
- *  initialization routine of MPU
- *  -Removed interrupt-based sensor readings; Polling sensor from scheduler
- *  -Removed 'listen' functionality
- *  V3.1.0 - 28.1.2018
- *  +Implemented support for SPI communication with MPU (use hwconfig.h to set
- *  the mode of communication)
- *  +Implemented support for using the MPU module without DMP firmware, getting
- *  raw sensor measurements and computing orientation from them - check
- *  api_mpu9250 files. (use hwconfig.h to select which mode of operation to use,
- *  raw data or DMP)
- *  V3.1.1 - 9.1.2018
- *  +Created interface to read acceleration/gyro/mag data
- *  +Added Mahony algorithm for attitude estimation from sensor data
- */
-#include "hwconfig.h"
-
-//  Compile following section only if hwconfig.h says to include this module
-#if !defined(ROVERKERNEL_MPU9250_MPU9250_H_) && defined(__HAL_USE_MPU9250__)
-#define ROVERKERNEL_MPU9250_MPU9250_H_
-
-//  Enable integration of this library with task scheduler but only if task
-//  scheduler is being compiled into this project
-#if defined(__HAL_USE_TASKSCH__)
-#define __USE_TASK_SCHEDULER__
-#endif  /* __HAL_USE_TASKSCH__ */
-
-//  Check if this library is set to use task scheduler
-#if defined(__USE_TASK_SCHEDULER__)
-    #include "taskScheduler/taskScheduler.h"
-    //  Unique identifier of this module as registered in task scheduler
-    #define MPU_UID             3
-    //  Definitions of ServiceID for service offered by this module
-    #define MPU_T_POWERSW         0
-    #define MPU_T_GET_DATA        1
-    #define MPU_T_REBOOT          2
-    #define MPU_T_SOFT_REBOOT     3
-    #define MPU_T_AHRS_CONFIG     4
-#endif
-
-//  Custom error codes for the library
-#define MPU_SUCCESS             0
-#define MPU_ERROR               2
-
-#if defined(__HAL_USE_MPU9250_NODMP__)
-    //  Mahony AHRS is used for computing orientation without DMP
-    #include "MahonyAHRS.h"
-#endif
-
-
-/**
- * Class object for MPU9250 sensor
- */
-class MPU9250
-{
-    friend void _MPU_KernelCallback(void);
-    friend void MPUDataHandler(void);
-    public:
-        static MPU9250& GetI();
-        static MPU9250* GetP();
-
-        int8_t  InitHW();
-        int8_t  InitSW();
-        int8_t  Reset();
-        int8_t  Enabled(bool en);
-        bool    IsDataReady();
-        uint8_t GetID();
-
-        int8_t  ReadSensorData();
-        int8_t  RPY(float* RPY, bool inDeg);
-        int8_t  Acceleration(float *acc);
-        int8_t  Gyroscope(float *gyro);
-        int8_t  Magnetometer(float *mag);
-
-        volatile float  dT;
-
-
-    protected:
-        MPU9250();
-        ~MPU9250();
-        MPU9250(MPU9250 &arg) {}              //  No definition - forbid this
-        void operator=(MPU9250 const &arg) {} //  No definition - forbid this
-
-        //  Yaw-Pitch-Roll orientation[Y,P,R] in radians
-        volatile float _ypr[3];
-        //  Acceleration [x,y,z]
-        volatile float _acc[3];
-        //  Gyroscope readings [x,y,z]
-        volatile float _gyro[3];
-        //  Magnetometer readings[x,y,z]
-        volatile float _mag[3];
-        //  Magnetometer control
-        bool _magEn;
-
-#if defined(__HAL_USE_MPU9250_NODMP__)
-    private:
-        //  Use Mahony algorithm for attitude estimations
-        Mahony _ahrs;
-    public:
-        int8_t SetupAHRS(float dT, float kp, float ki);
-#else
-    protected:
-        volatile float _gv[3];
-        volatile float _quat[4];
-#endif
-
-        //  Interface with task scheduler - provides memory space and function
-        //  to call in order for task scheduler to request service from this module
-#if defined(__USE_TASK_SCHEDULER__)
-        _kernelEntry _mpuKer;
-#endif
-};
-
-#endif /* MPU9250_H_ */
+/**
+ * MPU9250.h
+ *
+ *  Created on: 25. 3. 2015.
+ *      Author: Vedran Mikov
+ *
+ *  @version V3.1.2
+ *  V1.0 - 25.3.2016
+ *  +MPU9250 library now implemented as a C++ object
+ *  V1.1 - 25.6.2016
+ *  +New class Orientation added in order to provide single interface for position data
+ *  V1.2 - 25.2.2017
+ *  +Integration with task scheduler
+ *  V1.2.1 - 11.3.2017
+ *  +Changed MPU9250 class into a singleton
+ *  V3.0 - 29.5.2017
+ *  +Completely rewriting MPU9250 class, uses built-in digital motion processor
+ *  instead of reading raw sensor data.
+ *  V3.0.1 - 2.7.2017
+ *  +Change include paths for better portability, new way of printing to debug
+ *  +Integration with event logger
+ *  V3.0.2 - 2.9.2017
+ *  +Added soft-reboot for resetting only event logger status
+ *  +Moved data processing from ISR to task-scheduler callback
+ *  V3.0.3 - 21.9.2017
+ *  *Fixed FIFO overflow error in MPU causing occasional glitches when reading
+ *  sensor data
+ *  V3.0.4 - 13.12.2017
+ *  +HAL and hardware support power cycling of MPU. Added power-cycle step in
+ *  initialization routine of MPU
+ *  -Removed interrupt-based sensor readings; Polling sensor from scheduler
+ *  -Removed 'listen' functionality
+ *  V3.1.0 - 28.1.2018
+ *  +Implemented support for SPI communication with MPU (use hwconfig.h to set
+ *  the mode of communication)
+ *  +Implemented support for using the MPU module without DMP firmware, getting
+ *  raw sensor measurements and computing orientation from them - check
+ *  api_mpu9250 files. (use hwconfig.h to select which mode of operation to use,
+ *  raw data or DMP)
+ *  V3.1.1 - 9.1.2018
+ *  +Created interface to read acceleration/gyro/mag data
+ *  +Added Mahony algorithm for attitude estimation from sensor data
+ *  V3.1.2 - 18.10.2026
+ *  +Magnetometer correction in AHRS applied only for new samples (ST1/ST2)
+ *  +Online gyro bias estimation while sensor is stationary
+ *  +Online hard/soft-iron magnetometer calibration, solved outside of sensor
+ *  reading (MagCalStep)
+ *  +Non-blocking accel/gyro calibration driven from main loop/scheduler
+ *  +Sensor scales and mounting set at compile time (hwconfig.h), readings
+ *  are reported in body frame
+ *  +Runtime mounting of the chip (SetMounting), axis permutations cost no
+ *  extra multiplications per sample
+ *  +Configurable low-pass/notch prefilter between sensor readings and AHRS
+ *  +Sensor sampled at full rate, consumers get data at their own rates
+ *  (SetupOutput/GetOutput), Euler angles computed only when asked for
+ *  +DMP output rate configurable up to 200Hz (MPU_DMP_RATE), packets read from
+ *  data-ready interrupt on PA5 (InterruptMode), FIFO/latency statistics
+ *  +Magnetometer read in DMP mode, corrects yaw of DMP quaternion (SetupMagYaw)
+ *  +Quaternion, rotation matrix and gravity accessors in both modes, reading
+ *  a consistent snapshot of attitude
+ *  +Initialization polls for readiness of the chip instead of waiting fixed
+ *  worst-case delays, boot time is measured (BootTime)
+ *  +Non-blocking initialization in Direct-sensor-reading mode
+ *  (StartInitSW/InitSWStep), sensor configured from tables of register
+ *  accesses
+ *  +Calibration stored in on-chip EEPROM when it completes and restored on
+ *  boot (SaveCalibration/LoadCalibration); online magnetometer calibration
+ *  continues from the restored one and is stored periodically
+ *  +Warm start in DMP mode keeps firmware loaded in the MPU after a restart
+ *  of the MCU, verified by CRC of DMP memory (WarmStart)
+ *  +Raw readings of the last sample (RawData)
+ *  +Output rate and low-pass filter bandwidth changeable at runtime
+ *  (SetSampleRate/SetDMPRate, SetDLPF)
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_MPU9250_H_) && defined(__HAL_USE_MPU9250__)
+#define ROVERKERNEL_MPU9250_MPU9250_H_
+
+//  Enable integration of this library with task scheduler but only if task
+//  scheduler is being compiled into this project
+#if defined(__HAL_USE_TASKSCH__)
+#define __USE_TASK_SCHEDULER__
+#endif  /* __HAL_USE_TASKSCH__ */
+
+//  Check if this library is set to use task scheduler
+#if defined(__USE_TASK_SCHEDULER__)
+    #include "taskScheduler/taskScheduler.h"
+    //  Unique identifier of this module as registered in task scheduler
+    #define MPU_UID             3
+    //  Definitions of ServiceID for service offered by this module
+    #define MPU_T_POWERSW         0
+    #define MPU_T_GET_DATA        1
+    #define MPU_T_REBOOT          2
+    #define MPU_T_SOFT_REBOOT     3
+    #define MPU_T_AHRS_CONFIG     4
+#endif
+
+//  Custom error codes for the library
+#define MPU_SUCCESS             0
+#define MPU_BUSY                1
+#define MPU_ERROR               2
+
+#if defined(__HAL_USE_MPU9250_NODMP__)
+    //  Mahony AHRS is used for computing orientation without DMP
+    #include "MahonyAHRS.h"
+    #include "gyroBias.h"
+    #include "magCal.h"
+    #include "sensorConfig.h"
+    #include "preFilter.h"
+    #include "decimator.h"
+    #include "calStore.h"
+
+    //  Max. number of consumers with their own output rate
+    #define MPU_MAX_OUTPUTS     4
+    //  Max. change of temperature (deg C) since calibration was stored for
+    //  which stored gyro bias estimate is still used
+    #define MPU_CAL_MAX_DTEMP   10
+
+    //  States of non-blocking initialization
+    #define MPU_INIT_IDLE       0   //  Not running
+    #define MPU_INIT_POWER      1   //  Power switched off, waiting to discharge
+    #define MPU_INIT_CONFIG     2   //  Configuring sensors after power-on
+    #define MPU_INIT_CAL        3   //  Configuring sensors after calibration
+#else
+    //  Magnetometer yaw correction of DMP output
+    #include "magYaw.h"
+
+    //  Max. output rate of DMP in Hz
+    #define MPU_DMP_MAX_RATE    200
+
+/**
+ * Statistics of reading DMP output, used to check that packets are read as
+ * soon as they are produced and FIFO never fills up
+ */
+struct MPUStats
+{
+    uint32_t packets;   //  Packets read from FIFO
+    uint32_t reads;     //  Number of times FIFO was read
+    uint32_t late;      //  Reads which found more than one packet in FIFO
+    uint32_t errors;    //  Failed reads, FIFO overflows and corruptions
+    uint16_t fifoLast;  //  Packets found in FIFO at the last read
+    uint16_t fifoMax;   //  Max. packets found in FIFO at a read
+    //  Time from data-ready interrupt until its packet was processed in us,
+    //  last and max. value (interrupt mode only)
+    uint32_t latLast;
+    uint32_t latMax;
+};
+#endif
+
+
+/**
+ * Class object for MPU9250 sensor
+ */
+class MPU9250
+{
+    friend void _MPU_KernelCallback(void);
+    friend void MPUDataHandler(void);
+    public:
+        static MPU9250& GetI();
+        static MPU9250* GetP();
+
+        int8_t  InitHW();
+        int8_t  InitSW();
+        int8_t  Reset();
+        int8_t  Enabled(bool en);
+        bool    IsDataReady();
+        uint8_t GetID();
+        uint32_t BootTime();
+
+        int8_t  ReadSensorData();
+        int8_t  RPY(float* RPY, bool inDeg);
+        int8_t  Acceleration(float *acc);
+        int8_t  Gyroscope(float *gyro);
+        int8_t  Magnetometer(float *mag);
+        int8_t  Quaternion(float *q, uint32_t *seq = 0);
+        int8_t  RotationMatrix(float R[3][3]);
+        int8_t  Gravity(float *g);
+
+        volatile float  dT;
+
+
+    protected:
+        MPU9250();
+        ~MPU9250();
+        MPU9250(MPU9250 &arg) {}              //  No definition - forbid this
+        void operator=(MPU9250 const &arg) {} //  No definition - forbid this
+
+        //  Yaw-Pitch-Roll orientation[Y,P,R] in radians
+        volatile float _ypr[3];
+        //  Acceleration [x,y,z]
+        volatile float _acc[3];
+        //  Gyroscope readings [x,y,z] (rad/s when not using DMP)
+        volatile float _gyro[3];
+        //  Magnetometer readings[x,y,z]
+        volatile float _mag[3];
+        //  Magnetometer control
+        bool _magEn;
+        //  Attitude quaternion [w,x,y,z], rotation from body to world frame.
+        //  _quatSeq is odd while _quat is being updated
+        volatile float    _quat[4];
+        volatile uint32_t _quatSeq;
+        //  Time from power-on to first valid sample in last InitSW(), in us
+        uint32_t _bootTime;
+
+#if defined(__HAL_USE_MPU9250_NODMP__)
+    private:
+        //  Use Mahony algorithm for attitude estimations
+        Mahony _ahrs;
+        //  Status of last magnetometer sample (MAG_STATUS_* flags)
+        volatile uint8_t _magStatus;
+        //  Raw readings of last sample [acc, gyro, mag]
+        int16_t  _raw[9];
+        //  Online gyro bias estimator, and flag whether it's in use
+        GyroBias _gBias;
+        bool     _gBiasEn;
+        //  Online magnetometer calibration, flag whether it's running, and
+        //  flag that enough new samples were collected to solve it again
+        MagCal   _magCal;
+        bool     _magCalEn;
+        volatile bool _magSolveDue;
+        //  Whether online calibration was stored since boot, and when
+        bool     _magSaved;
+        uint32_t _magSaveTime;
+        //  Magnetometer calibration: hard-iron offset (raw units) and
+        //  soft-iron matrix
+        float    _magOffset[3];
+        float    _magSoftIron[3][3];
+        //  Raw-to-mG conversion with calibration folded in, in two sets so a
+        //  new one is built aside and switched to at once:
+        //  _mag = _magM[_magSet] * raw - _magB[_magSet]
+        float    _magM[2][3][3];
+        float    _magB[2][3];
+        volatile uint8_t _magSet;
+        //  True while accel/gyro calibration is in progress
+        bool     _calRunning;
+        //  State of non-blocking initialization (MPU_INIT_*) and time its
+        //  current phase started in us
+        uint8_t  _initState;
+        uint32_t _initStart;
+        //  Mounting of the chip on the device (chip-to-body rotation), and
+        //  raw-to-body maps for accel and gyro with it folded in if it's a
+        //  signed axis permutation (_mountPerm)
+        float    _mount[3][3];
+        bool     _mountPerm;
+        AxisMap  _accMap;
+        AxisMap  _gyroMap;
+        //  Biquad prefilter of accel/gyro readings
+        PreFilter _filter;
+        //  Rate reduction for each consumer of sensor data
+        Decimator _out[MPU_MAX_OUTPUTS];
+
+        void     _FoldMagCal();
+        void     _Rotate(float *v);
+    public:
+        int8_t  SetupAHRS(float dT, float kp, float ki);
+        int8_t  SetSampleRate(uint16_t rate);
+        int8_t  SetDLPF(uint8_t cfg);
+        uint8_t MagStatus();
+        int8_t  RawData(int16_t *acc, int16_t *gyro, int16_t *mag);
+        int8_t  SetupGyroBias(bool en, float gyroStd, float accStd,
+                              float maxRate);
+        int8_t  GyroBiasEst(float *bias);
+        int8_t  MagCalibration(bool en);
+        int8_t  MagCalStep();
+        int8_t  SetMagCalibration(const float *offset,
+                                  const float softIron[3][3]);
+        int8_t  GetMagCalibration(float *offset, float softIron[3][3]);
+        int8_t  StartInitSW();
+        int8_t  InitSWStep();
+        int8_t  StartCalibration(uint16_t samples);
+        int8_t  CalibrationStep();
+        int8_t  SaveCalibration();
+        int8_t  LoadCalibration();
+        int8_t  SetMounting(const float *rot);
+        int8_t  SetupFilter(uint8_t section, uint8_t type, uint8_t chMask,
+                            float fs, float f0, float q);
+        int8_t  SetupOutput(uint8_t id, uint16_t divider, uint8_t mode);
+        int8_t  GetOutput(uint8_t id, MPUOutput *out);
+#else
+    protected:
+        volatile float _gv[3];
+        //  Output rate of DMP in Hz, and whether data-ready interrupt is used
+        uint16_t _dmpRate;
+        bool     _intMode;
+        //  Statistics, updated where FIFO is read (interrupt in interrupt
+        //  mode), reset requested through a flag for the same reason
+        volatile MPUStats _stats;
+        volatile bool     _statsReset;
+        //  Yaw correction from magnetometer and its time constant
+        MagYaw   _magYaw;
+        float    _magTau;
+        //  Magnetometer is read every _magDiv-th DMP packet (at its own rate),
+        //  _magCnt counts packets since the last read
+        uint8_t  _magDiv;
+        uint8_t  _magCnt;
+        //  Magnetometer calibration (hard-iron offset in raw units and
+        //  soft-iron matrix) and raw-to-mG scale
+        float    _magOffset[3];
+        float    _magSoftIron[3][3];
+        float    _magScale;
+        //  Rotation of magnetometer readings into frame of DMP output
+        float    _magRot[3][3];
+
+        int8_t   _InitDMP(bool warm, uint32_t start);
+        void     _SetupMag();
+        int8_t   _ReadMag();
+    public:
+        int8_t  WarmStart();
+        int8_t  SetDMPRate(uint16_t rate);
+        int8_t  SetDLPF(uint8_t cfg);
+        int8_t  InterruptMode(bool en);
+        int8_t  Stats(MPUStats *stats, bool reset);
+        int8_t  SetupMagYaw(float tau);
+        int8_t  SetMagCalibration(const float *offset,
+                                  const float softIron[3][3]);
+        int8_t  GetMagCalibration(float *offset, float softIron[3][3]);
+#endif
+
+        //  Interface with task scheduler - provides memory space and function
+        //  to call in order for task scheduler to request service from this module
+#if defined(__USE_TASK_SCHEDULER__)
+        _kernelEntry _mpuKer;
+#endif
+};
+
+#endif /* MPU9250_H_ */
@@ -16,6 +16,15 @@
 #include "registerMap.h"
 
 
+//  Number of samples accepted into magnetometer calibration between two
+//  attempts to solve for new calibration
+#define MAG_CAL_SOLVE_PERIOD    50
+//  Online magnetometer calibration is stored (SaveCalibration) once its fit
+//  has this many accepted samples, and then at most once per period in ms,
+//  to spare EEPROM
+#define MAG_CAL_SAVE_SAMPLES    1000
+#define MAG_CAL_SAVE_PERIOD     3600000UL
+
 //  Enable debug information printed on serial port
 //#define __DEBUG_SESSION__
 
@@ -67,45 +76,112 @@ int8_t MPU9250::InitHW()
 }
 
 /**
- * Initialize MPU sensor, load DMP firmware and configure DMP output. Prior to
- * any software initialization, this function power-cycles the board
+ * Initialize MPU sensor, configure accelerometer, gyroscope and magnetometer.
+ * Prior to any software initialization, this function power-cycles the board.
+ * Blocking wrapper around StartInitSW() and InitSWStep()
  * @return One of MPU_* error codes
  */
 int8_t MPU9250::InitSW()
 {
-    //  Power cycle MPU chip before every SW initialization
-    HAL_MPU_PowerSwitch(false);
-    HAL_DelayUS(20000);
-    HAL_MPU_PowerSwitch(true);
-    HAL_DelayUS(30000);
+    int8_t retVal;
 
 #ifdef __DEBUG_SESSION__
     DEBUG_WRITE("Starting up initialization\n");
 #endif
 
-    initMPU9250();
-    initAK8963();
+    StartInitSW();
+    while ((retVal = InitSWStep()) == MPU_BUSY);
 
 #ifdef __DEBUG_SESSION__
-    DEBUG_WRITE("done\n");
+    if (retVal == MPU_SUCCESS)
+        DEBUG_WRITE("done\n");
+    else
+        DEBUG_WRITE("failed\n");
 #endif
 
+    return retVal;
+}
+
+/**
+ * Start software initialization of MPU sensor, same as InitSW() but
+ * non-blocking. Initialization is carried out by calling InitSWStep() (e.g.
+ * from main loop or task scheduler) until it stops returning MPU_BUSY, so
+ * other tasks keep running while sensor starts up. No sensor data should be
+ * read until initialization is over.
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::StartInitSW()
+{
+    //  Power cycle MPU chip before every SW initialization
+    HAL_MPU_PowerSwitch(false);
+    _initStart = HAL_TS_GetTimeUS();
+    _initState = MPU_INIT_POWER;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Perform next step of initialization started by StartInitSW()
+ * Returns after every step, each step takes at most a few bus transactions.
+ * @return MPU_BUSY while initializing, MPU_SUCCESS once sensor is configured
+ *         and running (or if no initialization is running), MPU_ERROR if
+ *         sensor didn't respond
+ */
+int8_t MPU9250::InitSWStep()
+{
+    int8_t retVal;
+
+    switch (_initState)
+    {
+    case MPU_INIT_POWER:
+        //  Supply has to discharge while switched off, which can't be polled
+        //  for; power-on is where boot time is measured from
+        if ((HAL_TS_GetTimeUS() - _initStart) < 20000)
+            return MPU_BUSY;
+        HAL_MPU_PowerSwitch(true);
+        _initStart = HAL_TS_GetTimeUS();
+        initMPU9250Start(true);
+        _initState = MPU_INIT_CONFIG;
+        return MPU_BUSY;
+    case MPU_INIT_CONFIG:
+        retVal = initMPU9250Step();
+        if (retVal == INIT_BUSY)
+            return MPU_BUSY;
+        _initState = MPU_INIT_IDLE;
+        if (retVal != INIT_OK)
+            return MPU_ERROR;
+        _bootTime = HAL_TS_GetTimeUS() - _initStart;
+        break;
+    default:
+        break;
+    }
+
     return MPU_SUCCESS;
 }
 
 /**
  * Trigger software reset of the MPU module by writing into corresponding
- * register. Wait for 50ms afterwards for sensor to start up.
+ * register. Returns once the sensor has come out of reset.
  * @return One of MPU_* error codes
  */
 int8_t MPU9250::Reset()
 {
-    HAL_MPU_WriteByte(MPU9250_ADDRESS, PWR_MGMT_1, 1 << 7);
-    HAL_DelayUS(50000);
+    if (resetMPU9250() != INIT_OK)
+        return MPU_ERROR;
 
     return MPU_SUCCESS;
 }
 
+/**
+ * Get time it took the MPU to start up in last call to InitSW()
+ * Measured from power-on until the first valid sample.
+ * @return Boot time in us, 0 if MPU wasn't initialized
+ */
+uint32_t MPU9250::BootTime()
+{
+    return _bootTime;
+}
+
 /**
  * Control power supply of the MPU9250
  * Enable or disable power supply of the MPU9250 using external MOSFET
@@ -144,7 +220,11 @@ uint8_t MPU9250::GetID()
 
 /**
  * Trigger reading data from MPU9250
- * Read data from MPU9250 and run AHRS algorithm when done
+ * Read data from MPU9250 and run AHRS algorithm when done. Gyro bias is
+ * estimated online and subtracted before AHRS update. Magnetometer runs
+ * slower than accelerometer and gyroscope, so magnetometer correction in AHRS
+ * is only applied for samples AK8963 reports as new and valid. Otherwise,
+ * attitude is updated from accelerometer and gyroscope only.
  * @return One of MPU_* error codes
  */
 int8_t MPU9250::ReadSensorData()
@@ -156,38 +236,91 @@ int8_t MPU9250::ReadSensorData()
     readGyroData(gyro);
     //  Check if we're asked to read magnetometer
     if (_magEn)
-        readMagData(mag);
+        _magStatus = readMagData(mag);
     else
-        memset((void*)mag, 0, 3*sizeof(uint16_t));
+        _magStatus = 0;
+
+    //  Keep raw readings for RawData(), magnetometer only if it's valid
+    memcpy((void*)_raw, (void*)accel, sizeof(accel));
+    memcpy((void*)(_raw + 3), (void*)gyro, sizeof(gyro));
+    if ((_magStatus & MAG_STATUS_DRDY) && !(_magStatus & MAG_STATUS_HOFL))
+        memcpy((void*)(_raw + 6), (void*)mag, sizeof(mag));
+
+    //  Track gyro bias while the sensor is stationary
+    if (_gBiasEn)
+        _gBias.Update(gyro, accel);
+
+    //  Conversion from digital sensor readings to body frame (m/s^2, rad/s),
+    //  gyro bias is removed before readings reach AHRS. Mountings which are
+    //  an axis permutation are fully handled by the maps, others need one more
+    //  rotation
+    _accMap.Apply(accel, (float*)_acc);
+    _gyroMap.Apply(gyro, _gBias.bias, (float*)_gyro);
+    if (!_mountPerm)
+    {
+        _Rotate((float*)_acc);
+        _Rotate((float*)_gyro);
+    }
+    //  Remove vibration before readings reach AHRS (no-op unless configured)
+    _filter.Process((float*)_acc, (float*)_gyro);
 
-    //  Conversion from digital sensor readings to actual values
-    for (uint8_t i = 0; i < 3; i++)
+    if ((_magStatus & MAG_STATUS_DRDY) && !(_magStatus & MAG_STATUS_HOFL))
+    {
+        //  Feed calibration, solving it every few accepted samples is left
+        //  to MagCalStep()
+        if (_magCalEn && _magCal.Update(mag)
+            && ((_magCal.samples % MAG_CAL_SOLVE_PERIOD) == 0))
+            _magSolveDue = true;
+
+        //  Scale to mG, apply calibration and rotate to body frame in one step
+        const uint8_t s = _magSet;
+        for (uint8_t i = 0; i < 3; i++)
+            _mag[i] = _magM[s][i][0] * (float)mag[0]
+                    + _magM[s][i][1] * (float)mag[1]
+                    + _magM[s][i][2] * (float)mag[2] - _magB[s][i];   //  mG
+
+        //  Update attitude with new sensor readings
+        _ahrs.Update(_gyro[0], _gyro[1], _gyro[2],
+                     _acc[0], _acc[1], _acc[2],
+                     _mag[0], _mag[1], _mag[2]);
+    }
+    else
     {
-        _acc[i] = (float)accel[i] * getAres();  //  m/s^2
-        _gyro[i] = (float)gyro[i] * getGres();  //  deg/s
-        _mag[i] = (float)mag[i] * getMres();    //  mG
+        //  Keep last valid magnetometer sample, unless magnetometer is off
+        if (!_magEn)
+            memset((void*)_mag, 0, 3*sizeof(float));
+
+        _ahrs.UpdateNoMag(_gyro[0], _gyro[1], _gyro[2],
+                          _acc[0], _acc[1], _acc[2]);
     }
 
-    //  Update attitude with new sensor readings
-    // MPU9250 magnetometer is oriented differently than IMU
-    _ahrs.Update(_gyro[0], _gyro[1], _gyro[2],
-                 _acc[0], _acc[1], _acc[2],
-                 _mag[1], _mag[0], _mag[2]);
+    //  Publish attitude for Quaternion()/RotationMatrix()/Gravity()
+    const float quat[4] = { _ahrs.q0, _ahrs.q1, _ahrs.q2, _ahrs.q3 };
+    _quatSeq++;
+    for (uint8_t i = 0; i < 4; i++)
+        _quat[i] = quat[i];
+    _quatSeq++;
 
-    //  Copy data from AHRS object to this one
-    memcpy((void*)_ypr, (void*)_ahrs.ypr, 3*sizeof(float));
+    //  Hand the sample to consumers, each publishes at its own rate
+    for (uint8_t i = 0; i < MPU_MAX_OUTPUTS; i++)
+        _out[i].Push((float*)_acc, (float*)_gyro, (float*)_mag, quat);
 
     return MPU_SUCCESS;
 }
 
 /**
  * Copy orientation from internal buffer to user-provided one
+ * Angles are computed from the current attitude on every call, so consumers
+ * not needing every sample should prefer GetOutput().
  * @param RPY pointer to float buffer of size 3 to hold roll-pitch-yaw
  * @param inDeg if true RPY returned in degrees, if false in radians
  * @return One of MPU_* error codes
  */
 int8_t MPU9250::RPY(float* RPY, bool inDeg)
 {
+    _ahrs.ComputeAngles();
+    memcpy((void*)_ypr, (void*)_ahrs.ypr, 3*sizeof(float));
+
     //  Copy data from internal buffer to a user-provided one, perform
     //  conversion from radians to degrees if asked
     for (uint8_t i = 0; i < 3; i++)
@@ -221,8 +354,10 @@ int8_t MPU9250::Acceleration(float *acc)
  */
 int8_t MPU9250::Gyroscope(float *gyro)
 {
-    //  Copy data from internal buffer to a user-provided one
-    memcpy((void*)gyro, (void*)_gyro, sizeof(float)*3);
+    //  Copy data from internal buffer to a user-provided one, internally rates
+    //  are kept in rad/s
+    for (uint8_t i = 0; i < 3; i++)
+        gyro[i] = _gyro[i] * 180.0f / PI_CONST;
 
     return MPU_SUCCESS;
 }
@@ -241,6 +376,456 @@ int8_t MPU9250::Magnetometer(float *mag)
     return MPU_SUCCESS;
 }
 
+/**
+ * Copy attitude quaternion from internal buffer to user-provided one
+ * Quaternion is copied as a whole, never mixing two updates. Don't call from
+ * an interrupt that can preempt ReadSensorData().
+ * @param q Pointer to float buffer of size 4 to hold quaternion [w,x,y,z],
+ *        rotation from body to world frame
+ * @param seq Optional buffer to hold sequence number of the quaternion, it
+ *        changes with every update
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Quaternion(float *q, uint32_t *seq)
+{
+    uint32_t s;
+
+    //  Copy again if attitude was updated while copying
+    do
+    {
+        s = _quatSeq;
+        for (uint8_t i = 0; i < 4; i++)
+            q[i] = _quat[i];
+    } while ((s & 1) || (s != _quatSeq));
+
+    if (seq != 0)
+        *seq = s;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get attitude as rotation matrix, v_world = R * v_body
+ * Computed from a snapshot of quaternion, without any trigonometry.
+ * @param R 3x3 matrix to hold rotation from body to world frame
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::RotationMatrix(float R[3][3])
+{
+    float q[4];
+
+    Quaternion(q);
+    R[0][0] = 1.0f - 2.0f*(q[2]*q[2] + q[3]*q[3]);
+    R[0][1] = 2.0f*(q[1]*q[2] - q[0]*q[3]);
+    R[0][2] = 2.0f*(q[1]*q[3] + q[0]*q[2]);
+    R[1][0] = 2.0f*(q[1]*q[2] + q[0]*q[3]);
+    R[1][1] = 1.0f - 2.0f*(q[1]*q[1] + q[3]*q[3]);
+    R[1][2] = 2.0f*(q[2]*q[3] - q[0]*q[1]);
+    R[2][0] = 2.0f*(q[1]*q[3] - q[0]*q[2]);
+    R[2][1] = 2.0f*(q[2]*q[3] + q[0]*q[1]);
+    R[2][2] = 1.0f - 2.0f*(q[1]*q[1] + q[2]*q[2]);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get direction of gravity in body frame, computed from a snapshot of
+ * quaternion. This is world z axis (up) seen from body, as measured by
+ * accelerometer at rest: [0,0,1] when level.
+ * @param g Pointer to float buffer of size 3 to hold unit gravity vector
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::Gravity(float *g)
+{
+    float q[4];
+
+    Quaternion(q);
+    g[0] = 2.0f*(q[1]*q[3] - q[0]*q[2]);
+    g[1] = 2.0f*(q[2]*q[3] + q[0]*q[1]);
+    g[2] = 1.0f - 2.0f*(q[1]*q[1] + q[2]*q[2]);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get raw readings of the last sample, as read from sensor registers
+ * Readings are in sensor frame, without calibration or filtering applied.
+ * Magnetometer reading is the last valid one.
+ * @param acc Buffer of size 3 for accelerometer reading
+ * @param gyro Buffer of size 3 for gyroscope reading
+ * @param mag Buffer of size 3 for magnetometer reading
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::RawData(int16_t *acc, int16_t *gyro, int16_t *mag)
+{
+    memcpy((void*)acc, (void*)_raw, 3*sizeof(int16_t));
+    memcpy((void*)gyro, (void*)(_raw + 3), 3*sizeof(int16_t));
+    memcpy((void*)mag, (void*)(_raw + 6), 3*sizeof(int16_t));
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get status of the last magnetometer sample
+ * @return Combination of MAG_STATUS_* flags, 0 if magnetometer is disabled
+ */
+uint8_t MPU9250::MagStatus()
+{
+    return _magStatus;
+}
+
+/**
+ * Configure online gyro bias estimation
+ * Bias is updated only while sensor is stationary, i.e. when standard
+ * deviation of gyro and accel readings over a short window is below given
+ * limits and the gyro doesn't report a steady rotation. Disabling estimation
+ * also clears current bias estimate.
+ * @param en Enable/disable online bias estimation
+ * @param gyroStd Max. std. deviation of gyro while stationary in deg/s
+ * @param accStd Max. std. deviation of accel while stationary in m/s^2
+ * @param maxRate Max. mean rotation rate in deg/s to accept as bias
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetupGyroBias(bool en, float gyroStd, float accStd,
+                              float maxRate)
+{
+    //  Convert limits to raw sensor units used by the estimator
+    float gStd = gyroStd / getGres();
+    float aStd = accStd / getAres();
+
+    _gBias.SetThresholds(gStd*gStd, aStd*aStd, maxRate / getGres());
+    if (!en)
+        _gBias.Reset();
+    _gBiasEn = en;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Copy current gyro bias estimate to user-provided buffer
+ * @param bias Pointer a float array of min. size 3 to store gyro bias in deg/s
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::GyroBiasEst(float *bias)
+{
+    for (uint8_t i = 0; i < 3; i++)
+        bias[i] = _gBias.bias[i] * getGres();
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Start or stop online magnetometer calibration
+ * Starting the calibration drops previous fit (but not the calibration in use,
+ * that is replaced once new fit is good enough). Rotate sensor through as many
+ * orientations as possible for calibration to converge.
+ * @param en true to (re)start calibration, false to freeze current one
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::MagCalibration(bool en)
+{
+    if (en)
+        _magCal.Reset();
+    _magSolveDue = false;
+    _magCalEn = en;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Solve online magnetometer calibration for samples collected so far
+ * Solving is too slow to be done while reading the sensor, so
+ * ReadSensorData() only collects samples and flags when a new solution is
+ * due. Call this from main loop or task scheduler, in the same context as
+ * ReadSensorData(). New calibration replaces the one in use at once, once
+ * fit is good enough. It's also stored for the next boot once the fit is
+ * well established, and then about once an hour.
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::MagCalStep()
+{
+    if (!_magSolveDue)
+        return MPU_SUCCESS;
+    _magSolveDue = false;
+
+    if (!_magCal.Solve(_magOffset, _magSoftIron))
+        return MPU_SUCCESS;
+    _FoldMagCal();
+
+    //  Not while accel/gyro calibration leaves offset registers in flux
+    if (_calRunning || (_initState != MPU_INIT_IDLE)
+        || (_magCal.samples < MAG_CAL_SAVE_SAMPLES))
+        return MPU_SUCCESS;
+    if (_magSaved
+        && ((HAL_TS_GetTimeMS() - _magSaveTime) < MAG_CAL_SAVE_PERIOD))
+        return MPU_SUCCESS;
+    _magSaved = true;
+    _magSaveTime = HAL_TS_GetTimeMS();
+
+    return SaveCalibration();
+}
+
+/**
+ * Load magnetometer calibration, e.g. one obtained earlier from
+ * GetMagCalibration()
+ * Online calibration is restarted from it, so its fit only refines the loaded
+ * calibration instead of replacing it with one from the first few samples.
+ * @param offset Hard-iron offset in raw magnetometer units [x,y,z]
+ * @param softIron Soft-iron correction matrix
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetMagCalibration(const float *offset,
+                                  const float softIron[3][3])
+{
+    memcpy((void*)_magOffset, (void*)offset, sizeof(_magOffset));
+    memcpy((void*)_magSoftIron, (void*)softIron, sizeof(_magSoftIron));
+    _FoldMagCal();
+    _magCal.Seed(_magOffset, _magSoftIron);
+    _magSolveDue = false;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Copy magnetometer calibration in use to user-provided buffers
+ * @param offset Buffer of size 3 to hold hard-iron offset in raw units
+ * @param softIron 3x3 matrix to hold soft-iron correction
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::GetMagCalibration(float *offset, float softIron[3][3])
+{
+    memcpy((void*)offset, (void*)_magOffset, sizeof(_magOffset));
+    memcpy((void*)softIron, (void*)_magSoftIron, sizeof(_magSoftIron));
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Start calibration of accelerometer and gyroscope
+ * Calibration doesn't block, it's carried out by calling CalibrationStep()
+ * (e.g. from main loop or task scheduler) until it stops returning MPU_BUSY.
+ * Sensor must be kept still and level while calibrating, and no sensor data
+ * should be read until calibration is over.
+ * @param samples Number of samples (at 1kHz) to average, more samples give
+ *        better bias estimate
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::StartCalibration(uint16_t samples)
+{
+    calibrateMPU9250Start(samples);
+    _calRunning = true;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Perform next step of calibration started by StartCalibration()
+ * Returns after every step, so it can be called from a loop which also runs
+ * other tasks. Needs to be called at least every ~40ms while calibrating. Once
+ * calibration is done, biases are stored in MPU's offset registers, sensor
+ * is configured again for normal operation and calibration is saved into
+ * EEPROM (SaveCalibration), to be restored on the next boot.
+ * @return MPU_BUSY while calibrating or configuring the sensor again,
+ *         MPU_SUCCESS once done (or if no calibration is running), MPU_ERROR
+ *         if sensor didn't respond after calibration or calibration couldn't
+ *         be saved
+ */
+int8_t MPU9250::CalibrationStep()
+{
+    float gBias[3], aBias[3];
+    int8_t retVal;
+
+    if (_calRunning)
+    {
+        if (calibrateMPU9250Step(gBias, aBias) == CAL_BUSY)
+            return MPU_BUSY;
+
+        //  Calibration resets the sensor, configure it again (without blocking)
+        _calRunning = false;
+        initMPU9250Start(true);
+        _initState = MPU_INIT_CAL;
+
+#ifdef __DEBUG_SESSION__
+        DEBUG_WRITE("Calibrated, gyro bias(mdps): %d %d %d\n",
+                    (int32_t)(gBias[0]*1000), (int32_t)(gBias[1]*1000),
+                    (int32_t)(gBias[2]*1000));
+#endif
+    }
+
+    if (_initState != MPU_INIT_CAL)
+        return MPU_SUCCESS;
+
+    retVal = initMPU9250Step();
+    if (retVal == INIT_BUSY)
+        return MPU_BUSY;
+    _initState = MPU_INIT_IDLE;
+    if (retVal != INIT_OK)
+        return MPU_ERROR;
+    //  Online estimate was tracking bias which is now removed in hardware
+    _gBias.Reset();
+
+    return SaveCalibration();
+}
+
+/**
+ * Store calibration in use into on-chip EEPROM
+ * Record holds accel/gyro offsets from MPU's offset registers (as left there
+ * by calibration), magnetometer calibration, online gyro bias estimate and
+ * temperature at which they were valid. Restore it with LoadCalibration().
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SaveCalibration()
+{
+    MPUCalRecord rec;
+
+    readOffsetsMPU9250(rec.gyroOffset, rec.accelOffset);
+    rec.tempRef = readTempData();
+    rec.gyroScale = MPU_GYRO_SCALE;
+    rec.accelScale = MPU_ACCEL_SCALE;
+    memcpy((void*)rec.magOffset, (void*)_magOffset, sizeof(rec.magOffset));
+    memcpy((void*)rec.magSoftIron, (void*)_magSoftIron,
+           sizeof(rec.magSoftIron));
+    memcpy((void*)rec.gyroBias, (void*)_gBias.bias, sizeof(rec.gyroBias));
+
+    if (calStoreSave(&rec) != CAL_STORE_OK)
+        return MPU_ERROR;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Restore calibration stored by SaveCalibration(), call after InitSW()
+ * Offsets are written straight into MPU's offset registers and the rest into
+ * magnetometer correction and gyro bias estimator, so no calibration or
+ * settling period is needed after boot. Gyro bias estimate is in raw units
+ * and drifts with temperature, so it's only restored if sensor configuration
+ * is the same and temperature is within MPU_CAL_MAX_DTEMP of the stored one.
+ * @return MPU_SUCCESS if calibration was restored, MPU_ERROR if there's no
+ *         valid calibration stored
+ */
+int8_t MPU9250::LoadCalibration()
+{
+    MPUCalRecord rec;
+    int32_t dTemp;
+
+    if (calStoreLoad(&rec) != CAL_STORE_OK)
+        return MPU_ERROR;
+
+    writeOffsetsMPU9250(rec.gyroOffset, rec.accelOffset);
+    SetMagCalibration(rec.magOffset, rec.magSoftIron);
+
+    //  Temperature sensitivity is 333.87 LSB/deg C
+    dTemp = (int32_t)readTempData() - rec.tempRef;
+    if ((rec.gyroScale == MPU_GYRO_SCALE) && (rec.accelScale == MPU_ACCEL_SCALE)
+        && (abs(dTemp) < (int32_t)(MPU_CAL_MAX_DTEMP * 333.87f)))
+        _gBias.Set(rec.gyroBias);
+    else
+        _gBias.Reset();
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Set mounting of the sensor on the device
+ * Rotation is given the same way as orientation matrix of DMP: row-major
+ * matrix rotating chip frame into body frame, applied on top of the sensor
+ * mounting from hwconfig.h. It's used for both accel/gyro and magnetometer.
+ * Rotations which only swap and negate axes are folded into per-axis scales,
+ * and cost nothing extra per sample. Any other rotation costs one 3x3 matrix
+ * multiplication per accel/gyro sample, magnetometer has it folded into its
+ * calibration in any case.
+ * @param rot Row-major 3x3 rotation matrix
+ * @return MPU_SUCCESS if mounting was set, MPU_ERROR if matrix isn't a rotation
+ */
+int8_t MPU9250::SetMounting(const float *rot)
+{
+    int8_t axes[3];
+    uint8_t i, j;
+
+    //  Rows of a rotation matrix are orthonormal
+    for (i = 0; i < 3; i++)
+        for (j = i; j < 3; j++)
+        {
+            float dot = rot[3*i]*rot[3*j] + rot[3*i+1]*rot[3*j+1]
+                      + rot[3*i+2]*rot[3*j+2];
+            if (fabsf(dot - (i == j ? 1.0f : 0.0f)) > 1e-3f)
+                return MPU_ERROR;
+        }
+
+    memcpy((void*)_mount, (void*)rot, sizeof(_mount));
+    _mountPerm = MountToAxes(rot, axes);
+    //  Mounting which isn't a permutation is applied after the maps
+    if (!_mountPerm)
+    {
+        axes[0] = AXIS_PX;
+        axes[1] = AXIS_PY;
+        axes[2] = AXIS_PZ;
+    }
+    _accMap.Set<MPUConfig::ImuMount>(axes, MPUConfig::ARes());
+    _gyroMap.Set<MPUConfig::ImuMount>(axes, MPUConfig::GRes());
+    _FoldMagCal();
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Configure one section of the accel/gyro prefilter
+ * Prefilter is a cascade of up to PF_MAX_SECTIONS biquads applied to body-
+ * frame readings before AHRS, on top of MPU's own low-pass filter. It can be
+ * retuned at any time, new settings take effect on the next sample.
+ * @param section Index of section, 0 to PF_MAX_SECTIONS-1
+ * @param type PF_LOWPASS, PF_NOTCH or PF_BYPASS to disable the section
+ * @param chMask Channels to configure (PF_CH_ACCEL, PF_CH_GYRO, PF_CH_ALL or
+ *        bits for individual channels [ax,ay,az,gx,gy,gz])
+ * @param fs Rate at which ReadSensorData() is called, in Hz
+ * @param f0 Cut-off (low-pass) or center (notch) frequency in Hz
+ * @param q Quality factor (0.7071 for Butterworth low-pass)
+ * @return MPU_SUCCESS if configured, MPU_ERROR if parameters are invalid
+ */
+int8_t MPU9250::SetupFilter(uint8_t section, uint8_t type, uint8_t chMask,
+                            float fs, float f0, float q)
+{
+    if (!_filter.Setup(section, type, chMask, fs, f0, q))
+        return MPU_ERROR;
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Configure output rate of one consumer of sensor data
+ * Sensor is read and attitude updated at full rate (every ReadSensorData()
+ * call), while each consumer sees only a reduced stream through GetOutput().
+ * @param id Consumer ID, 0 to MPU_MAX_OUTPUTS-1
+ * @param divider Publish once every divider sensor samples, 0 to disable
+ * @param mode DEC_AVERAGE to average samples over the period, DEC_LATEST to
+ *        only pass the last one
+ * @return MPU_SUCCESS if configured, MPU_ERROR if ID is invalid
+ */
+int8_t MPU9250::SetupOutput(uint8_t id, uint16_t divider, uint8_t mode)
+{
+    if ((id >= MPU_MAX_OUTPUTS) || (mode > DEC_LATEST))
+        return MPU_ERROR;
+
+    _out[id].Setup(divider, mode);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Get sample published to a consumer since its last call
+ * @param id Consumer ID, 0 to MPU_MAX_OUTPUTS-1
+ * @param out Buffer to hold the sample
+ * @return MPU_SUCCESS if new sample was copied to out, MPU_BUSY if there's
+ *         nothing new yet, MPU_ERROR if ID is invalid
+ */
+int8_t MPU9250::GetOutput(uint8_t id, MPUOutput *out)
+{
+    if (id >= MPU_MAX_OUTPUTS)
+        return MPU_ERROR;
+
+    return _out[id].Fetch(out) ? MPU_SUCCESS : MPU_BUSY;
+}
+
 /**
  * Configure settings of AHRS algorithm
  * @note Using dT=0 will not update the value of dT in AHRS. This can be used
@@ -261,17 +846,137 @@ int8_t MPU9250::SetupAHRS(float dT, float kp, float ki)
     return MPU_SUCCESS;
 }
 
+/**
+ * Change output data rate of the sensor at runtime
+ * Rate is set through sample rate divider, so the sensor runs at the closest
+ * rate of 1kHz/n not above the one asked for. Time step of AHRS follows it.
+ * Prefilter (SetupFilter) and outputs (SetupOutput) are configured in samples,
+ * reconfigure them if they should keep their frequencies. Setting is kept
+ * through following initializations and calibrations.
+ * @param rate Desired output data rate in Hz, 4 to 1000
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetSampleRate(uint16_t rate)
+{
+    uint8_t div, dlpf;
+
+    if ((rate < 4) || (rate > 1000))
+        return MPU_ERROR;
+
+    getFilterMPU9250(&div, &dlpf);
+    div = (uint8_t)((1000 + rate - 1) / rate - 1);
+    setFilterMPU9250(div, dlpf);
+    _ahrs.InitSW((1 + div) / 1000.0f);
+
+    return MPU_SUCCESS;
+}
+
+/**
+ * Change bandwidth of the digital low-pass filter in accel and gyro at runtime
+ * Setting is kept through following initializations and calibrations.
+ * @param cfg DLPF_CFG, 1 (184Hz gyro/218Hz accel) to 6 (5Hz)
+ * @return One of MPU_* error codes
+ */
+int8_t MPU9250::SetDLPF(uint8_t cfg)
+{
+    uint8_t div, dlpf;
+
+    if ((cfg < 1) || (cfg > 6))
+        return MPU_ERROR;
+
+    getFilterMPU9250(&div, &dlpf);
+    setFilterMPU9250(div, cfg);
+
+    return MPU_SUCCESS;
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Fold magnetometer calibration, raw-to-mG scale, magnetometer mounting and
+ * mounting of the chip into one affine transform used on every sample:
+ * _mag = chip*mount*mRes*softIron*(raw - offset) = _magM*raw - _magB
+ * Transform is built in the set not in use, then switched to, so readings
+ * never see a half-updated one
+ */
+void MPU9250::_FoldMagCal()
+{
+    float rot[3][3];
+    float (*m)[3] = _magM[!_magSet];
+    float *b = _magB[!_magSet];
+    uint8_t i, j, k;
+
+    //  Magnetometer-to-body rotation
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+        {
+            rot[i][j] = 0.0f;
+            for (k = 0; k < 3; k++)
+                rot[i][j] += _mount[i][k] * MPUConfig::MagMount::Element(k, j);
+        }
+
+    for (i = 0; i < 3; i++)
+    {
+        b[i] = 0.0f;
+        for (j = 0; j < 3; j++)
+        {
+            m[i][j] = 0.0f;
+            for (k = 0; k < 3; k++)
+                m[i][j] += rot[i][k] * _magSoftIron[k][j];
+            m[i][j] *= MPUConfig::MRes();
+            b[i] += m[i][j] * _magOffset[j];
+        }
+    }
+    _magSet = !_magSet;
+}
+
+/**
+ * Rotate vector in place by chip mounting matrix
+ * @param v Vector [x,y,z]
+ */
+void MPU9250::_Rotate(float *v)
+{
+    float t[3];
+
+    for (uint8_t i = 0; i < 3; i++)
+        t[i] = _mount[i][0]*v[0] + _mount[i][1]*v[1] + _mount[i][2]*v[2];
+    memcpy((void*)v, (void*)t, sizeof(t));
+}
+
 ///-----------------------------------------------------------------------------
 ///                      Class constructor & destructor              [PROTECTED]
 ///-----------------------------------------------------------------------------
 
-MPU9250::MPU9250() :  dT(0), _magEn(true), _ahrs()
+MPU9250::MPU9250() :  dT(0), _magEn(true), _bootTime(0), _ahrs(),
+                        _magStatus(0), _gBias(), _gBiasEn(true), _magCal(),
+                        _magCalEn(true), _magSolveDue(false),
+                        _magSaved(false), _magSaveTime(0), _magSet(0),
+                        _calRunning(false),
+                        _initState(MPU_INIT_IDLE), _initStart(0)
 {
     //  Initialize arrays
     memset((void*)_ypr, 0, 3);
     memset((void*)_acc, 0, 3);
     memset((void*)_gyro, 0, 3);
     memset((void*)_mag, 0, 3);
+    memset((void*)_raw, 0, sizeof(_raw));
+    _quat[0] = 1.0f;
+    _quat[1] = _quat[2] = _quat[3] = 0.0f;
+    _quatSeq = 0;
+
+    //  No magnetometer calibration until one is loaded or computed
+    memset((void*)_magOffset, 0, sizeof(_magOffset));
+    memset((void*)_magSoftIron, 0, sizeof(_magSoftIron));
+    _magSoftIron[0][0] = _magSoftIron[1][1] = _magSoftIron[2][2] = 1.0f;
+
+    //  Chip mounted as in hwconfig.h until told otherwise, also folds the
+    //  magnetometer calibration
+    const float identity[9] = { 1.0f, 0.0f, 0.0f,
+                                0.0f, 1.0f, 0.0f,
+                                0.0f, 0.0f, 1.0f };
+    SetMounting(identity);
 }
 
 MPU9250::~MPU9250()
@@ -0,0 +1,226 @@
+/**
+ * preFilter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "preFilter.h"
+
+#if defined(__HAL_USE_MPU9250_NODMP__)  //  Compile only if module is enabled
+
+#include "libs/myLib.h"
+
+
+PreFilter::PreFilter() : _active(0), _pending(false)
+{
+    Reset();
+}
+
+/**
+ * Configure one section of the cascade for selected channels
+ * Coefficients are computed from RBJ audio EQ cookbook formulas and take
+ * effect on the next sample processed. Sections of a channel are used up to
+ * the highest one which isn't bypassed.
+ * @param section Index of section, 0 to PF_MAX_SECTIONS-1
+ * @param type One of PF_* section types
+ * @param chMask Channels to configure, bitwise OR of bits (1 << channel) or
+ *        PF_CH_* masks
+ * @param fs Sampling frequency in Hz
+ * @param f0 Cut-off (low-pass) or center (notch) frequency in Hz
+ * @param q Quality factor, 0.7071 gives Butterworth low-pass, for notch width
+ *        of the notch is f0/q
+ * @return true if section was configured, false if parameters are invalid
+ */
+bool PreFilter::Setup(uint8_t section, uint8_t type, uint8_t chMask, float fs,
+                      float f0, float q)
+{
+    Coef c;
+
+    if ((section >= PF_MAX_SECTIONS) || (type > PF_NOTCH))
+        return false;
+    if ((type != PF_BYPASS)
+        && ((fs <= 0.0f) || (f0 <= 0.0f) || (f0 >= fs/2.0f) || (q <= 0.0f)))
+        return false;
+
+    if (type == PF_BYPASS)
+    {
+        c.b0 = 1.0f;
+        c.b1 = c.b2 = c.a1 = c.a2 = 0.0f;
+    }
+    else
+    {
+        float w = 2.0f * PI_CONST * f0 / fs;
+        float cw = cosf(w);
+        float alpha = sinf(w) / (2.0f * q);
+        float a0 = 1.0f / (1.0f + alpha);
+
+        if (type == PF_LOWPASS)
+        {
+            c.b0 = (1.0f - cw) / 2.0f * a0;
+            c.b1 = (1.0f - cw) * a0;
+            c.b2 = c.b0;
+        }
+        else
+        {
+            c.b0 = a0;
+            c.b1 = -2.0f * cw * a0;
+            c.b2 = a0;
+        }
+        c.a1 = -2.0f * cw * a0;
+        c.a2 = (1.0f - alpha) * a0;
+    }
+
+    for (uint8_t ch = 0; ch < PF_CHANNELS; ch++)
+    {
+        if (!(chMask & (1 << ch)))
+            continue;
+
+        _cfg.c[ch][section] = c;
+        //  Number of sections in use is the highest one not bypassed
+        _cfg.n[ch] = 0;
+        for (uint8_t i = 0; i < PF_MAX_SECTIONS; i++)
+            if ((_cfg.c[ch][i].b0 != 1.0f) || (_cfg.c[ch][i].b1 != 0.0f)
+                || (_cfg.c[ch][i].b2 != 0.0f) || (_cfg.c[ch][i].a1 != 0.0f)
+                || (_cfg.c[ch][i].a2 != 0.0f))
+                _cfg.n[ch] = i + 1;
+    }
+
+    //  Publish new configuration in the inactive set. With _pending cleared
+    //  the sets can't be swapped while it's being written
+    _pending = false;
+    memcpy((void*)&_set[_active ^ 1], (void*)&_cfg, sizeof(CoefSet));
+    _pending = true;
+
+    return true;
+}
+
+/**
+ * Clear filter state (history of all sections) and bypass all sections
+ * Not safe to call while filter is in use from an interrupt.
+ */
+void PreFilter::Reset()
+{
+    for (uint8_t ch = 0; ch < PF_CHANNELS; ch++)
+    {
+        for (uint8_t i = 0; i < PF_MAX_SECTIONS; i++)
+        {
+            _cfg.c[ch][i].b0 = 1.0f;
+            _cfg.c[ch][i].b1 = _cfg.c[ch][i].b2 = 0.0f;
+            _cfg.c[ch][i].a1 = _cfg.c[ch][i].a2 = 0.0f;
+        }
+        _cfg.n[ch] = 0;
+    }
+    _pending = false;
+    memcpy((void*)&_set[0], (void*)&_cfg, sizeof(CoefSet));
+    memcpy((void*)&_set[1], (void*)&_cfg, sizeof(CoefSet));
+    memset((void*)_state, 0, sizeof(_state));
+    memset((void*)_in, 0, sizeof(_in));
+}
+
+/**
+ * Filter single sample of all channels in place
+ * @param acc Acceleration [x,y,z]
+ * @param gyro Angular rate [x,y,z]
+ */
+void PreFilter::Process(float *acc, float *gyro)
+{
+    _Swap();
+    const CoefSet &set = _set[_active];
+
+    for (uint8_t ch = 0; ch < PF_CHANNELS; ch++)
+    {
+        float *v = (ch < 3) ? &acc[ch] : &gyro[ch-3];
+        float x = *v;
+
+        _in[ch] = x;
+        for (uint8_t i = 0; i < set.n[ch]; i++)
+        {
+            const Coef &c = set.c[ch][i];
+            float *s = _state[ch][i];
+            float y = c.b0*x + c.b1*s[0] + c.b2*s[1] - c.a1*s[2] - c.a2*s[3];
+
+            s[1] = s[0];
+            s[0] = x;
+            s[3] = s[2];
+            s[2] = y;
+            x = y;
+        }
+        *v = x;
+    }
+}
+
+/**
+ * Filter block of samples in place, stored as one array per channel (e.g. as
+ * produced by fifoConvert()). Each section runs over the whole block with its
+ * state kept in local variables, so state is loaded and stored once per block
+ * @param ch PF_CHANNELS pointers to arrays of n samples [ax,ay,az,gx,gy,gz]
+ * @param n Number of samples in each array
+ */
+void PreFilter::ProcessBatch(float * const *ch, uint16_t n)
+{
+    _Swap();
+    const CoefSet &set = _set[_active];
+
+    if (n == 0)
+        return;
+
+    for (uint8_t k = 0; k < PF_CHANNELS; k++)
+    {
+        _in[k] = ch[k][n-1];
+
+        for (uint8_t i = 0; i < set.n[k]; i++)
+        {
+            const Coef c = set.c[k][i];
+            float *s = _state[k][i];
+            float x1 = s[0], x2 = s[1], y1 = s[2], y2 = s[3];
+            float *v = ch[k];
+
+            for (uint16_t j = 0; j < n; j++)
+            {
+                float x = v[j];
+                float y = c.b0*x + c.b1*x1 + c.b2*x2 - c.a1*y1 - c.a2*y2;
+
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+                v[j] = y;
+            }
+            s[0] = x1;
+            s[1] = x2;
+            s[2] = y1;
+            s[3] = y2;
+        }
+    }
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Swap in new set of coefficients if one has been prepared
+ * Sections which were not in use so far have stale history. They are started
+ * from steady state at the last input of the channel instead (both low-pass
+ * and notch pass DC unchanged), so enabling a section doesn't cause a step.
+ */
+void PreFilter::_Swap()
+{
+    if (!_pending)
+        return;
+
+    const CoefSet &prev = _set[_active];
+    _active ^= 1;
+    _pending = false;
+
+    for (uint8_t ch = 0; ch < PF_CHANNELS; ch++)
+        for (uint8_t i = prev.n[ch]; i < _set[_active].n[ch]; i++)
+        {
+            float v = (i == 0) ? _in[ch] : _state[ch][i-1][2];
+
+            _state[ch][i][0] = _state[ch][i][1] = v;
+            _state[ch][i][2] = _state[ch][i][3] = v;
+        }
+}
+
+#endif  /* __HAL_USE_MPU9250_NODMP__ */
@@ -0,0 +1,88 @@
+/**
+ * preFilter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Cascade of biquad sections (low-pass and notch) used to filter converted
+ *  accelerometer and gyroscope readings before they reach AHRS, e.g. to
+ *  remove narrowband vibration of motors. Each channel [ax,ay,az,gx,gy,gz] has
+ *  its own coefficients and state, all fixed in size (PF_MAX_SECTIONS).
+ *  Sections are in direct form I, so the state is made of past inputs and
+ *  outputs of the section. Changing coefficients then continues from the
+ *  actual signal history instead of leaving the internal state of another
+ *  filter behind, which keeps retuning free of transients. New coefficients
+ *  are written into a second set and swapped in between two samples, so
+ *  retuning from main loop is safe while filter runs in interrupt. Sections
+ *  which get enabled start from steady state at the current input.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_PREFILTER_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_PREFILTER_H_
+
+#include <stdint.h>
+
+//  Number of filtered channels [ax,ay,az,gx,gy,gz] and max. sections each
+#define PF_CHANNELS         6
+#define PF_MAX_SECTIONS     4
+
+//  Masks for selecting channels to configure
+#define PF_CH_ACCEL         0x07
+#define PF_CH_GYRO          0x38
+#define PF_CH_ALL           0x3F
+
+//  Types of filter section
+#define PF_BYPASS           0
+#define PF_LOWPASS          1
+#define PF_NOTCH            2
+
+
+/**
+ * Cascaded biquad filter for accelerometer and gyroscope channels
+ */
+class PreFilter
+{
+    public:
+        PreFilter();
+
+        bool    Setup(uint8_t section, uint8_t type, uint8_t chMask, float fs,
+                      float f0, float q);
+        void    Reset();
+        void    Process(float *acc, float *gyro);
+        void    ProcessBatch(float * const *ch, uint16_t n);
+
+    private:
+        //  Coefficients of a section, normalized so that a0 = 1
+        struct Coef
+        {
+            float b0, b1, b2, a1, a2;
+        };
+        //  Set of coefficients for all channels, and number of sections in
+        //  use (sections past it are bypassed) for each channel
+        struct CoefSet
+        {
+            Coef    c[PF_CHANNELS][PF_MAX_SECTIONS];
+            uint8_t n[PF_CHANNELS];
+        };
+
+        void    _Swap();
+
+        //  Configuration as set through Setup(), and two sets used by the
+        //  filter: active one and one where new configuration is published
+        CoefSet _cfg;
+        CoefSet _set[2];
+        volatile uint8_t _active;
+        volatile bool    _pending;
+        //  Past inputs and outputs of each section [x1,x2,y1,y2]
+        float   _state[PF_CHANNELS][PF_MAX_SECTIONS][4];
+        //  Last input of each channel, used to start newly enabled sections
+        float   _in[PF_CHANNELS];
+};
+
+#endif /* ROVERKERNEL_MPU9250_PREFILTER_H_ */
@@ -4,7 +4,8 @@
  *  Created on: Mar 28, 2017
  *      Author: Vedran Mikov
  *
- *  Addresses of internal registers as provided by the datasheet
+ *  Addresses of internal registers as provided by the datasheet, and fields of
+ *  configuration registers written by initialization
  */
 
 #ifndef ROVERKERNEL_MPU9250_REGISTERMAP_H_
@@ -44,6 +45,8 @@
 #define WHO_AM_I_AK8963  0x00 // (AKA WIA) should return 0x48
 #define INFO             0x01
 #define AK8963_ST1       0x02  // data ready status bit 0
+#define AK8963_ST1_DRDY  0x01  //  ST1: new measurement is ready
+#define AK8963_ST1_DOR   0x02  //  ST1: previous measurement was skipped
 #define AK8963_XOUT_L    0x03  // data
 #define AK8963_XOUT_H    0x04
 #define AK8963_YOUT_L    0x05
@@ -51,6 +54,7 @@
 #define AK8963_ZOUT_L    0x07
 #define AK8963_ZOUT_H    0x08
 #define AK8963_ST2       0x09  // Data overflow bit 3 and data read error status bit 2
+#define AK8963_ST2_HOFL  0x08  //  ST2: magnetic sensor overflow
 #define AK8963_CNTL      0x0A  // Power down (0000), single-measurement (0001), self-test (1000) and Fuse ROM (1111) modes on bits 3:0
 #define AK8963_CNTL2     0x0B
 #define AK8963_ASTC      0x0C  // Self test control
@@ -191,4 +195,22 @@
 #define ZA_OFFSET_H        0x7D
 #define ZA_OFFSET_L        0x7E
 
+
+/*      Fields of configuration registers, given as mask within register   */
+//  Value of field, shifted into place given by its mask (constant mask only)
+#define FIELD_VAL(mask, v)      (((v) * ((mask) & (~(mask) + 1))) & (mask))
+
+#define CONFIG_DLPF_CFG         0x07    //  Gyro and thermometer bandwidth
+#define GYRO_CONFIG_FS_SEL      0x18    //  Gyro full scale (Gscale)
+#define GYRO_CONFIG_FCHOICE_B   0x03    //  Inverted gyro Fchoice
+#define ACCEL_CONFIG_FS_SEL     0x18    //  Accel full scale (Ascale)
+#define ACCEL_CONFIG2_FCHOICE_B 0x08    //  Inverted accel Fchoice
+#define ACCEL_CONFIG2_DLPF_CFG  0x07    //  Accel bandwidth
+#define I2C_SLV_RNW             0x80    //  I2C_SLVx_ADDR: read from slave
+#define I2C_SLV_EN              0x80    //  I2C_SLVx_CTRL: enable slave
+#define I2C_SLV_LENG            0x0F    //  I2C_SLVx_CTRL: bytes to read
+#define INT_PIN_CFG_LATCH_EN    0x20    //  Hold INT pin until cleared
+#define INT_PIN_CFG_ANYRD_2CLR  0x10    //  Any read clears interrupt
+#define INT_ENABLE_RAW_RDY_EN   0x01    //  Data-ready interrupt
+
 #endif /* ROVERKERNEL_MPU9250_REGISTERMAP_H_ */
@@ -0,0 +1,36 @@
+/**
+ * sensorAxes.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Axes of sensor frames, used in hwconfig.h to describe mounting of
+ *  accelerometer/gyroscope and magnetometer (MPU_MOUNT_IMU, MPU_MOUNT_MAG).
+ *  Shared by both modes of operation: direct sensor reading builds its
+ *  conversions from them (sensorConfig.h), DMP mode uses magnetometer mounting
+ *  to bring its readings into the frame of DMP output.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file, moved here from sensorConfig.h
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_SENSORAXES_H_) && defined(__HAL_USE_MPU9250__)
+#define ROVERKERNEL_MPU9250_SENSORAXES_H_
+
+//  Axes of sensor frame, used to describe which sensor axis (and with which
+//  sign) is mapped to each of the body axes
+#define AXIS_PX     1
+#define AXIS_PY     2
+#define AXIS_PZ     3
+#define AXIS_NX     (-1)
+#define AXIS_NY     (-2)
+#define AXIS_NZ     (-3)
+
+//  Index of sensor axis and its sign, for one of AXIS_* values
+#define AXIS_IDX(A)     (((A) > 0 ? (A) : -(A)) - 1)
+#define AXIS_SIGN(A)    ((A) > 0 ? 1.0f : -1.0f)
+
+#endif /* ROVERKERNEL_MPU9250_SENSORAXES_H_ */
@@ -0,0 +1,172 @@
+/**
+ * sensorConfig.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Compile-time description of MPU9250 configuration used in direct-sensor-
+ *  reading mode: full-scale ranges of sensors and mounting of accelerometer/
+ *  gyroscope and magnetometer frames relative to the chip frame. Everything is
+ *  given as template parameters, configuration in use is selected in
+ *  hwconfig.h.
+ *  Readings are converted by an AxisMap, built at runtime from the compile-
+ *  time mounting, resolution and mounting of the chip on a particular device
+ *  (when that is a signed axis permutation), so unit conversion and axis
+ *  remapping still cost a single multiplication per axis. It replaces
+ *  conversion fused at compile time (SensorMount::Apply), which couldn't take
+ *  runtime mounting into account.
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +AxisMap and reduction of runtime mounting matrix to axis permutation
+ *  -Removed compile-time conversion, superseded by AxisMap
+ */
+#include "hwconfig.h"
+
+//  Compile following section only if hwconfig.h says to include this module
+#if !defined(ROVERKERNEL_MPU9250_SENSORCONFIG_H_) && defined(__HAL_USE_MPU9250_NODMP__)
+#define ROVERKERNEL_MPU9250_SENSORCONFIG_H_
+
+#include "libs/myLib.h"
+#include "registerMap.h"
+#include "sensorAxes.h"
+
+
+/**
+ * Mounting of a 3-axis sensor: body axis x is sensor axis X, y is Y, z is Z,
+ * where X, Y, Z are one of AXIS_* values
+ */
+template <int X, int Y, int Z>
+struct SensorMount
+{
+    /**
+     * Get sensor axis mapped to a body axis
+     * @param row Body axis
+     * @return One of AXIS_* values
+     */
+    static inline int Axis(uint8_t row)
+    {
+        return (row == 0) ? X : ((row == 1) ? Y : Z);
+    }
+
+    /**
+     * Get element of the sensor-to-body rotation matrix
+     * @param row Body axis (row of the matrix)
+     * @param col Sensor axis (column of the matrix)
+     * @return -1, 0 or 1
+     */
+    static inline float Element(uint8_t row, uint8_t col)
+    {
+        const int a = Axis(row);
+        return (AXIS_IDX(a) == col) ? AXIS_SIGN(a) : 0.0f;
+    }
+};
+
+
+/**
+ * Full configuration of sensors: full-scale ranges (values from Ascale, Gscale
+ * and Mscale enums in registerMap.h) and mounting of accelerometer/gyroscope
+ * (IMU) and magnetometer (MAG) frames (SensorMount types)
+ */
+template <uint8_t ASCALE, uint8_t GSCALE, uint8_t MSCALE, class IMU, class MAG>
+struct SensorConfig
+{
+    typedef IMU ImuMount;
+    typedef MAG MagMount;
+
+    //  Accelerometer resolution in (m/s^2)/LSB, 2g (00) to 16g (11)
+    static inline float ARes()
+        { return GRAVITY_CONST * (float)(2 << ASCALE) / 32768.0f; }
+    //  Gyroscope resolution in (rad/s)/LSB, 250dps (00) to 2000dps (11)
+    static inline float GRes()
+        { return (PI_CONST / 180.0f) * (float)(250 << GSCALE) / 32768.0f; }
+    //  Magnetometer resolution in mG/LSB, 14 bit (0) or 16 bit (1)
+    static inline float MRes()
+        { return 10.0f * 4912.0f / (MSCALE == MFS_16BITS ? 32760.0f : 8190.0f); }
+};
+
+
+/**
+ * Signed axis permutation with scale, set up at runtime:
+ *      out[i] = (in[idx[i]] - bias[idx[i]]) * scale[i]
+ * where sign of scale[i] carries the sign of the mapping
+ */
+struct AxisMap
+{
+    uint8_t idx[3];
+    float   scale[3];
+
+    /**
+     * Build map from a sensor mount (SensorMount type) followed by chip
+     * mounting given as AXIS_* values
+     * @param chip Chip-to-body mounting [x,y,z] as AXIS_* values
+     * @param res Resolution of the sensor
+     */
+    template <class MOUNT>
+    void Set(const int8_t *chip, float res)
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            int a = MOUNT::Axis(AXIS_IDX(chip[i]));
+            idx[i] = AXIS_IDX(a);
+            scale[i] = AXIS_SIGN(chip[i]) * AXIS_SIGN(a) * res;
+        }
+    }
+
+    inline void Apply(const int16_t *in, float *out) const
+    {
+        out[0] = (float)in[idx[0]] * scale[0];
+        out[1] = (float)in[idx[1]] * scale[1];
+        out[2] = (float)in[idx[2]] * scale[2];
+    }
+
+    inline void Apply(const int16_t *in, const float *bias, float *out) const
+    {
+        out[0] = ((float)in[idx[0]] - bias[idx[0]]) * scale[0];
+        out[1] = ((float)in[idx[1]] - bias[idx[1]]) * scale[1];
+        out[2] = ((float)in[idx[2]] - bias[idx[2]]) * scale[2];
+    }
+};
+
+/**
+ * Check if a rotation matrix is a signed axis permutation, and if so express
+ * it as AXIS_* values
+ * @param rot Row-major 3x3 rotation matrix
+ * @param axes Buffer of size 3 to hold AXIS_* value for each row
+ * @return true if matrix was reduced to axis permutation, false otherwise
+ */
+inline bool MountToAxes(const float *rot, int8_t *axes)
+{
+    uint8_t used = 0;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        axes[i] = 0;
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            float v = rot[3*i + j];
+
+            if (fabsf(v) < 1e-4f)
+                continue;
+            //  Any other value or second non-zero element in a row
+            if ((fabsf(fabsf(v) - 1.0f) > 1e-4f) || (axes[i] != 0))
+                return false;
+            axes[i] = (v > 0.0f) ? (j + 1) : -(j + 1);
+        }
+        //  Zero row, or column already used by another row
+        if ((axes[i] == 0) || (used & (1 << AXIS_IDX(axes[i]))))
+            return false;
+        used |= 1 << AXIS_IDX(axes[i]);
+    }
+
+    return true;
+}
+
+//  Configuration in use, as set in hwconfig.h
+typedef SensorConfig<MPU_ACCEL_SCALE, MPU_GYRO_SCALE, MPU_MAG_SCALE,
+                     SensorMount<MPU_MOUNT_IMU>,
+                     SensorMount<MPU_MOUNT_MAG> > MPUConfig;
+
+#endif /* ROVERKERNEL_MPU9250_SENSORCONFIG_H_ */
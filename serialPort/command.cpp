@@ -0,0 +1,199 @@
+/**
+ * command.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "command.h"
+#include "telemetry.h"
+#include "uartHW.h"
+
+//  Fields are little-endian, independent of the byte order of the MCU
+#define GET16(p)    ((uint16_t)((p)[0] | ((p)[1] << 8)))
+
+
+///-----------------------------------------------------------------------------
+///         Functions for returning static instance                     [PUBLIC]
+///-----------------------------------------------------------------------------
+
+/**
+ * Return reference to a singleton
+ * @return reference to an internal static instance
+ */
+CmdChannel& CmdChannel::GetI()
+{
+    static CmdChannel singletonInstance;
+    return singletonInstance;
+}
+
+/**
+ * Return pointer to a singleton
+ * @return pointer to a internal static instance
+ */
+CmdChannel* CmdChannel::GetP()
+{
+    return &(CmdChannel::GetI());
+}
+
+///-----------------------------------------------------------------------------
+///         Public functions                                            [PUBLIC]
+///-----------------------------------------------------------------------------
+
+/**
+ * Register handler for a command type, replacing the existing one
+ * @param type Command type (CMD_*)
+ * @param handler Function to call for each command of this type, 0 to remove
+ *        the existing handler
+ * @return One of STATUS_* codes
+ */
+int8_t CmdChannel::Register(uint8_t type, CmdHandler handler)
+{
+    uint8_t i;
+
+    for (i = 0; i < _handlers; i++)
+        if (_type[i] == type)
+            break;
+
+    if (handler == 0)
+    {
+        //  Move the last one in place of removed handler
+        if (i < _handlers)
+        {
+            _handlers--;
+            _type[i] = _type[_handlers];
+            _handler[i] = _handler[_handlers];
+        }
+        return STATUS_OK;
+    }
+
+    if (i >= CMD_MAX_HANDLERS)
+        return STATUS_ARG_ERR;
+
+    _type[i] = type;
+    _handler[i] = handler;
+    if (i == _handlers)
+        _handlers++;
+
+    return STATUS_OK;
+}
+
+/**
+ * Process data received so far, call from main loop
+ * Data is decoded in place from receive buffer of serial port, commands are
+ * carried out and acknowledged as soon as their frame is complete. Partial
+ * frame is completed by the next call.
+ */
+void CmdChannel::Poll()
+{
+    SerialPort &port = SerialPort::GetI();
+    const uint8_t *data;
+    uint16_t n, i;
+    uint8_t c;
+    bool zero;
+
+    while ((n = port.RxPeek(&data)) > 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            c = data[i];
+
+            //  Delimiter: end of a frame, empty ones are skipped
+            if (c == 0)
+            {
+                //  Frame cut inside of a block is corrupted
+                if (!_skip && (_block != 0))
+                    _stats.badFrames++;
+                else if (!_skip && ((_len > 0) || (_code != 0xFF)))
+                    _Frame();
+
+                _len = 0;
+                _block = 0;
+                _code = 0xFF;
+                _skip = false;
+                continue;
+            }
+            if (_skip)
+                continue;
+
+            //  Code byte starts a new COBS block, previous block ends with a
+            //  zero unless it was a full one
+            if (_block == 0)
+            {
+                zero = (_code != 0xFF);
+                _code = c;
+                _block = c - 1;
+                if (!zero)
+                    continue;
+                c = 0;
+            }
+            else
+                _block--;
+
+            //  Frame longer than any valid one, delimiter must have been lost
+            if (_len >= sizeof(_frame))
+            {
+                _stats.badFrames++;
+                _skip = true;
+                continue;
+            }
+            _frame[_len++] = c;
+        }
+
+        port.RxConsume(n);
+    }
+}
+
+/**
+ * Get statistics of received commands
+ * @param stats Structure to copy statistics into
+ */
+void CmdChannel::Stats(CmdStats *stats)
+{
+    *stats = _stats;
+}
+
+///-----------------------------------------------------------------------------
+///                      Class constructor & destructor              [PROTECTED]
+///-----------------------------------------------------------------------------
+
+CmdChannel::CmdChannel() : _handlers(0), _len(0), _block(0), _code(0xFF),
+                           _skip(false)
+{
+    memset((void*)&_stats, 0, sizeof(_stats));
+}
+
+CmdChannel::~CmdChannel() {}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Check decoded frame in _frame, carry out the command and acknowledge it
+ */
+void CmdChannel::_Frame()
+{
+    uint8_t i, len, result = CMD_RES_UNKNOWN;
+
+    if (_len < (TLM_HEADER_LEN + TLM_CRC_LEN))
+    {
+        _stats.badFrames++;
+        return;
+    }
+    len = _len - TLM_CRC_LEN;
+    if (crc16(0xFFFF, _frame, len) != GET16(_frame + len))
+    {
+        _stats.crcErrors++;
+        return;
+    }
+
+    for (i = 0; i < _handlers; i++)
+        if (_type[i] == _frame[0])
+        {
+            result = _handler[i](_frame + TLM_HEADER_LEN, len - TLM_HEADER_LEN);
+            _stats.commands++;
+            break;
+        }
+
+    Telemetry::GetI().SendAck(_frame[0], _frame[1], result);
+}
@@ -0,0 +1,81 @@
+/**
+ * command.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Binary commands from the host over the debug serial port. Frames have the
+ *  same format as telemetry (tlmProtocol.h) and are parsed from main loop by
+ *  Poll(), straight out of the receive buffer of the serial port, so nothing
+ *  but storing received bytes is done in the interrupt. Each valid command is
+ *  passed to the handler registered for its type, and its result is sent back
+ *  as an acknowledgment record.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#ifndef COMMAND_H_
+#define COMMAND_H_
+#include "libs/myLib.h"
+#include "tlmProtocol.h"
+
+//  Max. number of command types with a handler
+#define CMD_MAX_HANDLERS    8
+
+/**
+ * Handler of a command type
+ * @param payload Payload of the command, little-endian fields
+ * @param len Length of payload, not checked before the call
+ * @return One of CMD_RES_* codes, sent back in acknowledgment
+ */
+typedef uint8_t (*CmdHandler)(const uint8_t *payload, uint8_t len);
+
+/**
+ * Statistics of received commands
+ */
+struct CmdStats
+{
+    uint32_t commands;  //  Commands passed to handlers
+    uint32_t crcErrors; //  Frames with bad CRC
+    uint32_t badFrames; //  Frames with bad COBS encoding, too long or short
+};
+
+/**
+ * Receiver and dispatcher of commands from host
+ */
+class CmdChannel
+{
+    public:
+        static CmdChannel& GetI();
+        static CmdChannel* GetP();
+
+        int8_t  Register(uint8_t type, CmdHandler handler);
+        void    Poll();
+        void    Stats(CmdStats *stats);
+
+    protected:
+        CmdChannel();
+        ~CmdChannel();
+        CmdChannel(CmdChannel &arg) {}           //  No definition - forbid this
+        void operator=(CmdChannel const &arg) {} //  No definition - forbid this
+
+        void    _Frame();
+
+        //  Registered handlers and their command types
+        uint8_t    _type[CMD_MAX_HANDLERS];
+        CmdHandler _handler[CMD_MAX_HANDLERS];
+        uint8_t    _handlers;
+        //  Frame being decoded, COBS decoding is done byte by byte as data
+        //  arrives: _block is number of bytes left in current COBS block,
+        //  _code is code byte of that block (zero follows it unless 0xFF)
+        uint8_t    _frame[TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN];
+        uint8_t    _len;
+        uint8_t    _block;
+        uint8_t    _code;
+        //  Frame is invalid, skipped until the next delimiter
+        bool       _skip;
+        CmdStats   _stats;
+};
+
+#endif /* COMMAND_H_ */
@@ -0,0 +1,86 @@
+/**
+ * quatCodec.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "quatCodec.h"
+
+#include <math.h>
+
+
+/**
+ * Pack quaternion into 32 bits
+ * Quaternion doesn't have to be of unit length (e.g. DMP output converted from
+ * fixed-point), it's normalized first.
+ * @param q Quaternion [w,x,y,z]
+ * @return Packed quaternion: bits 31-30 index of the largest component, bits
+ *         29-20, 19-10 and 9-0 the other three in order, see TLM_REC_QUATP
+ */
+uint32_t quatPack(const float *q)
+{
+    float n = 0.0f, big = 0.0f, v;
+    uint32_t packed;
+    uint8_t i, iBig = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        n += q[i] * q[i];
+        v = (q[i] < 0.0f) ? -q[i] : q[i];
+        if (v > big)
+        {
+            big = v;
+            iBig = i;
+        }
+    }
+    //  Zero quaternion isn't a rotation, send identity instead
+    if (n <= 0.0f)
+        return (QUATP_MAX_STEP << 20) | (QUATP_MAX_STEP << 10) | QUATP_MAX_STEP;
+
+    //  One factor normalizes, flips sign if needed and scales to steps
+    n = QUATP_SCALE / sqrtf(n);
+    if (q[iBig] < 0.0f)
+        n = -n;
+
+    packed = iBig;
+    for (i = 0; i < 4; i++)
+    {
+        if (i == iBig)
+            continue;
+
+        //  Round to nearest; rounding error can push it over the limit
+        v = q[i] * n;
+        v += (v < 0.0f) ? -0.5f : 0.5f;
+        if (v > QUATP_MAX_STEP)
+            v = QUATP_MAX_STEP;
+        else if (v < -QUATP_MAX_STEP)
+            v = -QUATP_MAX_STEP;
+
+        packed = (packed << 10) | (uint32_t)((int32_t)v + QUATP_MAX_STEP);
+    }
+
+    return packed;
+}
+
+/**
+ * Unpack quaternion packed with quatPack()
+ * @param packed Packed quaternion
+ * @param q Unit quaternion [w,x,y,z], largest component is positive
+ */
+void quatUnpack(uint32_t packed, float *q)
+{
+    uint8_t iBig = (uint8_t)(packed >> 30), i, shift = 20;
+    float sum = 0.0f;
+
+    for (i = 0; i < 4; i++)
+    {
+        if (i == iBig)
+            continue;
+
+        q[i] = (float)((int32_t)((packed >> shift) & 0x3FF) - QUATP_MAX_STEP)
+               / QUATP_SCALE;
+        sum += q[i] * q[i];
+        shift -= 10;
+    }
+    q[iBig] = (sum < 1.0f) ? sqrtf(1.0f - sum) : 0.0f;
+}
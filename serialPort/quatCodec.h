@@ -0,0 +1,43 @@
+/**
+ * quatCodec.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Packing of unit quaternion into 32 bits with the smallest-three method
+ *  (TLM_REC_QUATP records in tlmProtocol.h), shared by the MCU (telemetry.h)
+ *  and host-side decoder (tools/tlmDecoder), so it's plain C without
+ *  dependencies other than math library.
+ *  q and -q are the same rotation, so quaternion is flipped to make its
+ *  largest component positive, and only index of that component and the
+ *  other three are sent; receiver recovers it from unit length. Remaining
+ *  components are within +-1/sqrt(2), each quantized to 10 bits, which keeps
+ *  error of rotation below 0.26 deg (0.09 deg RMS).
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#ifndef QUATCODEC_H_
+#define QUATCODEC_H_
+
+#include <stdint.h>
+
+//  Quantization of the three smaller components: steps per unit, chosen so
+//  that +-1/sqrt(2) maps to +-QUATP_MAX_STEP
+#define QUATP_MAX_STEP      511
+#define QUATP_SCALE         (QUATP_MAX_STEP * 1.41421356f)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+uint32_t    quatPack(const float *q);
+void        quatUnpack(uint32_t packed, float *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QUATCODEC_H_ */
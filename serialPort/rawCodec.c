@@ -0,0 +1,150 @@
+/**
+ * rawCodec.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "rawCodec.h"
+
+#include <string.h>
+
+//  Fields are stored little-endian, independent of the layout of C structs
+#define PUT16(p, v) do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } \
+                    while (0)
+#define PUT32(p, v) do { PUT16((p), (v)); PUT16((p) + 2, (v) >> 16); } while (0)
+
+
+/**
+ * Reset encoder, next sample starts a new block with a keyframe
+ * @param enc Encoder
+ */
+void rawzInit(RawzEncoder *enc)
+{
+    memset(enc, 0, sizeof(*enc));
+    enc->sinceKey = RAWZ_KEY_PERIOD;
+}
+
+/**
+ * Add sample to the block being filled
+ * New block starts with a keyframe if it's the first one since rawzInit() or
+ * the last keyframe was RAWZ_KEY_PERIOD or more samples ago.
+ * @param enc Encoder
+ * @param time Timestamp of the sample in us
+ * @param sample Raw sample [acc, gyro, mag]
+ * @return 0 while block is being filled, length of block once it's full. Full
+ *         block is in enc->buf, valid until the next call
+ */
+uint8_t rawzPush(RawzEncoder *enc, uint32_t time, const int16_t *sample)
+{
+    uint8_t *b = enc->buf;
+    uint8_t i;
+
+    if (enc->len == 0)
+    {
+        PUT32(b, time);
+        b[8] = 0;
+        b[9] = 0;
+        enc->len = TLM_LEN_RAWZ;
+
+        if (enc->sinceKey >= RAWZ_KEY_PERIOD)
+        {
+            b[9] = TLM_RAWZ_KEY;
+            for (i = 0; i < RAWZ_AXES; i++)
+                PUT16(b + enc->len + 2*i, (uint16_t)sample[i]);
+            enc->len += 2 * RAWZ_AXES;
+            enc->sinceKey = 0;
+        }
+    }
+    if ((b[8] != 0) || !(b[9] & TLM_RAWZ_KEY))
+        enc->len += rawzDeltaEncode(enc->prev, sample, b + enc->len);
+
+    memcpy(enc->prev, sample, sizeof(enc->prev));
+    enc->sinceKey++;
+    b[8]++;
+    PUT32(b + 4, time);
+
+    //  Block is full if the next sample might not fit
+    if (((enc->len + RAWZ_MAX_DELTA) > TLM_MAX_PAYLOAD) || (b[8] == 0xFF))
+        return rawzFlush(enc);
+
+    return 0;
+}
+
+/**
+ * End the block being filled, e.g. before a pause in the stream
+ * @param enc Encoder
+ * @return Length of block in enc->buf (valid until the next call to
+ *         rawzPush()), 0 if it holds no samples
+ */
+uint8_t rawzFlush(RawzEncoder *enc)
+{
+    uint8_t len = enc->len;
+
+    enc->len = 0;
+    return len;
+}
+
+/**
+ * Encode difference between two samples
+ * @param prev Previous sample
+ * @param sample Current sample
+ * @param out Buffer for encoded difference, at least RAWZ_MAX_DELTA bytes
+ * @return Length of encoded difference
+ */
+uint8_t rawzDeltaEncode(const int16_t *prev, const int16_t *sample,
+                        uint8_t *out)
+{
+    uint8_t i, len = 0;
+    int16_t d;
+    uint16_t z;
+
+    for (i = 0; i < RAWZ_AXES; i++)
+    {
+        //  Difference wraps around, decoder wraps it back
+        d = (int16_t)(uint16_t)(sample[i] - prev[i]);
+        z = (uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15));
+
+        while (z >= 0x80)
+        {
+            out[len++] = (uint8_t)(z | 0x80);
+            z >>= 7;
+        }
+        out[len++] = (uint8_t)z;
+    }
+
+    return len;
+}
+
+/**
+ * Decode difference between two samples and apply it
+ * @param in Encoded difference
+ * @param len Number of bytes available at in
+ * @param sample Previous sample, replaced by the decoded one
+ * @return Number of bytes used, -1 if data is cut or invalid
+ */
+int16_t rawzDeltaDecode(const uint8_t *in, uint16_t len, int16_t *sample)
+{
+    uint16_t used = 0;
+    uint32_t z;
+    uint8_t i, shift;
+
+    for (i = 0; i < RAWZ_AXES; i++)
+    {
+        z = 0;
+        for (shift = 0; ; shift += 7)
+        {
+            if ((used >= len) || (shift > 14))
+                return -1;
+            z |= (uint32_t)(in[used] & 0x7F) << shift;
+            if (!(in[used++] & 0x80))
+                break;
+        }
+        if (z > 0xFFFF)
+            return -1;
+
+        sample[i] = (int16_t)(uint16_t)(sample[i]
+                                        + (uint16_t)((z >> 1) ^ (0 - (z & 1))));
+    }
+
+    return (int16_t)used;
+}
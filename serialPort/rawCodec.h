@@ -0,0 +1,64 @@
+/**
+ * rawCodec.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Compression of the stream of raw sensor samples (TLM_REC_RAWZ records in
+ *  tlmProtocol.h), shared by the MCU (telemetry.h) and host-side decoder
+ *  (tools/tlmDecoder), so it's plain C without dependencies.
+ *  Consecutive samples differ by little on every axis, so each sample is sent
+ *  as per-axis differences from the previous one, zigzag-mapped and written as
+ *  varints: sensor noise takes one byte per axis instead of two, and the
+ *  magnetometer (which updates at 100Hz) mostly zeros. Samples are grouped in
+ *  blocks which fill a record. First block that starts RAWZ_KEY_PERIOD or more
+ *  samples after the last keyframe starts with a new one, holding the sample
+ *  as it is, so receiver which lost a record resynchronizes there.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#ifndef RAWCODEC_H_
+#define RAWCODEC_H_
+
+#include <stdint.h>
+
+#include "tlmProtocol.h"
+
+//  Number of axes in a sample: acc, gyro, mag
+#define RAWZ_AXES           9
+//  Max. length of an encoded difference of one sample (3 bytes per axis)
+#define RAWZ_MAX_DELTA      (3 * RAWZ_AXES)
+//  Max. number of samples between keyframes
+#define RAWZ_KEY_PERIOD     100
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * State of encoder, block being filled is kept in buf
+ */
+typedef struct
+{
+    uint8_t  buf[TLM_MAX_PAYLOAD];
+    uint8_t  len;       //  Length of block, 0 when next sample starts a new one
+    int16_t  prev[RAWZ_AXES];
+    uint16_t sinceKey;  //  Samples since the last keyframe
+} RawzEncoder;
+
+void    rawzInit(RawzEncoder *enc);
+uint8_t rawzPush(RawzEncoder *enc, uint32_t time, const int16_t *sample);
+uint8_t rawzFlush(RawzEncoder *enc);
+
+uint8_t rawzDeltaEncode(const int16_t *prev, const int16_t *sample,
+                        uint8_t *out);
+int16_t rawzDeltaDecode(const uint8_t *in, uint16_t len, int16_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAWCODEC_H_ */
@@ -0,0 +1,363 @@
+/**
+ * telemetry.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include <stdarg.h>
+
+#include "telemetry.h"
+#include "uartHW.h"
+#include "HAL/hal.h"
+
+//  Fields are stored little-endian, independent of the layout of C structs
+#define PUT16(p, v) do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } \
+                    while (0)
+#define PUT32(p, v) do { PUT16((p), (v)); PUT16((p) + 2, (v) >> 16); } while (0)
+
+
+///-----------------------------------------------------------------------------
+///         Functions for returning static instance                     [PUBLIC]
+///-----------------------------------------------------------------------------
+
+/**
+ * Return reference to a singleton
+ * @return reference to an internal static instance
+ */
+Telemetry& Telemetry::GetI()
+{
+    static Telemetry singletonInstance;
+    return singletonInstance;
+}
+
+/**
+ * Return pointer to a singleton
+ * @return pointer to a internal static instance
+ */
+Telemetry* Telemetry::GetP()
+{
+    return &(Telemetry::GetI());
+}
+
+///-----------------------------------------------------------------------------
+///         Public functions used for sending records                   [PUBLIC]
+///-----------------------------------------------------------------------------
+
+/**
+ * Send raw sensor sample, timestamped with current time
+ * @param acc Raw accelerometer reading [x,y,z]
+ * @param gyro Raw gyroscope reading [x,y,z]
+ * @param mag Raw magnetometer reading [x,y,z]
+ */
+void Telemetry::SendRaw(const int16_t *acc, const int16_t *gyro,
+                        const int16_t *mag)
+{
+    uint8_t p[TLM_LEN_RAW];
+    uint32_t t = HAL_TS_GetTimeUS();
+
+    PUT32(p, t);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        PUT16(p + 4 + 2*i, (uint16_t)acc[i]);
+        PUT16(p + 10 + 2*i, (uint16_t)gyro[i]);
+        PUT16(p + 16 + 2*i, (uint16_t)mag[i]);
+    }
+
+    SendRecord(TLM_REC_RAW, p, TLM_LEN_RAW);
+}
+
+/**
+ * Add raw sensor sample to compressed stream, timestamped with current time
+ * Samples are sent in blocks (TLM_REC_RAWZ), about 9 bytes per sample, once
+ * a block fills up; see rawCodec.h. Meant for streaming every sample.
+ * @param acc Raw accelerometer reading [x,y,z]
+ * @param gyro Raw gyroscope reading [x,y,z]
+ * @param mag Raw magnetometer reading [x,y,z]
+ */
+void Telemetry::PushRaw(const int16_t *acc, const int16_t *gyro,
+                        const int16_t *mag)
+{
+    int16_t s[RAWZ_AXES];
+    uint8_t len;
+
+    memcpy((void*)s, (void*)acc, 3 * sizeof(int16_t));
+    memcpy((void*)(s + 3), (void*)gyro, 3 * sizeof(int16_t));
+    memcpy((void*)(s + 6), (void*)mag, 3 * sizeof(int16_t));
+
+    len = rawzPush(&_rawz, HAL_TS_GetTimeUS(), s);
+    if (len > 0)
+        SendRecord(TLM_REC_RAWZ, _rawz.buf, len);
+}
+
+/**
+ * Send samples added with PushRaw() which haven't been sent yet, e.g. when
+ * the stream stops
+ */
+void Telemetry::FlushRaw()
+{
+    uint8_t len = rawzFlush(&_rawz);
+
+    if (len > 0)
+        SendRecord(TLM_REC_RAWZ, _rawz.buf, len);
+}
+
+/**
+ * Send attitude quaternion, timestamped with current time
+ * Components are sent as fixed-point numbers, resolution 6e-5.
+ * @param q Unit quaternion [w,x,y,z]
+ */
+void Telemetry::SendQuat(const float *q)
+{
+    uint8_t p[TLM_LEN_QUAT];
+    uint32_t t = HAL_TS_GetTimeUS();
+    float v;
+
+    PUT32(p, t);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        //  Round to nearest, |q[i]| <= 1 always fits
+        v = q[i] * TLM_QUAT_SCALE;
+        v += (v < 0.0f) ? -0.5f : 0.5f;
+        PUT16(p + 4 + 2*i, (uint16_t)(int16_t)v);
+    }
+
+    SendRecord(TLM_REC_QUAT, p, TLM_LEN_QUAT);
+}
+
+/**
+ * Send attitude quaternion packed into 32 bits, timestamped with current time
+ * Record is 14 bytes on the wire instead of 18 for SendQuat(), with error of
+ * rotation below 0.26 deg; see quatCodec.h.
+ * @param q Quaternion [w,x,y,z], normalized before packing
+ */
+void Telemetry::SendQuatPacked(const float *q)
+{
+    uint8_t p[TLM_LEN_QUATP];
+    uint32_t t = HAL_TS_GetTimeUS();
+
+    PUT32(p, t);
+    PUT32(p + 4, quatPack(q));
+
+    SendRecord(TLM_REC_QUATP, p, TLM_LEN_QUATP);
+}
+
+/**
+ * Send status record, timestamped with current time
+ * @param samples Number of sensor samples read so far
+ * @param errors Number of errors so far (e.g. failed reads)
+ * @param flags Bitwise OR of TLM_STATUS_* flags
+ */
+void Telemetry::SendStatus(uint32_t samples, uint16_t errors, uint8_t flags)
+{
+    uint8_t p[TLM_LEN_STATUS];
+    uint32_t t = HAL_TS_GetTimeUS();
+
+    PUT32(p, t);
+    PUT32(p + 4, samples);
+    PUT16(p + 8, errors);
+    p[10] = flags;
+
+    SendRecord(TLM_REC_STATUS, p, TLM_LEN_STATUS);
+}
+
+/**
+ * Send acknowledgment of a command received from host
+ * @param cmd Type of the command (CMD_*)
+ * @param seq Sequence number of the command frame
+ * @param result Result of the command (CMD_RES_*)
+ */
+void Telemetry::SendAck(uint8_t cmd, uint8_t seq, uint8_t result)
+{
+    uint8_t p[TLM_LEN_ACK];
+
+    p[0] = cmd;
+    p[1] = seq;
+    p[2] = result;
+
+    SendRecord(TLM_REC_ACK, p, TLM_LEN_ACK);
+}
+
+/**
+ * Send log message as ID of its format string and binary arguments
+ * Format string is parsed only on the first call from the site, after that
+ * arguments are just copied. Arguments that don't fit into a record are
+ * dropped, strings are cut to fit. Supports conversions of uvsnprintf().
+ * @param site Call site of the message, static to it
+ * @param fmt Format string (same format as Send() of SerialPort)
+ */
+void Telemetry::SendLog(LogSite *site, const char *fmt, ...)
+{
+    uint8_t p[TLM_LOG_MAX_LEN];
+    uint8_t len = TLM_LEN_LOG, i, n;
+    uint32_t v, t = HAL_TS_GetTimeUS();
+    const char *s;
+    va_list vaArgP;
+
+    if (!site->ready)
+        _LogParse(site, fmt);
+
+    PUT32(p, t);
+    PUT16(p + 4, site->id);
+
+    va_start(vaArgP, fmt);
+    for (i = 0; i < site->args; i++)
+    {
+        if (site->strMask & (1 << i))
+        {
+            s = va_arg(vaArgP, const char*);
+            if ((len + 1) > TLM_LOG_MAX_LEN)
+                break;
+            n = (uint8_t)strlen(s);
+            if (n > (TLM_LOG_MAX_LEN - len - 1))
+                n = TLM_LOG_MAX_LEN - len - 1;
+            p[len++] = n;
+            memcpy((void*)(p + len), (void*)s, n);
+            len += n;
+        }
+        else
+        {
+            v = va_arg(vaArgP, uint32_t);
+            if ((len + 4) > TLM_LOG_MAX_LEN)
+                break;
+            PUT32(p + len, v);
+            len += 4;
+        }
+    }
+    va_end(vaArgP);
+
+    SendRecord(TLM_REC_LOG, p, len);
+}
+
+/**
+ * Frame and send a record of any type
+ * Not reentrant, records have to be sent from a single context.
+ * @param type Record type (TLM_REC_*)
+ * @param payload Packed payload of the record
+ * @param len Length of payload, max. TLM_MAX_PAYLOAD
+ */
+void Telemetry::SendRecord(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+    //  Buffers are static to keep them off the stack
+    static uint8_t frame[TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN];
+    static uint8_t out[TLM_MAX_FRAME];
+    uint16_t crc, n;
+
+    if (len > TLM_MAX_PAYLOAD)
+        return;
+
+    frame[0] = type;
+    frame[1] = _seq++;
+    memcpy((void*)(frame + TLM_HEADER_LEN), (void*)payload, len);
+    len += TLM_HEADER_LEN;
+    crc = crc16(0xFFFF, frame, len);
+    PUT16(frame + len, crc);
+    len += TLM_CRC_LEN;
+
+    n = cobsEncode(frame, len, out);
+    out[n++] = 0;
+    SerialPort::GetI().Write(out, n);
+}
+
+///-----------------------------------------------------------------------------
+///         Public functions used for subscriptions                     [PUBLIC]
+///-----------------------------------------------------------------------------
+
+/**
+ * Set rate at which a record type is sent
+ * Application calls Due() whenever it could send the record (e.g. on every
+ * new sample), record is sent on every divider-th of these calls. All types
+ * are sent on every call until changed.
+ * @param type Record type (TLM_REC_*)
+ * @param divider Send record on every divider-th opportunity, 0 to stop it
+ * @return One of STATUS_* codes
+ */
+int8_t Telemetry::Subscribe(uint8_t type, uint16_t divider)
+{
+    if ((type == 0) || (type >= TLM_REC_COUNT))
+        return STATUS_ARG_ERR;
+
+    _div[type] = divider;
+    _cnt[type] = 0;
+
+    return STATUS_OK;
+}
+
+/**
+ * Check whether record should be sent at this opportunity
+ * @param type Record type (TLM_REC_*)
+ * @return true if record is due according to its subscription
+ */
+bool Telemetry::Due(uint8_t type)
+{
+    if ((type >= TLM_REC_COUNT) || (_div[type] == 0))
+        return false;
+
+    if (++_cnt[type] < _div[type])
+        return false;
+
+    _cnt[type] = 0;
+    return true;
+}
+
+///-----------------------------------------------------------------------------
+///                      Class constructor & destructor              [PROTECTED]
+///-----------------------------------------------------------------------------
+
+Telemetry::Telemetry() : _seq(0)
+{
+    for (uint8_t i = 0; i < TLM_REC_COUNT; i++)
+    {
+        _div[i] = 1;
+        _cnt[i] = 0;
+    }
+    rawzInit(&_rawz);
+}
+Telemetry::~Telemetry() {}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Fill in call site of a log message from its format string: compute ID and
+ * find number and types of arguments
+ * @param site Call site to fill in
+ * @param fmt Format string
+ */
+void Telemetry::_LogParse(LogSite *site, const char *fmt)
+{
+    site->id = crc16(0xFFFF, (const uint8_t*)fmt, (uint16_t)strlen(fmt));
+    site->args = 0;
+    site->strMask = 0;
+
+    while (((fmt = strchr(fmt, '%')) != 0)
+           && (site->args < TLM_LOG_MAX_ARGS))
+    {
+        //  Skip fill and width, or precision of a string
+        for (fmt++; ((*fmt >= '0') && (*fmt <= '9')) || (*fmt == '.'); fmt++);
+
+        switch (*fmt)
+        {
+        case 's':
+            site->strMask |= 1 << site->args;
+            //  no break
+        case 'c':
+        case 'd':
+        case 'i':
+        case 'p':
+        case 'u':
+        case 'x':
+        case 'X':
+            site->args++;
+            break;
+        case 0:
+            fmt--;
+            break;
+        default:    //  "%%" and unknown conversions take no argument
+            break;
+        }
+        fmt++;
+    }
+
+    site->ready = true;
+}
@@ -0,0 +1,94 @@
+/**
+ * telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Binary telemetry over the debug serial port. Records (raw sensor samples,
+ *  attitude, status) are packed, protected by CRC, numbered and framed with
+ *  COBS, see tlmProtocol.h for the format. Compared to printing text, records
+ *  are several times shorter, cost no formatting on the MCU and keep full
+ *  precision and sign of every value. Host-side decoder is in tools/tlmDecoder.
+ *  Rate of each record type is set by subscription, which the host can change
+ *  at runtime (CMD_SUBSCRIBE).
+ *  Log messages can be sent as records too (SendLog), carrying only ID of the
+ *  format string and binary arguments; host expands them with a table of
+ *  format strings generated from the sources.
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +Subscriptions to record types, acknowledgment of commands
+ *  +Tokenized log messages
+ *  +Compressed stream of raw samples
+ *  +Attitude packed into 32 bits
+ */
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+#include "libs/myLib.h"
+#include "tlmProtocol.h"
+#include "rawCodec.h"
+#include "quatCodec.h"
+
+//  Max. number of arguments of a tokenized log message, and max. length of
+//  its record (kept short, record is composed on the stack)
+#define TLM_LOG_MAX_ARGS    8
+#define TLM_LOG_MAX_LEN     32
+
+/**
+ * Call site of a tokenized log message, holds what's known from its format
+ * string once it's first used. Static in every call site, see DEBUG_WRITE
+ */
+struct LogSite
+{
+    bool     ready;     //  Fields below are filled in
+    uint16_t id;        //  ID of format string (CRC-16)
+    uint8_t  args;      //  Number of arguments
+    uint8_t  strMask;   //  Bit i set if argument i is a string
+};
+#define LOG_SITE_INIT   { false, 0, 0, 0 }
+
+/**
+ * Sender of binary telemetry records
+ */
+class Telemetry
+{
+    public:
+        static Telemetry& GetI();
+        static Telemetry* GetP();
+
+        void    SendRaw(const int16_t *acc, const int16_t *gyro,
+                        const int16_t *mag);
+        void    PushRaw(const int16_t *acc, const int16_t *gyro,
+                        const int16_t *mag);
+        void    FlushRaw();
+        void    SendQuat(const float *q);
+        void    SendQuatPacked(const float *q);
+        void    SendStatus(uint32_t samples, uint16_t errors, uint8_t flags);
+        void    SendAck(uint8_t cmd, uint8_t seq, uint8_t result);
+        void    SendLog(LogSite *site, const char *fmt, ...);
+        void    SendRecord(uint8_t type, const uint8_t *payload, uint8_t len);
+
+        int8_t  Subscribe(uint8_t type, uint16_t divider);
+        bool    Due(uint8_t type);
+
+    protected:
+        Telemetry();
+        ~Telemetry();
+        Telemetry(Telemetry &arg) {}            //  No definition - forbid this
+        void operator=(Telemetry const &arg) {} //  No definition - forbid this
+
+        void    _LogParse(LogSite *site, const char *fmt);
+
+        //  Sequence number of next frame
+        uint8_t _seq;
+        //  Subscriptions: record is due on every _div-th call to Due(), 0 if
+        //  not subscribed, _cnt counts calls since it was last due
+        uint16_t _div[TLM_REC_COUNT];
+        uint16_t _cnt[TLM_REC_COUNT];
+        //  Encoder of compressed raw samples
+        RawzEncoder _rawz;
+};
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,130 @@
+/**
+ * tlmProtocol.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Binary telemetry protocol, shared by the MCU (telemetry.h) and host-side
+ *  decoder (tools/tlmDecoder). No dependencies, so it compiles on both.
+ *  Commands from the host (command.h) use the same framing, every command is
+ *  answered with an acknowledgment record.
+ *
+ *  Every record is sent as one frame:
+ *      COBS( type | seq | payload | crc16 ) 0x00
+ *  type    - record type, one of TLM_REC_*
+ *  seq     - sequence number, incremented with every frame sent, so that the
+ *            receiver can count lost frames
+ *  payload - record, fields are little-endian and packed (no padding)
+ *  crc16   - CRC-16/CCITT (crc16() in libs/myLib, initial value 0xFFFF) of
+ *            type, seq and payload, little-endian
+ *  COBS encoding (cobsEncode() in libs/myLib) removes all zero bytes from the
+ *  frame, so the zero byte after it marks its end. Receiver resynchronizes on
+ *  the next zero after any corrupted or lost byte.
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +Commands from host and acknowledgment record
+ *  +Tokenized log messages
+ *  +Delta-compressed blocks of raw samples, longer payloads
+ *  +Attitude packed into 32 bits
+ *  +Calibration command
+ */
+#ifndef TLMPROTOCOL_H_
+#define TLMPROTOCOL_H_
+
+//  Bytes in a frame around the payload: type, seq and CRC
+#define TLM_HEADER_LEN      2
+#define TLM_CRC_LEN         2
+//  Max. length of payload of any record (frame stays within one COBS block)
+#define TLM_MAX_PAYLOAD     120
+//  Max. length of a frame on the wire, with COBS overhead and delimiter
+#define TLM_MAX_FRAME       (TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN + 2)
+
+/*
+ * Record types and layout of their payloads
+ * time is timestamp of the sample in us (HAL_TS_GetTimeUS()), wraps around
+ */
+//  Raw sensor sample: u32 time, i16 acc[3], i16 gyro[3], i16 mag[3]
+//  Values as read from sensor registers, in sensor (not body) frame
+#define TLM_REC_RAW         0x01
+#define TLM_LEN_RAW         22
+//  Attitude: u32 time, i16 quat[4] [w,x,y,z], scaled by TLM_QUAT_SCALE
+#define TLM_REC_QUAT        0x02
+#define TLM_LEN_QUAT        12
+#define TLM_QUAT_SCALE      16384.0f
+//  Status: u32 time, u32 samples read so far, u16 error count, u8 flags
+#define TLM_REC_STATUS      0x03
+#define TLM_LEN_STATUS      11
+
+//  Flags in status record
+#define TLM_STATUS_DMP      0x01    //  MPU runs DMP firmware
+#define TLM_STATUS_MAG      0x02    //  Magnetometer is in use
+#define TLM_STATUS_CAL      0x04    //  Calibration in progress
+
+//  Acknowledgment of a command: u8 command type, u8 command seq, u8 result
+#define TLM_REC_ACK         0x04
+#define TLM_LEN_ACK         3
+//  Log message: u32 time, u16 ID of format string, arguments; followed by
+//  as many arguments as fit. ID is CRC-16 (as in frame) of format string
+//  without terminating zero, host looks it up in a table generated from the
+//  sources. Each integer argument (%c, %d, %i, %p, %u, %x, %X) is an u32, each
+//  string (%s) is u8 length followed by its characters (no terminating zero)
+#define TLM_REC_LOG         0x05
+#define TLM_LEN_LOG         6
+//  Block of raw sensor samples, compressed (see serialPort/rawCodec.h):
+//  u32 time of first sample, u32 time of last sample, u8 number of samples,
+//  u8 flags; followed by samples, axes in the same order as in TLM_REC_RAW.
+//  With TLM_RAWZ_KEY the first sample is a keyframe: i16 values as they are.
+//  Every other sample is a difference from the previous one (in this or the
+//  previous block), i16 wrapping around, per axis, zigzag-mapped to unsigned
+//  (0,-1,1,-2.. -> 0,1,2,3..) and written as varint: 7 bits per byte, least
+//  significant first, bit 7 set if more bytes follow
+#define TLM_REC_RAWZ        0x06
+#define TLM_LEN_RAWZ        10
+#define TLM_RAWZ_KEY        0x01
+//  Attitude, packed (see serialPort/quatCodec.h): u32 time, u32 quaternion.
+//  Quaternion is flipped if needed so that its largest component is
+//  positive; bits 31-30 are index of that component (0-3 for w,x,y,z), bits
+//  29-20, 19-10 and 9-0 the other three in order of their index, each as
+//  round(c * QUATP_SCALE) + QUATP_MAX_STEP. Largest component is
+//  sqrt(1 - sum of squares of the other three)
+#define TLM_REC_QUATP       0x07
+#define TLM_LEN_QUATP       8
+//  Number of record types, valid types are 1 to TLM_REC_COUNT-1
+#define TLM_REC_COUNT       8
+
+/*
+ * Commands sent by the host, types have the highest bit set. seq is chosen by
+ * the host and returned in the acknowledgment. Frames with bad CRC are
+ * dropped without acknowledgment. Host should send a zero byte before each
+ * command, so that it isn't taken as part of noise received before it.
+ */
+//  Output data rate: u16 rate in Hz (sample rate in NODMP, DMP rate in DMP
+//  mode)
+#define CMD_SET_ODR         0x81
+#define CMD_LEN_ODR         2
+//  Bandwidth of sensor's low-pass filter: u8 DLPF_CFG, 1 (~190Hz) to 6 (5Hz)
+#define CMD_SET_DLPF        0x82
+#define CMD_LEN_DLPF        1
+//  AHRS gains: f32 kp, f32 ki (IEEE-754 single), NODMP mode only
+#define CMD_SET_AHRS        0x83
+#define CMD_LEN_AHRS        8
+//  Subscription to a record: u8 record type, u16 divider, record is sent on
+//  every divider-th opportunity, 0 stops it
+#define CMD_SUBSCRIBE       0x84
+#define CMD_LEN_SUBSCRIBE   3
+//  Start accel/gyro calibration, sensor has to be still and level: u16 number
+//  of samples to average. Acknowledged when it starts, result is stored in
+//  EEPROM once done. NODMP mode only
+#define CMD_CALIBRATE       0x85
+#define CMD_LEN_CALIBRATE   2
+
+//  Results in acknowledgment (first three match MPU_* codes)
+#define CMD_RES_OK          0       //  Command carried out
+#define CMD_RES_BUSY        1       //  Device busy, try again later
+#define CMD_RES_ERROR       2       //  Bad arguments or command failed
+#define CMD_RES_UNKNOWN     3       //  Unknown command type
+
+#endif /* TLMPROTOCOL_H_ */
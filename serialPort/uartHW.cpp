@@ -9,6 +9,8 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_ints.h"
 #include "inc/hw_gpio.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
 #include "driverlib/gpio.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
@@ -16,9 +18,15 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/uart.h"
 #include "utils/uartstdio.h"
+#include "utils/ustdlib.h"
 
 #include "uartHW.h"
 
+//  Mask for wrapping indices of transmit buffer
+#define TX_MASK     (UART_TX_RING_LEN - 1)
+//  Mask for wrapping indices of receive buffer
+#define RX_MASK     (UART_RX_RING_LEN - 1)
+
 ///-----------------------------------------------------------------------------
 ///         Functions for returning static instance                     [PUBLIC]
 ///-----------------------------------------------------------------------------
@@ -42,21 +50,203 @@ SerialPort* SerialPort::GetP()
     return &(SerialPort::GetI());
 }
 
-SerialPort::SerialPort() {}
+SerialPort::SerialPort() : _txHead(0), _txTail(0), _txPolicy(UART_TX_POLICY),
+                           _txDropped(0), _rxHead(0), _rxTail(0),
+                           _rxDropped(0) {}
 SerialPort::~SerialPort() {}
 
+/**
+ * Send formatted string (same format as UARTprintf()), '\n' is sent as "\r\n"
+ * Message is only formatted here and put into transmit buffer with a single
+ * Write(), so it's queued or dropped as a whole. Not reentrant, messages
+ * longer than UART_FMT_LEN-1 characters (with "\r\n") are cut.
+ * @param arg Format string, followed by arguments
+ */
 void SerialPort::Send(const char* arg, ...)
 {
+    //  Static, doesn't fit on the stack
+    static char buf[UART_FMT_LEN];
     va_list vaArgP;
+    int len, i, j, nl;
 
 
     //	Start the varargs processing.
     va_start(vaArgP, arg);
 
-    UARTvprintf(arg, vaArgP);
+    len = uvsnprintf(buf, sizeof(buf), arg, vaArgP);
+    if (len > (int)(sizeof(buf) - 1))
+        len = sizeof(buf) - 1;
 
     //	We're finished with the varargs now.
     va_end(vaArgP);
+
+    //  Translate newlines as UARTprintf() did, terminals expect "\r\n".
+    //  Done in place from the end, whatever goes past the buffer is cut
+    for (i = 0, nl = 0; i < len; i++)
+        if (buf[i] == '\n')
+            nl++;
+    for (i = len - 1, j = len + nl - 1, len += nl; nl > 0; i--)
+    {
+        if (j < (int)(sizeof(buf) - 1))
+            buf[j] = buf[i];
+        j--;
+        if (buf[i] == '\n')
+        {
+            if (j < (int)(sizeof(buf) - 1))
+                buf[j] = '\r';
+            j--;
+            nl--;
+        }
+    }
+    if (len > (int)(sizeof(buf) - 1))
+        len = sizeof(buf) - 1;
+
+    Write((uint8_t*)buf, len);
+}
+
+/**
+ * Send block of binary data as it is (no newline translation)
+ * Data is copied into transmit buffer and the call returns, buffer is drained
+ * into UART by TX interrupt. If data doesn't fit, policy set by SetTxPolicy()
+ * decides what's dropped, dropped bytes are counted (TxDropped()). Safe to
+ * call from interrupts.
+ * @param data Data to send
+ * @param len Length of data
+ */
+void SerialPort::Write(const uint8_t *data, uint16_t len)
+{
+    uint16_t space, n;
+    bool masked;
+    //  Blocking inside an interrupt would never end, ISR of UART can't run
+    bool canBlock = (_txPolicy == UART_TX_BLOCK)
+                    && !(HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M);
+
+    while (len > 0)
+    {
+        //  Buffer is shared with TX interrupt and other writers
+        masked = IntMasterDisable();
+
+        space = (_txTail - _txHead - 1) & TX_MASK;
+        if ((len > space) && !canBlock)
+        {
+            if (_txPolicy == UART_TX_DROP_OLDEST)
+            {
+                //  Only the newest data fits if there's more than buffer
+                //  can hold at all
+                if (len > TX_MASK)
+                {
+                    _txDropped += len - TX_MASK;
+                    data += len - TX_MASK;
+                    len = TX_MASK;
+                }
+                _txDropped += len - space;
+                _txTail = (_txTail + len - space) & TX_MASK;
+                space = len;
+            }
+            else
+            {
+                _txDropped += len;
+                len = 0;
+            }
+        }
+
+        //  Copy what fits, in up to two parts if it wraps around
+        n = (len < space) ? len : space;
+        len -= n;
+        while (n > 0)
+        {
+            space = UART_TX_RING_LEN - _txHead;
+            if (space > n)
+                space = n;
+            memcpy((void*)&_txRing[_txHead], (void*)data, space);
+            _txHead = (_txHead + space) & TX_MASK;
+            data += space;
+            n -= space;
+        }
+        //  Start transmission if UART has run out of data
+        _TxFill();
+
+        if (!masked)
+            IntMasterEnable();
+    }
+}
+
+/**
+ * Wait until all data in transmit buffer has been sent
+ * Don't call from interrupts.
+ */
+void SerialPort::Flush()
+{
+    while ((_txHead != _txTail) || UARTBusy(UART0_BASE));
+}
+
+/**
+ * Select what happens with data which doesn't fit into transmit buffer
+ * @param policy One of UART_TX_DROP_OLDEST, UART_TX_DROP_NEWEST or
+ *        UART_TX_BLOCK
+ */
+void SerialPort::SetTxPolicy(uint8_t policy)
+{
+    if (policy <= UART_TX_BLOCK)
+        _txPolicy = policy;
+}
+
+/**
+ * Get number of bytes dropped because transmit buffer was full
+ * @param reset Start counting from zero after this call
+ * @return Number of bytes dropped since start or last reset
+ */
+uint32_t SerialPort::TxDropped(bool reset)
+{
+    uint32_t dropped = _txDropped;
+
+    if (reset)
+        _txDropped -= dropped;
+
+    return dropped;
+}
+
+/**
+ * Get received data, without copying it out of receive buffer
+ * Returns the oldest received bytes which are contiguous in the buffer; if
+ * data wraps around the end of buffer, the rest is returned by the next call
+ * (after RxConsume()). Data stays valid until it's consumed. Don't call from
+ * interrupts.
+ * @param data Set to point to the first received byte
+ * @return Number of bytes available at data, 0 if nothing was received
+ */
+uint16_t SerialPort::RxPeek(const uint8_t **data)
+{
+    uint16_t head = _rxHead;
+
+    *data = &_rxRing[_rxTail];
+    if (head >= _rxTail)
+        return head - _rxTail;
+    return UART_RX_RING_LEN - _rxTail;
+}
+
+/**
+ * Release received data returned by RxPeek(), making room for new data
+ * @param len Number of bytes to release, at most as many as RxPeek() returned
+ */
+void SerialPort::RxConsume(uint16_t len)
+{
+    _rxTail = (_rxTail + len) & RX_MASK;
+}
+
+/**
+ * Get number of bytes dropped because receive buffer was full
+ * @param reset Start counting from zero after this call
+ * @return Number of bytes dropped since start or last reset
+ */
+uint32_t SerialPort::RxDropped(bool reset)
+{
+    uint32_t dropped = _rxDropped;
+
+    if (reset)
+        _rxDropped -= dropped;
+
+    return dropped;
 }
 
 /**
@@ -95,11 +285,13 @@ int8_t SerialPort::InitHW()
     UARTStdioConfig(0, COMM_BAUD, refClockHz);
 
     /*
-     * Enable Interrupt on received data
+     * Enable Interrupt on received data, and on TX FIFO running low to
+     * refill it from transmit buffer
      */
     UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
-   	UARTIntEnable(UART0_BASE, UART_INT_RX | UART_INT_RT);
-   	UARTIntRegister(UART0_BASE,UART0RxIntHandler);
+    UARTTxIntModeSet(UART0_BASE, UART_TXINT_MODE_FIFO);
+   	UARTIntEnable(UART0_BASE, UART_INT_RX | UART_INT_RT | UART_INT_TX);
+   	UARTIntRegister(UART0_BASE,UART0IntHandler);
    	IntEnable(INT_UART0);
 
     IntMasterEnable();
@@ -107,33 +299,54 @@ int8_t SerialPort::InitHW()
 	return STATUS_OK;
 }
 
-void SerialPort::AddHook(void((*funPoint)(uint8_t*, uint16_t*)))
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Move data from transmit buffer into UART FIFO, as much as fits
+ * Called from TX interrupt, or with interrupts disabled.
+ */
+void SerialPort::_TxFill()
 {
-	custHook = funPoint;
+    while ((_txTail != _txHead) && UARTSpaceAvail(UART0_BASE))
+    {
+        UARTCharPutNonBlocking(UART0_BASE, _txRing[_txTail]);
+        _txTail = (_txTail + 1) & TX_MASK;
+    }
 }
 
 /**
- * Interrupt service routine for handling incoming data on UART (Tx)
- * @note IMPORTANT Custom hook HAS TO clear the buffer and bufLen variable
+ * Interrupt service routine of UART0
+ * Refills TX FIFO from transmit buffer, and moves received data from RX FIFO
+ * into receive buffer. Received data is processed outside of interrupt.
  */
-void UART0RxIntHandler(void)
+void UART0IntHandler(void)
 {
-	static uint8_t txBuffer[TX_BUF_LEN];
-	static uint16_t txBufLen = 0;
+	SerialPort &port = SerialPort::GetI();
+	uint32_t status = UARTIntStatus(UART0_BASE, true);
+	uint16_t next;
+	uint8_t c;
+
+	//Clear interrupt flags
+	UARTIntClear(UART0_BASE, status);
 
-	//Clear interrupt flag
-	UARTIntClear(UART0_BASE, UART_INT_RX);
+	if (status & UART_INT_TX)
+	    port._TxFill();
 
-	//Take all chars from Tx FIFO and put them in buffer
-	while(UARTCharsAvail(UART0_BASE))
+	//Take all chars from Rx FIFO and put them in receive buffer
+	while (UARTCharsAvail(UART0_BASE))
 	{
-		txBuffer[ txBufLen++ ] = UARTCharGet(UART0_BASE);
-		//	Add echo fo debugging purpose
-		UARTCharPut(UART0_BASE, txBuffer[ txBufLen-1 ]);
+	    c = (uint8_t)UARTCharGetNonBlocking(UART0_BASE);
+	    next = (port._rxHead + 1) & RX_MASK;
+	    if (next == port._rxTail)
+	    {
+	        port._rxDropped++;
+	        continue;
+	    }
+	    port._rxRing[port._rxHead] = c;
+	    port._rxHead = next;
 	}
-
-	if (SerialPort::GetP()->custHook != 0)
-	    SerialPort::GetP()->custHook(txBuffer, &txBufLen);
 }
 
 
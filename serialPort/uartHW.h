@@ -5,6 +5,11 @@
  *      Author: Vedran Mikov
  *
  *  Debug bridge between PC<--(USB)-->TM4C
+ *  Data to send is put into a ring buffer and the call returns right away,
+ *  buffer is drained into UART by TX interrupt. What happens with data which
+ *  doesn't fit into the buffer is selected by SetTxPolicy().
+ *  Received data is put into another ring buffer by RX interrupt, and read
+ *  from it in place (RxPeek/RxConsume) outside of the interrupt.
  *
  */
 #ifndef UARTHW_H_
@@ -13,14 +18,50 @@
 
 /*		Communication settings	 	*/
 #define COMM_BAUD	115200
-#define TX_BUF_LEN	512
+//  Length of transmit ring buffer, has to be a power of 2
+#define UART_TX_RING_LEN    1024
+//  Max. length of a single formatted message sent with Send()
+#define UART_FMT_LEN        128
+//  Length of receive ring buffer, has to be a power of 2
+#define UART_RX_RING_LEN    256
+//  Send DEBUG_WRITE messages as tokens (ID of format string and binary
+//  arguments, TLM_REC_LOG record in telemetry) instead of formatted text.
+//  Expanded on host by tlmDump with a table made by tlmLogTable from sources
+//#define UART_LOG_TOKENIZED
+
+//  Policies when data doesn't fit into transmit buffer
+#define UART_TX_DROP_OLDEST 0   //  Discard oldest data in buffer to make room
+#define UART_TX_DROP_NEWEST 1   //  Discard data being written, as a whole
+#define UART_TX_BLOCK       2   //  Wait until there's room (drops newest data
+                                //  when called from an interrupt)
+//  Policy in use until changed with SetTxPolicy()
+#define UART_TX_POLICY      UART_TX_DROP_NEWEST
 
 /*      Macro to short the expression needed to print to debug port     */
+#ifdef UART_LOG_TOKENIZED
+#include "telemetry.h"
+//  Format string is only parsed on the first call, kept by the call site.
+//  Records are sent from the main loop only, so not usable in interrupts
+#define DEBUG_WRITE(...) do { static LogSite _logSite = LOG_SITE_INIT; \
+                              Telemetry::GetI().SendLog(&_logSite, __VA_ARGS__); \
+                         } while (0)
+#else
 #define DEBUG_WRITE(...) SerialPort::GetI().Send(__VA_ARGS__)
+#endif  /* UART_LOG_TOKENIZED */
 
 /*      Macro for printing float numbers    */
 #define _FTOI_(X) (int32_t)(trunc(X)),(int32_t)fabs(trunc((X-trunc(X))*100))
 
+/*
+ * Function for sending and receiving data - no need to call them
+ */
+
+extern "C"
+{
+    void UART0IntHandler(void);
+    extern uint32_t g_ui32SysClock;
+}
+
 
 /**
  * Interface to a UART-to-USB port, used for debugging
@@ -33,24 +74,36 @@ class SerialPort
 
 		int8_t	InitHW();
 		void	Send(const char* arg, ...);
-		void	AddHook(void((*custHook)(uint8_t*, uint16_t*)));
-
-		void	((*custHook)(uint8_t*, uint16_t*));  // Hook to user routine
+		void	Write(const uint8_t *data, uint16_t len);
+		void	Flush();
+		void	SetTxPolicy(uint8_t policy);
+		uint32_t TxDropped(bool reset);
+		uint16_t RxPeek(const uint8_t **data);
+		void	RxConsume(uint16_t len);
+		uint32_t RxDropped(bool reset);
 	protected:
 		SerialPort();
         ~SerialPort();
 
-};
+        void    _TxFill();
 
+        //  Transmit ring buffer, written at _txHead and drained from _txTail,
+        //  empty when they're equal
+        uint8_t  _txRing[UART_TX_RING_LEN];
+        volatile uint16_t _txHead;
+        volatile uint16_t _txTail;
+        //  Policy when buffer is full (UART_TX_*) and number of bytes dropped
+        uint8_t  _txPolicy;
+        volatile uint32_t _txDropped;
+        //  Receive ring buffer, written at _rxHead by RX interrupt only and
+        //  read from _rxTail outside of it only, so no locking is needed.
+        //  Bytes received while it's full are dropped and counted
+        uint8_t  _rxRing[UART_RX_RING_LEN];
+        volatile uint16_t _rxHead;
+        volatile uint16_t _rxTail;
+        volatile uint32_t _rxDropped;
 
-/*
- * Function for receiving and processing incomming data - no need to call them
- */
-
-extern "C"
-{
-    void UART0RxIntHandler(void);
-    extern uint32_t g_ui32SysClock;
-}
+        friend void UART0IntHandler(void);
+};
 
 #endif /* UARTHW_H_ */
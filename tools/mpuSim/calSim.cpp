@@ -0,0 +1,157 @@
+/**
+ * calSim.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Runs non-blocking accel/gyro calibration of mpu9250/api_mpu9250.c against
+ *  simulated MPU9250 (HAL/host/hal_mpu_host.h) with known biases, calling
+ *  calibrateMPU9250Step() from a loop of given period, as main loop would.
+ *  Checks that returned biases are the simulated ones, and that readings after
+ *  initialization are left with no more than rounding of offset registers.
+ *  Prints calls, simulated time, bus transactions and bytes of the
+ *  calibration, and the same for blocking calibrateMPU9250() (40 samples).
+ *  Loop periods close to or above ~40ms (time to fill 512B FIFO) show how
+ *  calibration copes with FIFO overflows; run is stopped if calibration
+ *  doesn't finish in 60s of simulated time.
+ *
+ *  Build (from root of the repository, with NODMP mode in hwconfig.h):
+ *      g++ -O2 -I. -D__BOARD_HOST__ -o calSim tools/mpuSim/calSim.cpp
+ *          -x c mpu9250/api_mpu9250.c mpu9250/fifoConvert.c libs/myLib.c
+ *          HAL/host/hal_common_host.c HAL/host/hal_mpu_host.c
+ *  Use:
+ *      calSim [samples [loop period in ms]]     (default 5000 samples, 5ms)
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "HAL/hal.h"
+#include "mpu9250/api_mpu9250.h"
+
+//  Sensitivity of accel and gyro at ranges used by calibration (2g, 250dps)
+#define ACCEL_LSB       16384
+#define GYRO_LSB        131
+//  Residual of readings after calibration: one step of offset registers
+//  (8 LSB of accel at 2g, 4 LSB of gyro at 250dps)
+#define ACCEL_RESIDUAL  8
+#define GYRO_RESIDUAL   4
+//  Simulated time after which calibration is given up, in us
+#define CAL_TIMEOUT_US  60000000
+
+static uint32_t errors = 0;
+
+
+static void Check(const char *what, double got, double want, double tol)
+{
+    if (fabs(got - want) <= tol)
+        return;
+    printf("    MISMATCH %s: %.6f, expected %.6f\n", what, got, want);
+    errors++;
+}
+
+/**
+ * Print and reset statistics of simulated bus
+ */
+static void Stats(const char *name, uint32_t calls, uint64_t start)
+{
+    printf("%-24s calls %5u  %8.1f ms  tx %5u  bytes %6u\n", name, calls,
+           (HAL_HOST_GetTimeUS() - start) / 1000.0, HAL_MPU_Sim.transactions,
+           HAL_MPU_Sim.bytes);
+    HAL_MPU_Sim.transactions = 0;
+    HAL_MPU_Sim.bytes = 0;
+}
+
+/**
+ * Check biases returned by calibration against simulated ones, gravity
+ * removed from z axis
+ */
+static void CheckBias(const float *gyroBias, const float *accelBias)
+{
+    uint8_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        Check("gyro bias", gyroBias[i],
+              (float)HAL_MPU_Sim.gyro[i] / (float)GYRO_LSB, 1e-6);
+        Check("accel bias", accelBias[i],
+              (float)(HAL_MPU_Sim.accel[i] - (i == 2 ? ACCEL_LSB : 0))
+              / (float)ACCEL_LSB, 1e-6);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    uint16_t samples = (argc > 1) ? atoi(argv[1]) : 5000;
+    uint32_t period = (argc > 2) ? atoi(argv[2]) * 1000 : 5000;
+    float gyroBias[3], accelBias[3];
+    int16_t a[3], g[3];
+    uint32_t calls = 0;
+    uint64_t start;
+    uint8_t i;
+    int8_t r;
+
+    HAL_MPU_Init();
+    HAL_MPU_PowerSwitch(true);
+    if (initMPU9250() != INIT_OK)
+    {
+        printf("MPU9250 not initialized\n");
+        return 2;
+    }
+    HAL_MPU_Sim.transactions = 0;
+    HAL_MPU_Sim.bytes = 0;
+
+    //  Non-blocking, called from a loop
+    start = HAL_HOST_GetTimeUS();
+    calibrateMPU9250Start(samples);
+    do
+    {
+        calls++;
+        HAL_DelayUS(period);
+        r = calibrateMPU9250Step(gyroBias, accelBias);
+    } while ((r == CAL_BUSY)
+             && ((HAL_HOST_GetTimeUS() - start) < CAL_TIMEOUT_US));
+    Stats("calibrateMPU9250Step()", calls, start);
+    if (r != CAL_DONE)
+    {
+        printf("calibration didn't finish\n");
+        return 2;
+    }
+    printf("gyro bias %.4f %.4f %.4f dps, accel bias %.5f %.5f %.5f g\n",
+           gyroBias[0], gyroBias[1], gyroBias[2],
+           accelBias[0], accelBias[1], accelBias[2]);
+    CheckBias(gyroBias, accelBias);
+
+    //  Offset registers now cancel the biases
+    initMPU9250();
+    HAL_DelayUS(2000);
+    readAccelData(a);
+    readGyroData(g);
+    printf("after calibration: accel %d %d %d, gyro %d %d %d\n",
+           a[0], a[1], a[2], g[0], g[1], g[2]);
+    for (i = 0; i < 3; i++)
+    {
+        Check("accel", a[i], (i == 2) ? ACCEL_LSB : 0, ACCEL_RESIDUAL);
+        Check("gyro", g[i], 0, GYRO_RESIDUAL);
+    }
+
+    //  Blocking wrapper, from reset values of offset registers
+    HAL_MPU_PowerSwitch(false);
+    HAL_MPU_PowerSwitch(true);
+    initMPU9250();
+    HAL_MPU_Sim.transactions = 0;
+    HAL_MPU_Sim.bytes = 0;
+    start = HAL_HOST_GetTimeUS();
+    calibrateMPU9250(gyroBias, accelBias);
+    Stats("calibrateMPU9250()", 1, start);
+    CheckBias(gyroBias, accelBias);
+
+    printf("mismatches: %u\n", errors);
+
+    return (errors > 0) ? 2 : 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * dmpBoot.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Times cold start of DMP mode (as in MPU9250::_InitDMP()) against simulated
+ *  MPU9250 (HAL/host/hal_mpu_host.h): waiting for the chip after power-on,
+ *  mpu_init() and upload of DMP firmware with its read-back check
+ *  (dmp_load_motion_driver_firmware()). Prints simulated time, bus
+ *  transactions and bytes of each part, for SPI at 1MHz and I2C at 400kHz.
+ *  Time includes delays in eMPL driver. Then checks that a stuck bit in DMP
+ *  memory makes the upload fail.
+ *
+ *  Build (from root of the repository):
+ *      g++ -O2 -I. -D__BOARD_HOST__ -o dmpBoot tools/mpuSim/dmpBoot.cpp
+ *          -x c mpu9250/eMPL/inv_mpu.c mpu9250/eMPL/inv_mpu_dmp_motion_driver.c
+ *          libs/myLib.c HAL/host/hal_common_host.c HAL/host/hal_mpu_host.c
+ *  Use:
+ *      dmpBoot [address of stuck bit in DMP memory]     (default 1500)
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "HAL/hal.h"
+#include "mpu9250/eMPL/inv_mpu.h"
+#include "mpu9250/eMPL/inv_mpu_dmp_motion_driver.h"
+
+//  Bus time per byte in us: 1MHz SPI, 400kHz I2C (9 clocks per byte and gaps
+//  between bytes)
+#define SPI_BYTE_US     8
+#define I2C_BYTE_US     27
+
+static uint32_t errors = 0;
+
+//  Start of the part being timed
+static uint64_t partStart;
+
+
+static void Begin()
+{
+    HAL_MPU_Sim.transactions = 0;
+    HAL_MPU_Sim.bytes = 0;
+    partStart = HAL_HOST_GetTimeUS();
+}
+
+/**
+ * Print statistics of part started with Begin(), and check its result
+ * @return Simulated time of part in ms
+ */
+static double End(const char *name, int r)
+{
+    double ms = (HAL_HOST_GetTimeUS() - partStart) / 1000.0;
+
+    printf("  %-20s %3d  %7.2f ms  tx %4u  bytes %5u\n", name, r, ms,
+           HAL_MPU_Sim.transactions, HAL_MPU_Sim.bytes);
+    return ms;
+}
+
+/**
+ * Power the sensor up and bring DMP mode up to loaded firmware
+ * @return Result of firmware upload
+ */
+static int Boot(const char *bus, uint32_t byteUs)
+{
+    double total;
+    int r;
+
+    printf("%s:\n", bus);
+    HAL_MPU_Sim.busByteUS = byteUs;
+    HAL_MPU_PowerSwitch(false);
+    HAL_MPU_PowerSwitch(true);
+
+    Begin();
+    r = mpu_wait_ready(100);
+    total = End("mpu_wait_ready()", r);
+    Begin();
+    r = mpu_init(0);
+    total += End("mpu_init()", r);
+    mpu_set_sensors(INV_XYZ_GYRO | INV_XYZ_ACCEL | INV_XYZ_COMPASS);
+    mpu_configure_fifo(INV_XYZ_ACCEL);
+    mpu_set_sample_rate(50);
+    Begin();
+    r = dmp_load_motion_driver_firmware();
+    total += End("firmware upload", r);
+    printf("  %-20s      %7.2f ms\n", "total", total);
+
+    return r;
+}
+
+
+int main(int argc, char **argv)
+{
+    int32_t badAddr = (argc > 1) ? atoi(argv[1]) : 1500;
+
+    HAL_MPU_Init();
+
+    if (Boot("SPI 1MHz", SPI_BYTE_US) != 0)
+        errors++;
+    if (Boot("I2C 400kHz", I2C_BYTE_US) != 0)
+        errors++;
+
+    //  Stuck bit in DMP memory has to be caught by read-back check
+    HAL_MPU_Sim.dmpBadAddr = badAddr;
+    printf("stuck bit at 0x%03X, ", badAddr);
+    if (Boot("SPI 1MHz", SPI_BYTE_US) == 0)
+        errors++;
+    HAL_MPU_Sim.dmpBadAddr = -1;
+
+    printf("mismatches: %u\n", errors);
+
+    return (errors > 0) ? 2 : 0;
+}
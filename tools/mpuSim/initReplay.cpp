@@ -0,0 +1,262 @@
+/**
+ * initReplay.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Replays initialization tables of mpu9250/api_mpu9250.c against simulated
+ *  MPU9250 and AK8963 (HAL/host/hal_mpu_host.h) and checks the result:
+ *  configuration registers after initialization, rate divider kept at full
+ *  rate while initialization runs (also when set to a low output rate with
+ *  setFilterMPU9250()) and applied at the end, runtime rate changes, and
+ *  errors when MPU9250 or AK8963 don't answer or no samples come. For every
+ *  run prints result, calls of initMPU9250Step() (called every 1ms), most bus
+ *  transactions taken by one call, all transactions and simulated time.
+ *
+ *  Build (from root of the repository, with NODMP mode in hwconfig.h):
+ *      g++ -O2 -I. -D__BOARD_HOST__ -o initReplay tools/mpuSim/initReplay.cpp
+ *          -x c mpu9250/api_mpu9250.c mpu9250/fifoConvert.c libs/myLib.c
+ *          HAL/host/hal_common_host.c HAL/host/hal_mpu_host.c
+ *  Use:
+ *      initReplay [-t]         -t prints every bus transaction
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "HAL/hal.h"
+#include "mpu9250/api_mpu9250.h"
+#include "mpu9250/registerMap.h"
+
+//  Period of calling initMPU9250Step(), in us
+#define STEP_PERIOD_US  1000
+//  Most bus transactions a single call of initMPU9250Step() may take: once
+//  chip answers and sample is already there, rest of _initMPU (5) and _initAK
+//  up to its first wait (4)
+#define STEP_MAX_TX     9
+//  Low output rate used in checks, 10Hz
+#define LOW_RATE_DIV    99
+
+static uint32_t errors = 0;
+
+//  Statistics of the last initialization
+static struct
+{
+    uint32_t calls;
+    uint32_t maxTx;
+    uint32_t tx;
+    uint32_t divMax;
+    double   ms;
+} run;
+
+
+static void Expect(const char *what, uint32_t got, uint32_t want)
+{
+    if (got == want)
+        return;
+    printf("    MISMATCH %s: 0x%02X, expected 0x%02X\n", what, got, want);
+    errors++;
+}
+
+static const char* InitName(int8_t r)
+{
+    switch (r)
+    {
+    case INIT_OK:           return "INIT_OK";
+    case INIT_NO_DEVICE:    return "INIT_NO_DEVICE";
+    case INIT_TIMEOUT:      return "INIT_TIMEOUT";
+    default:                return "INIT_BUSY";
+    }
+}
+
+static void Begin()
+{
+    HAL_MPU_Sim.transactions = 0;
+    memset(&run, 0, sizeof(run));
+    run.ms = HAL_HOST_GetTimeUS() / 1000.0;
+}
+
+static void End(const char *name, int8_t r, int8_t want)
+{
+    run.tx = HAL_MPU_Sim.transactions;
+    run.ms = HAL_HOST_GetTimeUS() / 1000.0 - run.ms;
+    printf("%-34s %-14s calls %3u  max tx/call %u  tx %3u  %7.2f ms\n", name,
+           InitName(r), run.calls, run.maxTx, run.tx, run.ms);
+    Expect("result", r, want);
+}
+
+/**
+ * Run non-blocking initialization to completion, recording how many bus
+ * transactions each call takes and rate divider while it's running
+ */
+static int8_t RunInit(bool mag)
+{
+    uint32_t tx;
+    int8_t r;
+
+    initMPU9250Start(mag);
+    while (true)
+    {
+        tx = HAL_MPU_Sim.transactions;
+        r = initMPU9250Step();
+        run.calls++;
+        tx = HAL_MPU_Sim.transactions - tx;
+        if (tx > run.maxTx)
+            run.maxTx = tx;
+        if (r != INIT_BUSY)
+            break;
+        if (HAL_MPU_SimReg(SMPLRT_DIV) > run.divMax)
+            run.divMax = HAL_MPU_SimReg(SMPLRT_DIV);
+        HAL_DelayUS(STEP_PERIOD_US);
+    }
+
+    return r;
+}
+
+/**
+ * Check configuration registers after successful initialization
+ */
+static void CheckConfig(uint8_t div, uint8_t dlpf, bool mag)
+{
+    Expect("SMPLRT_DIV", HAL_MPU_SimReg(SMPLRT_DIV), div);
+    Expect("CONFIG", HAL_MPU_SimReg(CONFIG), dlpf);
+    Expect("GYRO_CONFIG", HAL_MPU_SimReg(GYRO_CONFIG), MPU_GYRO_SCALE << 3);
+    Expect("ACCEL_CONFIG", HAL_MPU_SimReg(ACCEL_CONFIG), MPU_ACCEL_SCALE << 3);
+    Expect("ACCEL_CONFIG2", HAL_MPU_SimReg(ACCEL_CONFIG2), dlpf);
+    Expect("INT_PIN_CFG", HAL_MPU_SimReg(INT_PIN_CFG), 0x30);
+    Expect("INT_ENABLE", HAL_MPU_SimReg(INT_ENABLE), 0x01);
+    Expect("PWR_MGMT_1", HAL_MPU_SimReg(PWR_MGMT_1), 0x01);
+    Expect("divider while running", run.divMax, 0);
+    if (run.maxTx > STEP_MAX_TX)
+        Expect("tx per call", run.maxTx, STEP_MAX_TX);
+    if (!mag)
+        return;
+
+    Expect("USER_CTRL", HAL_MPU_SimReg(USER_CTRL), 0x20);
+    Expect("I2C_MST_CTRL", HAL_MPU_SimReg(I2C_MST_CTRL), 0x5D);
+    Expect("I2C_SLV0_ADDR", HAL_MPU_SimReg(I2C_SLV0_ADDR), 0x8C);
+    Expect("I2C_SLV0_REG", HAL_MPU_SimReg(I2C_SLV0_REG), AK8963_ST1);
+    Expect("I2C_SLV0_CTRL", HAL_MPU_SimReg(I2C_SLV0_CTRL), 0x88);
+    Expect("AK8963 CNTL", HAL_MPU_SimAkReg(AK8963_CNTL),
+           MPU_MAG_SCALE << 4 | M_100HZ);
+}
+
+/**
+ * Check that sensor data reaches data registers and, through slave 0,
+ * magnetometer data. Slave 0 reads AK8963 on every sample, so its data is
+ * new only right after a measurement; wait for it for up to 2 measurements
+ */
+static void CheckData(bool mag)
+{
+    int16_t v[3];
+    uint8_t i, status = 0;
+
+    HAL_DelayUS(110000);
+    readAccelData(v);
+    for (i = 0; i < 3; i++)
+        Expect("accel", (uint16_t)v[i], (uint16_t)HAL_MPU_Sim.accel[i]);
+    readGyroData(v);
+    for (i = 0; i < 3; i++)
+        Expect("gyro", (uint16_t)v[i], (uint16_t)HAL_MPU_Sim.gyro[i]);
+    if (!mag)
+        return;
+
+    for (i = 0; (i < 20) && !(status & MAG_STATUS_DRDY); i++)
+    {
+        HAL_DelayUS(1000);
+        status = readMagData(v);
+    }
+    Expect("mag status", status & MAG_STATUS_DRDY, MAG_STATUS_DRDY);
+    for (i = 0; i < 3; i++)
+        Expect("mag", (uint16_t)v[i], (uint16_t)HAL_MPU_Sim.mag[i]);
+}
+
+
+int main(int argc, char **argv)
+{
+    uint8_t div, dlpf;
+    int8_t r;
+
+    HAL_MPU_Sim.trace = (argc > 1) && (strcmp(argv[1], "-t") == 0);
+    HAL_MPU_Init();
+    HAL_MPU_PowerSwitch(true);
+    getFilterMPU9250(&div, &dlpf);
+
+    //  From power-on, chip answers only after its start-up time
+    Begin();
+    r = RunInit(true);
+    End("power-on, MPU and AK8963", r, INIT_OK);
+    CheckConfig(div, dlpf, true);
+    CheckData(true);
+
+    //  Rate change of running device is a single burst
+    Begin();
+    setFilterMPU9250(9, 2);
+    End("setFilterMPU9250(9, 2)", INIT_OK, INIT_OK);
+    Expect("tx", run.tx, 1);
+    CheckConfig(9, 2, true);
+
+    //  At low output rate, initialization still runs at full rate (slave 4
+    //  transactions and data polls wait for samples)
+    setFilterMPU9250(LOW_RATE_DIV, dlpf);
+    Begin();
+    r = RunInit(true);
+    End("init at 10Hz output rate", r, INIT_OK);
+    CheckConfig(LOW_RATE_DIV, dlpf, true);
+    CheckData(true);
+
+    Begin();
+    r = initAK8963();
+    End("initAK8963() at 10Hz output rate", r, INIT_OK);
+    Expect("SMPLRT_DIV", HAL_MPU_SimReg(SMPLRT_DIV), LOW_RATE_DIV);
+
+    //  Reset returns once chip answers, and invalidates the shadow: rate
+    //  change is only stored until the next initialization
+    Begin();
+    r = resetMPU9250();
+    End("resetMPU9250()", r, INIT_OK);
+    Expect("SMPLRT_DIV", HAL_MPU_SimReg(SMPLRT_DIV), 0);
+    Expect("PWR_MGMT_1", HAL_MPU_SimReg(PWR_MGMT_1), 0x01);
+    Begin();
+    setFilterMPU9250(div, dlpf);
+    Expect("tx after reset", HAL_MPU_Sim.transactions, 0);
+
+    Begin();
+    r = RunInit(false);
+    End("after reset, MPU only", r, INIT_OK);
+    CheckConfig(div, dlpf, false);
+    CheckData(false);
+
+    //  Failures: no MPU9250, no samples, no AK8963
+    HAL_MPU_Sim.present = false;
+    Begin();
+    r = RunInit(false);
+    End("no device", r, INIT_NO_DEVICE);
+    HAL_MPU_Sim.present = true;
+
+    HAL_MPU_Sim.sampling = false;
+    Begin();
+    r = RunInit(false);
+    End("no samples", r, INIT_TIMEOUT);
+    HAL_MPU_Sim.sampling = true;
+
+    HAL_MPU_Sim.akPresent = false;
+    Begin();
+    r = RunInit(true);
+    End("no AK8963", r, INIT_NO_DEVICE);
+    HAL_MPU_Sim.akPresent = true;
+
+    //  Recovers once AK8963 answers again
+    Begin();
+    r = RunInit(true);
+    End("AK8963 back", r, INIT_OK);
+    CheckConfig(div, dlpf, true);
+    CheckData(true);
+
+    printf("mismatches: %u\n", errors);
+
+    return (errors > 0) ? 2 : 0;
+}
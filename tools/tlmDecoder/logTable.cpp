@@ -0,0 +1,332 @@
+/**
+ * logTable.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "logTable.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "libs/myLib.h"
+
+//  Fields are little-endian, independent of the byte order of the host
+#define GET16(p)    ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET32(p)    ((uint32_t)GET16(p) | ((uint32_t)GET16((p) + 2) << 16))
+
+//  Macro whose calls are collected from the sources
+#define LOG_MACRO   "DEBUG_WRITE"
+
+
+/**
+ * Replace comments in C/C++ source with spaces (newlines are kept), leaving
+ * string and character literals as they are
+ * @param src Source code
+ */
+static void StripComments(std::string &src)
+{
+    size_t i = 0, end;
+    char q;
+
+    while (i < src.size())
+    {
+        if ((src[i] == '"') || (src[i] == '\''))
+        {
+            //  Skip literal, including escaped quotes
+            for (q = src[i++]; (i < src.size()) && (src[i] != q); i++)
+                if ((src[i] == '\\') && (i + 1 < src.size()))
+                    i++;
+            i++;
+        }
+        else if (src.compare(i, 2, "//") == 0)
+        {
+            end = src.find('\n', i);
+            if (end == std::string::npos)
+                end = src.size();
+            src.replace(i, end - i, end - i, ' ');
+            i = end;
+        }
+        else if (src.compare(i, 2, "/*") == 0)
+        {
+            end = src.find("*/", i + 2);
+            end = (end == std::string::npos) ? src.size() : end + 2;
+            for (; i < end; i++)
+                if (src[i] != '\n')
+                    src[i] = ' ';
+        }
+        else
+            i++;
+    }
+}
+
+
+/**
+ * Get ID of a format string, as computed by the MCU
+ * @param fmt Format string
+ * @return ID (CRC-16 of the string)
+ */
+uint16_t LogTable::Id(const std::string &fmt)
+{
+    return crc16(0xFFFF, (const uint8_t*)fmt.data(), (uint16_t)fmt.size());
+}
+
+/**
+ * Add format string to the table
+ * @param fmt Format string
+ * @return 1 if added, 0 if it was already in the table, -1 if another string
+ *         with the same ID is in the table
+ */
+int LogTable::Add(const std::string &fmt)
+{
+    uint16_t id = Id(fmt);
+    std::map<uint16_t, std::string>::iterator it = _fmt.find(id);
+
+    if (it == _fmt.end())
+    {
+        _fmt[id] = fmt;
+        return 1;
+    }
+
+    return (it->second == fmt) ? 0 : -1;
+}
+
+/**
+ * Add format strings of all DEBUG_WRITE calls in a source file
+ * Format string has to be a literal (or adjacent literals) given right in the
+ * call. Calls in comments are skipped, so dead strings don't take IDs.
+ * @param path Source file
+ * @return Number of calls found, -1 if file can't be read or a string has the
+ *         same ID as a different one already in the table (reported to stderr)
+ */
+int LogTable::Scan(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    std::string src, fmt;
+    char buf[4096];
+    size_t n, pos = 0, i;
+    int found = 0, retVal = 0;
+
+    if (f == NULL)
+        return -1;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        src.append(buf, n);
+    fclose(f);
+    StripComments(src);
+
+    while ((pos = src.find(LOG_MACRO "(", pos)) != std::string::npos)
+    {
+        pos += strlen(LOG_MACRO "(");
+        fmt.clear();
+
+        //  Collect adjacent string literals, resolving escape sequences
+        for (i = src.find_first_not_of(" \t\r\n", pos);
+             (i != std::string::npos) && (src[i] == '"');
+             i = src.find_first_not_of(" \t\r\n", i))
+        {
+            for (i++; (i < src.size()) && (src[i] != '"'); i++)
+            {
+                if ((src[i] != '\\') || (i + 1 >= src.size()))
+                {
+                    fmt += src[i];
+                    continue;
+                }
+                switch (src[++i])
+                {
+                case 'n':   fmt += '\n'; break;
+                case 'r':   fmt += '\r'; break;
+                case 't':   fmt += '\t'; break;
+                case 'x':
+                    fmt += (char)strtol(src.substr(i + 1, 2).c_str(), NULL, 16);
+                    i += 2;
+                    break;
+                default:    fmt += src[i]; break;
+                }
+            }
+            i++;
+        }
+        if (fmt.empty())
+            continue;
+
+        found++;
+        if (Add(fmt) < 0)
+        {
+            fprintf(stderr, "%s: ID 0x%04X of \"%s\" is taken by \"%s\"\n",
+                    path, Id(fmt), fmt.c_str(), _fmt[Id(fmt)].c_str());
+            retVal = -1;
+        }
+    }
+
+    return (retVal < 0) ? retVal : found;
+}
+
+/**
+ * Load table saved with Save(), adding strings to the ones already in table
+ * @param path Table file
+ * @return true if file was read
+ */
+bool LogTable::Load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512];
+    std::string fmt;
+    unsigned int id;
+    char *p;
+
+    if (f == NULL)
+        return false;
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (sscanf(line, "%4x", &id) != 1)
+            continue;
+        if ((p = strchr(line, '\t')) == NULL)
+            continue;
+
+        fmt.clear();
+        for (p++; (*p != 0) && (*p != '\n'); p++)
+        {
+            if ((*p != '\\') || (p[1] == 0))
+            {
+                fmt += *p;
+                continue;
+            }
+            switch (*++p)
+            {
+            case 'n':   fmt += '\n'; break;
+            case 'r':   fmt += '\r'; break;
+            case 't':   fmt += '\t'; break;
+            case 'x':
+                fmt += (char)strtol(std::string(p + 1, 2).c_str(), NULL, 16);
+                p += 2;
+                break;
+            default:    fmt += *p; break;
+            }
+        }
+        _fmt[(uint16_t)id] = fmt;
+    }
+
+    fclose(f);
+    return true;
+}
+
+/**
+ * Write table in the format read by Load()
+ * @param out File to write into
+ */
+void LogTable::Save(FILE *out) const
+{
+    std::map<uint16_t, std::string>::const_iterator it;
+    std::string::const_iterator c;
+
+    for (it = _fmt.begin(); it != _fmt.end(); ++it)
+    {
+        fprintf(out, "%04X\t", it->first);
+        for (c = it->second.begin(); c != it->second.end(); ++c)
+        {
+            if (*c == '\n')
+                fputs("\\n", out);
+            else if (*c == '\r')
+                fputs("\\r", out);
+            else if (*c == '\t')
+                fputs("\\t", out);
+            else if (*c == '\\')
+                fputs("\\\\", out);
+            else if ((uint8_t)*c < 0x20)
+                fprintf(out, "\\x%02X", (uint8_t)*c);
+            else
+                fputc(*c, out);
+        }
+        fputc('\n', out);
+    }
+}
+
+/**
+ * Expand log record into text
+ * Arguments missing from the record (they didn't fit) are shown as "<?>".
+ * @param rec Decoded record of type TLM_REC_LOG
+ * @return Formatted message, or a note with the ID if it's not in the table
+ */
+std::string LogTable::Expand(const TlmRecord &rec) const
+{
+    std::map<uint16_t, std::string>::const_iterator it = _fmt.find(rec.logId);
+    const uint8_t *p = rec.payload.data() + TLM_LEN_LOG;
+    const uint8_t *end = rec.payload.data() + rec.payload.size();
+    std::string out, spec;
+    char buf[300];
+    const char *f;
+    uint32_t v;
+    uint8_t n;
+
+    if (it == _fmt.end())
+    {
+        snprintf(buf, sizeof(buf), "<unknown log ID 0x%04X>", rec.logId);
+        return buf;
+    }
+
+    for (f = it->second.c_str(); *f != 0; f++)
+    {
+        if (*f != '%')
+        {
+            out += *f;
+            continue;
+        }
+
+        //  Fill, width and precision are passed on to snprintf
+        spec = "%";
+        for (f++; ((*f >= '0') && (*f <= '9')) || (*f == '.'); f++)
+            spec += *f;
+
+        switch (*f)
+        {
+        case 's':
+            if ((p >= end) || (p + 1 + *p > end))
+            {
+                out += "<?>";
+                p = end;
+                break;
+            }
+            n = *p++;
+            snprintf(buf, sizeof(buf), (spec + "s").c_str(),
+                     std::string((const char*)p, n).c_str());
+            p += n;
+            out += buf;
+            break;
+        case 'c':
+        case 'd':
+        case 'i':
+        case 'p':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (p + 4 > end)
+            {
+                out += "<?>";
+                p = end;
+                break;
+            }
+            v = GET32(p);
+            p += 4;
+            //  Same as uvsnprintf(), %p is printed as hex
+            if ((*f == 'd') || (*f == 'i'))
+                snprintf(buf, sizeof(buf), (spec + "d").c_str(), (int32_t)v);
+            else if (*f == 'p')
+                snprintf(buf, sizeof(buf), (spec + "x").c_str(), v);
+            else
+                snprintf(buf, sizeof(buf), (spec + *f).c_str(), v);
+            out += buf;
+            break;
+        case '%':
+            out += '%';
+            break;
+        case 0:
+            f--;
+            break;
+        default:
+            out += spec + *f;
+            break;
+        }
+    }
+
+    return out;
+}
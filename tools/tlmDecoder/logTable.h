@@ -0,0 +1,47 @@
+/**
+ * logTable.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Table of format strings of tokenized log messages (TLM_REC_LOG in
+ *  serialPort/tlmProtocol.h). Table is generated from sources of the firmware
+ *  by scanning them for DEBUG_WRITE calls, stored in a text file, and used to
+ *  expand received log records back into text.
+ *  File has one format string per line: ID as 4 hex digits, tab, string with
+ *  C escape sequences.
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#ifndef LOGTABLE_H_
+#define LOGTABLE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+
+#include "tlmDecoder.h"
+
+
+/**
+ * Map of IDs to format strings
+ */
+class LogTable
+{
+    public:
+        int     Add(const std::string &fmt);
+        int     Scan(const char *path);
+        bool    Load(const char *path);
+        void    Save(FILE *out) const;
+        std::string Expand(const TlmRecord &rec) const;
+
+        static uint16_t Id(const std::string &fmt);
+
+    private:
+        std::map<uint16_t, std::string> _fmt;
+};
+
+#endif /* LOGTABLE_H_ */
@@ -0,0 +1,230 @@
+/**
+ * quatBench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Measures error of packed attitude (serialPort/quatCodec.h) and time spent
+ *  packing and unpacking on this machine. Error is measured on quaternions
+ *  spread uniformly over all rotations, and on two synthetic streams like the
+ *  ones sent from main.cpp: quaternion integrated from gyro rates in floats
+ *  and normalized after every step, as done by Mahony filter (NODMP), and
+ *  the same converted from DMP's Q30 fixed-point with its length a bit off,
+ *  as read from DMP FIFO (DMP). Error is angle of rotation between sent and
+ *  received quaternion; error of TLM_REC_QUAT is shown for comparison.
+ *
+ *  Build (from root of the repository):
+ *      g++ -O2 -I. -o quatBench tools/tlmDecoder/quatBench.cpp
+ *          -x c serialPort/quatCodec.c -lm
+ *  Use:
+ *      quatBench
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+#include "serialPort/tlmProtocol.h"
+#include "serialPort/quatCodec.h"
+
+//  Number of uniformly spread quaternions
+#define UNIFORM_COUNT   1000000
+//  Number of samples in synthetic streams, 1 minute at 1kHz
+#define STREAM_COUNT    60000
+//  Number of passes over quaternions when timing
+#define TIMING_PASSES   20
+
+
+/**
+ * Error statistics, in degrees
+ */
+struct ErrStats
+{
+    double max, sum, sumSq;
+    size_t n;
+};
+
+static double Rand01()
+{
+    return rand() / (RAND_MAX + 1.0);
+}
+
+static double Now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Angle of rotation between two quaternions in degrees, neither has to be of
+ * unit length
+ */
+static double Angle(const float *a, const float *b)
+{
+    double dot = 0, na = 0, nb = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        dot += (double)a[i] * b[i];
+        na += (double)a[i] * a[i];
+        nb += (double)b[i] * b[i];
+    }
+    dot = fabs(dot) / sqrt(na * nb);
+    if (dot > 1.0)
+        dot = 1.0;
+
+    return 2.0 * acos(dot) * 180.0 / M_PI;
+}
+
+static void Add(ErrStats &s, double err)
+{
+    if (err > s.max)
+        s.max = err;
+    s.sum += err;
+    s.sumSq += err * err;
+    s.n++;
+}
+
+/**
+ * Measure error of packed quaternions, and of TLM_REC_QUAT for comparison
+ */
+static void Measure(const char *name, const std::vector<float> &q)
+{
+    ErrStats p = { 0, 0, 0, 0 }, f = { 0, 0, 0, 0 };
+    float out[4], v;
+
+    for (size_t i = 0; i < q.size(); i += 4)
+    {
+        quatUnpack(quatPack(&q[i]), out);
+        Add(p, Angle(&q[i], out));
+
+        //  Same rounding as Telemetry::SendQuat()
+        for (int j = 0; j < 4; j++)
+        {
+            v = q[i + j] * TLM_QUAT_SCALE;
+            v += (v < 0.0f) ? -0.5f : 0.5f;
+            out[j] = (float)(int16_t)v / TLM_QUAT_SCALE;
+        }
+        Add(f, Angle(&q[i], out));
+    }
+
+    printf("%-8s QUATP: max %.4f, mean %.4f, RMS %.4f deg | "
+           "QUAT: max %.4f, RMS %.4f deg\n", name, p.max, p.sum / p.n,
+           sqrt(p.sumSq / p.n), f.max, sqrt(f.sumSq / f.n));
+}
+
+/**
+ * Quaternions spread uniformly over all rotations (Shoemake's method)
+ */
+static void Uniform(std::vector<float> &q)
+{
+    double u1, u2, u3;
+
+    for (size_t i = 0; i < UNIFORM_COUNT; i++)
+    {
+        u1 = Rand01();
+        u2 = 2 * M_PI * Rand01();
+        u3 = 2 * M_PI * Rand01();
+        q.push_back((float)(sqrt(1 - u1) * sin(u2)));
+        q.push_back((float)(sqrt(1 - u1) * cos(u2)));
+        q.push_back((float)(sqrt(u1) * sin(u3)));
+        q.push_back((float)(sqrt(u1) * cos(u3)));
+    }
+}
+
+/**
+ * Quaternion integrated at 1kHz from gyro rates of up to 180deg/s, in floats
+ * and normalized after every step like Mahony::Update(). With dmp set, it's
+ * also rounded to Q30 and scaled by up to +-0.1% like output of DMP
+ */
+static void Stream(std::vector<float> &q, bool dmp)
+{
+    float w = 1, x = 0, y = 0, z = 0, gx, gy, gz, qa, qb, qc, n, s;
+    const float dt = 0.001f;
+
+    for (size_t i = 0; i < STREAM_COUNT; i++)
+    {
+        gx = (float)(M_PI * sin(0.7 * i * dt)) * 0.5f * dt;
+        gy = (float)(M_PI * sin(1.1 * i * dt + 1)) * 0.5f * dt;
+        gz = (float)(M_PI * cos(0.3 * i * dt)) * 0.5f * dt;
+        qa = w;
+        qb = x;
+        qc = y;
+        w += (-qb * gx - qc * gy - z * gz);
+        x += (qa * gx + qc * gz - z * gy);
+        y += (qa * gy - qb * gz + z * gx);
+        z += (qa * gz + qb * gy - qc * gx);
+        n = 1.0f / sqrtf(w * w + x * x + y * y + z * z);
+        w *= n;
+        x *= n;
+        y *= n;
+        z *= n;
+
+        if (!dmp)
+        {
+            q.push_back(w);
+            q.push_back(x);
+            q.push_back(y);
+            q.push_back(z);
+            continue;
+        }
+
+        s = (float)(1.0 + (Rand01() - 0.5) * 0.002);
+        q.push_back((float)(long)(w * s * 1073741824.0f) / 1073741824.0f);
+        q.push_back((float)(long)(x * s * 1073741824.0f) / 1073741824.0f);
+        q.push_back((float)(long)(y * s * 1073741824.0f) / 1073741824.0f);
+        q.push_back((float)(long)(z * s * 1073741824.0f) / 1073741824.0f);
+    }
+}
+
+
+int main()
+{
+    std::vector<float> uniform, mahony, dmp, out;
+    std::vector<uint32_t> packed;
+    double t0, tPack, tUnpack;
+
+    srand(1);
+    Uniform(uniform);
+    Stream(mahony, false);
+    Stream(dmp, true);
+
+    Measure("uniform", uniform);
+    Measure("Mahony", mahony);
+    Measure("DMP", dmp);
+
+    //  Timing, on uniformly spread quaternions; codec is in another
+    //  translation unit, so calls aren't optimized away
+    packed.resize(uniform.size() / 4);
+    out.resize(uniform.size());
+    t0 = Now();
+    for (int k = 0; k < TIMING_PASSES; k++)
+        for (size_t i = 0; i < packed.size(); i++)
+            packed[i] = quatPack(&uniform[4 * i]);
+    tPack = Now() - t0;
+    t0 = Now();
+    for (int k = 0; k < TIMING_PASSES; k++)
+        for (size_t i = 0; i < packed.size(); i++)
+            quatUnpack(packed[i], &out[4 * i]);
+    tUnpack = Now() - t0;
+
+    printf("pack:   %5.1f ns/quaternion (%.1f M/s)\n",
+           tPack * 1e9 / (packed.size() * TIMING_PASSES),
+           packed.size() * TIMING_PASSES / tPack / 1e6);
+    printf("unpack: %5.1f ns/quaternion (%.1f M/s)\n",
+           tUnpack * 1e9 / (packed.size() * TIMING_PASSES),
+           packed.size() * TIMING_PASSES / tUnpack / 1e6);
+    //  Type, seq, CRC, COBS overhead and delimiter
+    printf("on the wire: QUATP %d B, QUAT %d B\n",
+           TLM_HEADER_LEN + TLM_LEN_QUATP + TLM_CRC_LEN + 2,
+           TLM_HEADER_LEN + TLM_LEN_QUAT + TLM_CRC_LEN + 2);
+
+    return 0;
+}
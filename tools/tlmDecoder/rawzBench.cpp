@@ -0,0 +1,245 @@
+/**
+ * rawzBench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Measures compression of raw samples (serialPort/rawCodec.h) on a capture
+ *  of telemetry holding TLM_REC_RAW records (e.g. saved with RAW subscribed
+ *  with divider 1), or on synthetic samples (slow motion with sensor noise)
+ *  if no capture is given. Samples are framed the way the MCU does it, once
+ *  as TLM_REC_RAW records and once as TLM_REC_RAWZ blocks, and the second
+ *  stream is decoded again to check it gives back the same samples. Prints
+ *  bytes on the wire per sample for both, and time spent encoding and
+ *  decoding one sample on this machine.
+ *
+ *  Build (from root of the repository):
+ *      g++ -O2 -I. -o rawzBench tools/tlmDecoder/rawzBench.cpp
+ *          tools/tlmDecoder/tlmDecoder.cpp -x c libs/myLib.c
+ *          serialPort/rawCodec.c
+ *          serialPort/quatCodec.c -lm
+ *  Use:
+ *      rawzBench [capture.bin]
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "tlmDecoder.h"
+#include "libs/myLib.h"
+
+#define PUT16(p, v) do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } \
+                    while (0)
+#define PUT32(p, v) do { PUT16((p), (v)); PUT16((p) + 2, (v) >> 16); } while (0)
+
+//  Number of synthetic samples, 1 minute at 1kHz
+#define SYNTH_SAMPLES   60000
+
+
+/**
+ * Frame record the same way as Telemetry::SendRecord()
+ * @return Length of frame with delimiter
+ */
+static size_t Frame(uint8_t type, uint8_t seq, const uint8_t *payload,
+                    uint8_t len, uint8_t *out)
+{
+    uint8_t frame[TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN];
+    uint16_t crc, n;
+
+    frame[0] = type;
+    frame[1] = seq;
+    memcpy(frame + TLM_HEADER_LEN, payload, len);
+    len += TLM_HEADER_LEN;
+    crc = crc16(0xFFFF, frame, len);
+    PUT16(frame + len, crc);
+    len += TLM_CRC_LEN;
+
+    n = cobsEncode(frame, len, out);
+    out[n++] = 0;
+
+    return n;
+}
+
+/**
+ * Read raw samples from a capture of telemetry
+ * @return true if file was read
+ */
+static bool Load(const char *path, std::vector<int16_t> &samples,
+                 std::vector<uint32_t> &times)
+{
+    FILE *in = fopen(path, "rb");
+    uint8_t buf[256];
+    size_t n;
+    std::vector<TlmRecord> recs;
+    TlmDecoder dec;
+
+    if (in == NULL)
+        return false;
+
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        dec.Feed(buf, n, recs);
+    fclose(in);
+
+    for (size_t i = 0; i < recs.size(); i++)
+    {
+        if (recs[i].type != TLM_REC_RAW)
+            continue;
+        samples.insert(samples.end(), recs[i].acc, recs[i].acc + 3);
+        samples.insert(samples.end(), recs[i].gyro, recs[i].gyro + 3);
+        samples.insert(samples.end(), recs[i].mag, recs[i].mag + 3);
+        times.push_back(recs[i].time);
+    }
+
+    return true;
+}
+
+/**
+ * Generate samples at 1kHz: sensor slowly rotating about all axes, with
+ * noise of a few LSB, magnetometer updated at 100Hz
+ */
+static void Synthesize(std::vector<int16_t> &samples,
+                       std::vector<uint32_t> &times)
+{
+    int16_t mag[3] = { 0 };
+    double t, a;
+
+    srand(1);
+    for (uint32_t i = 0; i < SYNTH_SAMPLES; i++)
+    {
+        t = i / 1000.0;
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            a = sin(2 * M_PI * (0.2 + 0.1*j) * t + j);
+            //  Accelerometer, +-2g: 16384 LSB/g
+            samples.push_back((int16_t)(16384 * a + rand() % 41 - 20));
+            //  Gyroscope, +-250dps: 131 LSB/dps, up to 60dps
+            samples.push_back((int16_t)(131 * 60 * cos(2 * M_PI * (0.2 + 0.1*j)
+                                        * t + j) + rand() % 11 - 5));
+        }
+        if ((i % 10) == 0)
+            for (uint8_t j = 0; j < 3; j++)
+                mag[j] = (int16_t)(200 * sin(t + j) + rand() % 5 - 2);
+        samples.insert(samples.end(), mag, mag + 3);
+        times.push_back(i * 1000);
+    }
+
+    //  Samples above were generated as acc, gyro interleaved per axis
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        int16_t s[6];
+
+        memcpy(s, &samples[i * RAWZ_AXES], sizeof(s));
+        for (uint8_t j = 0; j < 3; j++)
+        {
+            samples[i * RAWZ_AXES + j] = s[2*j];
+            samples[i * RAWZ_AXES + 3 + j] = s[2*j + 1];
+        }
+    }
+}
+
+static double Now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+int main(int argc, char **argv)
+{
+    std::vector<int16_t> samples;
+    std::vector<uint32_t> times;
+    std::vector<uint8_t> wire;
+    std::vector<TlmRecord> recs;
+    uint8_t p[TLM_LEN_RAW], out[TLM_MAX_FRAME];
+    size_t n, rawBytes = 0, blocks = 0, errors = 0;
+    uint8_t seq = 0, len;
+    double t0, tEnc, tDec;
+    RawzEncoder enc;
+    TlmDecoder dec;
+
+    if (argc > 1)
+    {
+        if (!Load(argv[1], samples, times))
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    else
+        Synthesize(samples, times);
+
+    n = times.size();
+    if (n == 0)
+    {
+        fprintf(stderr, "no raw samples\n");
+        return 1;
+    }
+
+    //  Uncompressed: one TLM_REC_RAW record per sample
+    for (size_t i = 0; i < n; i++)
+    {
+        PUT32(p, times[i]);
+        for (uint8_t j = 0; j < RAWZ_AXES; j++)
+            PUT16(p + 4 + 2*j, (uint16_t)samples[i * RAWZ_AXES + j]);
+        rawBytes += Frame(TLM_REC_RAW, seq++, p, TLM_LEN_RAW, out);
+    }
+
+    //  Encoder alone is timed first, framing costs the same either way
+    rawzInit(&enc);
+    t0 = Now();
+    for (size_t i = 0; i < n; i++)
+        blocks += rawzPush(&enc, times[i], &samples[i * RAWZ_AXES]);
+    tEnc = Now() - t0;
+
+    //  Compressed
+    rawzInit(&enc);
+    blocks = 0;
+    for (size_t i = 0; i <= n; i++)
+    {
+        len = (i < n) ? rawzPush(&enc, times[i], &samples[i * RAWZ_AXES])
+                      : rawzFlush(&enc);
+        if (len > 0)
+        {
+            blocks++;
+            len = (uint8_t)Frame(TLM_REC_RAWZ, seq++, enc.buf, len, out);
+            wire.insert(wire.end(), out, out + len);
+        }
+    }
+
+    //  Decode and compare
+    t0 = Now();
+    dec.Feed(&wire[0], wire.size(), recs);
+    tDec = Now() - t0;
+
+    if (recs.size() != n)
+        errors = (recs.size() > n) ? recs.size() - n : n - recs.size();
+    for (size_t i = 0; (i < n) && (i < recs.size()); i++)
+    {
+        const int16_t *s = &samples[i * RAWZ_AXES];
+
+        if (memcmp(recs[i].acc, s, 6) || memcmp(recs[i].gyro, s + 3, 6)
+            || memcmp(recs[i].mag, s + 6, 6))
+            errors++;
+    }
+
+    printf("samples: %u, RAWZ blocks: %u (%.1f samples/block)\n",
+           (unsigned)n, (unsigned)blocks, (double)n / blocks);
+    printf("raw values:      %5.2f B/sample\n", 2.0 * RAWZ_AXES);
+    printf("TLM_REC_RAW:     %5.2f B/sample\n", (double)rawBytes / n);
+    printf("TLM_REC_RAWZ:    %5.2f B/sample (%.2fx vs raw values, %.2fx vs "
+           "TLM_REC_RAW)\n", (double)wire.size() / n,
+           2.0 * RAWZ_AXES * n / wire.size(), (double)rawBytes / wire.size());
+    printf("encode:          %5.1f ns/sample\n", tEnc * 1e9 / n);
+    printf("decode:          %5.1f ns/sample (with framing)\n", tDec * 1e9 / n);
+    printf("mismatches:      %u\n", (unsigned)errors);
+
+    return (errors > 0) ? 2 : 0;
+}
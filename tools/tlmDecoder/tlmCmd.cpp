@@ -0,0 +1,98 @@
+/**
+ * tlmCmd.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Frames a command for the MCU (serialPort/command.h) and writes it to
+ *  standard output, to be redirected into the serial port. Acknowledgment
+ *  comes back in telemetry, shown by tlmDump as an "ack" line.
+ *
+ *  Build (from root of the repository):
+ *      g++ -I. -o tlmCmd tools/tlmDecoder/tlmCmd.cpp
+ *          tools/tlmDecoder/tlmDecoder.cpp -x c libs/myLib.c
+ *          serialPort/rawCodec.c
+ *          serialPort/quatCodec.c -lm
+ *  Use:
+ *      tlmCmd odr <Hz>                 output data rate
+ *      tlmCmd dlpf <1..6>              bandwidth of sensor's low-pass filter
+ *      tlmCmd ahrs <kp> <ki>           AHRS gains (NODMP only)
+ *      tlmCmd cal <samples>            calibrate and store it (NODMP only)
+ *      tlmCmd sub <type> <divider>     subscription to record type (1-3, 6, 7)
+ *  e.g.
+ *      tlmCmd sub 1 0 > /dev/ttyACM0
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tlmDecoder.h"
+
+#define PUT16(p, v) do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } \
+                    while (0)
+#define PUT32(p, v) do { PUT16((p), (v)); PUT16((p) + 2, (v) >> 16); } while (0)
+
+
+int main(int argc, char **argv)
+{
+    uint8_t p[TLM_MAX_PAYLOAD], out[TLM_MAX_FRAME + 1];
+    uint8_t type, len;
+    uint32_t u;
+    float f;
+    size_t n;
+
+    if ((argc == 3) && !strcmp(argv[1], "odr"))
+    {
+        type = CMD_SET_ODR;
+        len = CMD_LEN_ODR;
+        PUT16(p, (uint16_t)atoi(argv[2]));
+    }
+    else if ((argc == 3) && !strcmp(argv[1], "dlpf"))
+    {
+        type = CMD_SET_DLPF;
+        len = CMD_LEN_DLPF;
+        p[0] = (uint8_t)atoi(argv[2]);
+    }
+    else if ((argc == 4) && !strcmp(argv[1], "ahrs"))
+    {
+        type = CMD_SET_AHRS;
+        len = CMD_LEN_AHRS;
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            f = (float)atof(argv[2 + i]);
+            memcpy(&u, &f, sizeof(u));
+            PUT32(p + 4*i, u);
+        }
+    }
+    else if ((argc == 3) && !strcmp(argv[1], "cal"))
+    {
+        type = CMD_CALIBRATE;
+        len = CMD_LEN_CALIBRATE;
+        PUT16(p, (uint16_t)atoi(argv[2]));
+    }
+    else if ((argc == 4) && !strcmp(argv[1], "sub"))
+    {
+        type = CMD_SUBSCRIBE;
+        len = CMD_LEN_SUBSCRIBE;
+        p[0] = (uint8_t)atoi(argv[2]);
+        PUT16(p + 1, (uint16_t)atoi(argv[3]));
+    }
+    else
+    {
+        fprintf(stderr, "usage: %s odr <Hz> | dlpf <1..6> | ahrs <kp> <ki> | "
+                "cal <samples> | sub <type> <divider>\n", argv[0]);
+        return 1;
+    }
+
+    //  Sequence number only has to tell apart acknowledgments of commands sent
+    //  one after another, time in seconds does for manual use
+    n = TlmEncodeCommand(type, (uint8_t)time(NULL), p, len, out);
+    fwrite(out, 1, n, stdout);
+
+    return 0;
+}
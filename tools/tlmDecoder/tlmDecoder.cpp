@@ -0,0 +1,336 @@
+/**
+ * tlmDecoder.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ */
+#include "tlmDecoder.h"
+
+#include <string.h>
+
+#include "libs/myLib.h"
+
+//  Fields are little-endian, independent of the byte order of the host
+#define GET16(p)    ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET32(p)    ((uint32_t)GET16(p) | ((uint32_t)GET16((p) + 2) << 16))
+#define PUT16(p, v) do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } \
+                    while (0)
+#define PUT32(p, v) do { PUT16((p), (v)); PUT16((p) + 2, (v) >> 16); } while (0)
+
+
+/**
+ * Frame a command for the MCU
+ * Frame starts with a delimiter, see CMD_* in serialPort/tlmProtocol.h.
+ * @param type Command type (CMD_*)
+ * @param seq Sequence number, returned in acknowledgment
+ * @param payload Packed payload of the command
+ * @param len Length of payload, max. TLM_MAX_PAYLOAD
+ * @param out Buffer for the frame, at least TLM_MAX_FRAME + 1 bytes
+ * @return Length of the frame, 0 if payload is too long
+ */
+size_t TlmEncodeCommand(uint8_t type, uint8_t seq, const uint8_t *payload,
+                        uint8_t len, uint8_t *out)
+{
+    uint8_t frame[TLM_HEADER_LEN + TLM_MAX_PAYLOAD + TLM_CRC_LEN];
+    uint16_t crc, n;
+
+    if (len > TLM_MAX_PAYLOAD)
+        return 0;
+
+    frame[0] = type;
+    frame[1] = seq;
+    memcpy(frame + TLM_HEADER_LEN, payload, len);
+    len += TLM_HEADER_LEN;
+    crc = crc16(0xFFFF, frame, len);
+    frame[len++] = (uint8_t)crc;
+    frame[len++] = (uint8_t)(crc >> 8);
+
+    out[0] = 0;
+    n = cobsEncode(frame, len, out + 1);
+    out[n + 1] = 0;
+
+    return n + 2;
+}
+
+
+TlmDecoder::TlmDecoder()
+{
+    Reset();
+}
+
+/**
+ * Feed bytes received from the link
+ * Decoded records are appended to out. Frame which is cut by the end of data
+ * is completed by the next call.
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @param out Vector to which decoded records are appended
+ * @return Number of records appended
+ */
+size_t TlmDecoder::Feed(const uint8_t *data, size_t len,
+                        std::vector<TlmRecord> &out)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (data[i] != 0)
+        {
+            //  Frame longer than any valid one, delimiter must have been lost
+            if (_buf.size() >= TLM_MAX_FRAME)
+            {
+                if (!_skip)
+                    _stats.badFrames++;
+                _skip = true;
+                _buf.clear();
+            }
+            else if (!_skip)
+                _buf.push_back(data[i]);
+            continue;
+        }
+
+        //  Delimiter: end of a frame, empty ones are skipped
+        if (!_skip && !_buf.empty())
+            n += _Frame(out);
+        _buf.clear();
+        _skip = false;
+    }
+
+    return n;
+}
+
+/**
+ * Drop partially received frame and clear statistics
+ */
+void TlmDecoder::Reset()
+{
+    _buf.clear();
+    _skip = false;
+    _nextSeq = 0;
+    _synced = false;
+    _rzValid = false;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/**
+ * Get statistics of the link since the last Reset()
+ * @return Reference to statistics
+ */
+const TlmStats& TlmDecoder::Stats() const
+{
+    return _stats;
+}
+
+///-----------------------------------------------------------------------------
+///                      Private helper functions                      [PRIVATE]
+///-----------------------------------------------------------------------------
+
+/**
+ * Decode frame collected in _buf (without delimiter)
+ * @param out Vector to which decoded records are appended
+ * @return Number of records appended: 1 for a valid record of a known type,
+ *         number of samples for a block of compressed samples, 0 otherwise
+ */
+size_t TlmDecoder::_Frame(std::vector<TlmRecord> &out)
+{
+    uint8_t frame[TLM_MAX_FRAME];
+    int32_t len;
+    uint8_t seq;
+    TlmRecord rec;
+
+    len = cobsDecode(&_buf[0], (uint16_t)_buf.size(), frame);
+    if (len < (TLM_HEADER_LEN + TLM_CRC_LEN))
+    {
+        _stats.badFrames++;
+        return 0;
+    }
+    len -= TLM_CRC_LEN;
+    if (crc16(0xFFFF, frame, (uint16_t)len) != GET16(frame + len))
+    {
+        _stats.crcErrors++;
+        return 0;
+    }
+
+    //  Frames between the last one and this one were lost, compressed samples
+    //  can't be decoded until the next keyframe
+    seq = frame[1];
+    if (_synced && (seq != _nextSeq))
+    {
+        _stats.lost += (uint8_t)(seq - _nextSeq);
+        _rzValid = false;
+    }
+    _nextSeq = seq + 1;
+    _synced = true;
+    _stats.frames++;
+
+    if (frame[0] == TLM_REC_RAWZ)
+        return _Rawz(frame + TLM_HEADER_LEN, len - TLM_HEADER_LEN, seq, out);
+
+    rec.type = frame[0];
+    rec.seq = seq;
+    if (!_Parse(frame + TLM_HEADER_LEN, len - TLM_HEADER_LEN, rec))
+    {
+        _stats.unknown++;
+        return 0;
+    }
+    out.push_back(rec);
+
+    return 1;
+}
+
+/**
+ * Unpack payload of a record of type already stored in rec
+ * @param p Payload
+ * @param len Length of payload
+ * @param rec Record to fill in
+ * @return true if type is known and payload has the right length for it
+ */
+bool TlmDecoder::_Parse(const uint8_t *p, size_t len, TlmRecord &rec)
+{
+    rec.payload.assign(p, p + len);
+
+    switch (rec.type)
+    {
+    case TLM_REC_RAW:
+        if (len != TLM_LEN_RAW)
+            return false;
+        rec.time = GET32(p);
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            rec.acc[i] = (int16_t)GET16(p + 4 + 2*i);
+            rec.gyro[i] = (int16_t)GET16(p + 10 + 2*i);
+            rec.mag[i] = (int16_t)GET16(p + 16 + 2*i);
+        }
+        return true;
+    case TLM_REC_QUAT:
+        if (len != TLM_LEN_QUAT)
+            return false;
+        rec.time = GET32(p);
+        for (uint8_t i = 0; i < 4; i++)
+            rec.quat[i] = (float)(int16_t)GET16(p + 4 + 2*i) / TLM_QUAT_SCALE;
+        return true;
+    case TLM_REC_QUATP:
+        if (len != TLM_LEN_QUATP)
+            return false;
+        rec.type = TLM_REC_QUAT;
+        rec.time = GET32(p);
+        quatUnpack(GET32(p + 4), rec.quat);
+        return true;
+    case TLM_REC_STATUS:
+        if (len != TLM_LEN_STATUS)
+            return false;
+        rec.time = GET32(p);
+        rec.samples = GET32(p + 4);
+        rec.errors = GET16(p + 8);
+        rec.flags = p[10];
+        return true;
+    case TLM_REC_ACK:
+        if (len != TLM_LEN_ACK)
+            return false;
+        //  Acknowledgment isn't timestamped
+        rec.time = 0;
+        rec.cmd = p[0];
+        rec.cmdSeq = p[1];
+        rec.result = p[2];
+        return true;
+    case TLM_REC_LOG:
+        if (len < TLM_LEN_LOG)
+            return false;
+        rec.time = GET32(p);
+        rec.logId = GET16(p + 4);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Expand block of compressed raw samples into TLM_REC_RAW records
+ * Timestamps of samples are spread evenly between the ones of the first and
+ * the last sample in block.
+ * @param p Payload of TLM_REC_RAWZ record
+ * @param len Length of payload
+ * @param seq Sequence number of the frame, given to all records
+ * @param out Vector to which records are appended
+ * @return Number of records appended
+ */
+size_t TlmDecoder::_Rawz(const uint8_t *p, size_t len, uint8_t seq,
+                         std::vector<TlmRecord> &out)
+{
+    int16_t s[RAWZ_AXES];
+    uint8_t raw[TLM_LEN_RAW];
+    std::vector<int16_t> samples;
+    uint32_t tFirst, tLast;
+    uint8_t count, i;
+    size_t pos = TLM_LEN_RAWZ;
+    int16_t used;
+    TlmRecord rec;
+
+    if ((len < TLM_LEN_RAWZ) || (p[8] == 0))
+    {
+        _stats.unknown++;
+        return 0;
+    }
+    tFirst = GET32(p);
+    tLast = GET32(p + 4);
+    count = p[8];
+
+    //  Keyframe holds the first sample as it is
+    memcpy(s, _rzPrev, sizeof(s));
+    i = 0;
+    if (p[9] & TLM_RAWZ_KEY)
+    {
+        if (len < (pos + 2 * RAWZ_AXES))
+        {
+            _stats.unknown++;
+            _rzValid = false;
+            return 0;
+        }
+        for (uint8_t j = 0; j < RAWZ_AXES; j++)
+            s[j] = (int16_t)GET16(p + pos + 2*j);
+        pos += 2 * RAWZ_AXES;
+        samples.insert(samples.end(), s, s + RAWZ_AXES);
+        i++;
+    }
+    else if (!_rzValid)
+    {
+        _stats.skipped++;
+        return 0;
+    }
+
+    for (; i < count; i++)
+    {
+        used = rawzDeltaDecode(p + pos, (uint16_t)(len - pos), s);
+        if (used < 0)
+            break;
+        pos += used;
+        samples.insert(samples.end(), s, s + RAWZ_AXES);
+    }
+    //  Block must hold exactly the number of samples it claims to
+    if ((i < count) || (pos != len))
+    {
+        _stats.unknown++;
+        _rzValid = false;
+        return 0;
+    }
+    memcpy(_rzPrev, s, sizeof(s));
+    _rzValid = true;
+
+    for (i = 0; i < count; i++)
+    {
+        //  Pack sample as TLM_REC_RAW payload and parse it as such
+        rec.type = TLM_REC_RAW;
+        rec.seq = seq;
+        if (count > 1)
+            PUT32(raw, tFirst + (uint32_t)((uint64_t)(tLast - tFirst) * i
+                                           / (count - 1)));
+        else
+            PUT32(raw, tFirst);
+        for (uint8_t j = 0; j < RAWZ_AXES; j++)
+            PUT16(raw + 4 + 2*j, (uint16_t)samples[i * RAWZ_AXES + j]);
+        _Parse(raw, TLM_LEN_RAW, rec);
+        out.push_back(rec);
+    }
+
+    return count;
+}
@@ -0,0 +1,117 @@
+/**
+ * tlmDecoder.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Host-side decoder of binary telemetry sent by serialPort/telemetry.cpp.
+ *  Bytes read from the serial port are fed in as they come, in chunks of any
+ *  size; decoder finds frames, checks them and returns decoded records. Lost
+ *  and corrupted frames are counted. Frame format is in
+ *  serialPort/tlmProtocol.h. TlmEncodeCommand() frames commands to be sent
+ *  to the MCU.
+ *  Blocks of compressed raw samples (TLM_REC_RAWZ) are expanded into one
+ *  TLM_REC_RAW record per sample, and packed attitude (TLM_REC_QUATP) is
+ *  returned as TLM_REC_QUAT, so users see the same records either way.
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +Expansion of compressed raw samples
+ *  +Unpacking of packed attitude
+ */
+#ifndef TLMDECODER_H_
+#define TLMDECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "serialPort/tlmProtocol.h"
+#include "serialPort/rawCodec.h"
+#include "serialPort/quatCodec.h"
+
+
+/**
+ * Decoded telemetry record, only fields of its type are valid
+ */
+struct TlmRecord
+{
+    uint8_t  type;      //  TLM_REC_*
+    uint8_t  seq;       //  Sequence number of the frame
+    uint32_t time;      //  Timestamp in us (all known types)
+    //  TLM_REC_RAW
+    int16_t  acc[3];
+    int16_t  gyro[3];
+    int16_t  mag[3];
+    //  TLM_REC_QUAT, [w,x,y,z]
+    float    quat[4];
+    //  TLM_REC_STATUS
+    uint32_t samples;
+    uint16_t errors;
+    uint8_t  flags;
+    //  TLM_REC_ACK: type and seq of acknowledged command, CMD_RES_* result
+    uint8_t  cmd;
+    uint8_t  cmdSeq;
+    uint8_t  result;
+    //  TLM_REC_LOG: ID of format string, arguments are left in payload
+    //  (expanded with LogTable)
+    uint16_t logId;
+    //  Payload as received, for record types not known to the decoder (packed
+    //  as TLM_REC_RAW payload for samples expanded from TLM_REC_RAWZ)
+    std::vector<uint8_t> payload;
+};
+
+/**
+ * Statistics of the link
+ */
+struct TlmStats
+{
+    uint32_t frames;    //  Valid frames decoded
+    uint32_t lost;      //  Frames missing according to sequence numbers
+    uint32_t crcErrors; //  Frames with bad CRC
+    uint32_t badFrames; //  Frames with bad COBS encoding, too long or short
+    uint32_t unknown;   //  Valid frames of unknown record type, or known type
+                        //  with wrong length
+    uint32_t skipped;   //  Blocks of compressed samples skipped while waiting
+                        //  for a keyframe (after start or lost frames)
+};
+
+size_t  TlmEncodeCommand(uint8_t type, uint8_t seq, const uint8_t *payload,
+                         uint8_t len, uint8_t *out);
+
+/**
+ * Stream decoder of telemetry frames
+ */
+class TlmDecoder
+{
+    public:
+        TlmDecoder();
+
+        size_t  Feed(const uint8_t *data, size_t len,
+                     std::vector<TlmRecord> &out);
+        void    Reset();
+        const TlmStats& Stats() const;
+
+    private:
+        size_t  _Frame(std::vector<TlmRecord> &out);
+        bool    _Parse(const uint8_t *p, size_t len, TlmRecord &rec);
+        size_t  _Rawz(const uint8_t *p, size_t len, uint8_t seq,
+                      std::vector<TlmRecord> &out);
+
+        //  Bytes of frame being received, and flag that it grew too long and
+        //  is skipped until the next delimiter
+        std::vector<uint8_t> _buf;
+        bool     _skip;
+        //  Sequence number expected next, valid once first frame is received
+        uint8_t  _nextSeq;
+        bool     _synced;
+        //  Last sample of compressed stream, base for the next difference;
+        //  invalid until a keyframe is received
+        int16_t  _rzPrev[RAWZ_AXES];
+        bool     _rzValid;
+        TlmStats _stats;
+};
+
+#endif /* TLMDECODER_H_ */
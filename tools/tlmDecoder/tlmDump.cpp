@@ -0,0 +1,111 @@
+/**
+ * tlmDump.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Example use of TlmDecoder: reads telemetry from a file (or standard input,
+ *  e.g. piped from the serial port) and prints records as CSV lines, one per
+ *  record with its type in the first column. Link statistics are printed to
+ *  standard error at the end. Tokenized log messages are expanded with table
+ *  of format strings given with -l (made by tlmLogTable). Compressed raw
+ *  samples and packed attitude are printed as "raw" and "quat" lines, same as
+ *  uncompressed ones.
+ *
+ *  Build (from root of the repository):
+ *      g++ -I. -o tlmDump tools/tlmDecoder/tlmDump.cpp
+ *          tools/tlmDecoder/tlmDecoder.cpp tools/tlmDecoder/logTable.cpp
+ *          -x c libs/myLib.c serialPort/rawCodec.c
+ *          serialPort/quatCodec.c -lm
+ *  Use:
+ *      tlmDump [-l log.tbl] capture.bin
+ *      stty -F /dev/ttyACM0 115200 raw && tlmDump < /dev/ttyACM0
+ *
+ *  @version 1.1.0
+ *  V1.0.0
+ *  +Creation of file
+ *  V1.1.0
+ *  +Acknowledgments and tokenized log messages
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "tlmDecoder.h"
+#include "logTable.h"
+
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    uint8_t buf[256];
+    size_t n;
+    std::vector<TlmRecord> recs;
+    TlmDecoder dec;
+    LogTable logs;
+    std::string text;
+    int arg = 1;
+
+    if ((argc > 2) && !strcmp(argv[1], "-l"))
+    {
+        if (!logs.Load(argv[2]))
+        {
+            perror(argv[2]);
+            return 1;
+        }
+        arg = 3;
+    }
+    if ((argc > arg) && ((in = fopen(argv[arg], "rb")) == NULL))
+    {
+        perror(argv[arg]);
+        return 1;
+    }
+
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        recs.clear();
+        dec.Feed(buf, n, recs);
+
+        for (size_t i = 0; i < recs.size(); i++)
+        {
+            const TlmRecord &r = recs[i];
+
+            switch (r.type)
+            {
+            case TLM_REC_RAW:
+                printf("raw,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", r.time,
+                       r.acc[0], r.acc[1], r.acc[2], r.gyro[0], r.gyro[1],
+                       r.gyro[2], r.mag[0], r.mag[1], r.mag[2]);
+                break;
+            case TLM_REC_QUAT:
+                printf("quat,%u,%.5f,%.5f,%.5f,%.5f\n", r.time, r.quat[0],
+                       r.quat[1], r.quat[2], r.quat[3]);
+                break;
+            case TLM_REC_STATUS:
+                printf("status,%u,%u,%u,0x%02X\n", r.time, r.samples,
+                       r.errors, r.flags);
+                break;
+            case TLM_REC_ACK:
+                printf("ack,0x%02X,%u,%u\n", r.cmd, r.cmdSeq, r.result);
+                break;
+            case TLM_REC_LOG:
+                //  Message is printed as it is, except for newline at its end
+                text = logs.Expand(r);
+                while (!text.empty() && ((text[text.size() - 1] == '\n')
+                                         || (text[text.size() - 1] == '\r')))
+                    text.erase(text.size() - 1);
+                printf("log,%u,%s\n", r.time, text.c_str());
+                break;
+            }
+        }
+        fflush(stdout);
+    }
+
+    const TlmStats &s = dec.Stats();
+    fprintf(stderr, "frames: %u, lost: %u, CRC errors: %u, bad frames: %u, "
+            "unknown: %u, skipped blocks: %u\n", s.frames, s.lost,
+            s.crcErrors, s.badFrames, s.unknown, s.skipped);
+
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
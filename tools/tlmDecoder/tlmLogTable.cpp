@@ -0,0 +1,53 @@
+/**
+ * tlmLogTable.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Vedran Mikov
+ *
+ *  Generates table of format strings of tokenized log messages from sources
+ *  of the firmware (see UART_LOG_TOKENIZED in serialPort/uartHW.h), used by
+ *  tlmDump to expand them. Table is written to standard output. Fails if two
+ *  different format strings get the same ID; rewording one of them fixes it.
+ *
+ *  Build (from root of the repository):
+ *      g++ -I. -o tlmLogTable tools/tlmDecoder/tlmLogTable.cpp
+ *          tools/tlmDecoder/logTable.cpp -x c libs/myLib.c -lm
+ *  Use (from root of the repository, with every build of the firmware):
+ *      tlmLogTable $(git ls-files '*.c' '*.cpp' '*.h') > log.tbl
+ *
+ *  @version 1.0.0
+ *  V1.0.0
+ *  +Creation of file
+ */
+#include <stdio.h>
+
+#include "logTable.h"
+
+
+int main(int argc, char **argv)
+{
+    LogTable table;
+    int n, found = 0, retVal = 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <source files...> > log.tbl\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((n = table.Scan(argv[i])) < 0)
+        {
+            fprintf(stderr, "%s: failed\n", argv[i]);
+            retVal = 1;
+            continue;
+        }
+        found += n;
+    }
+
+    table.Save(stdout);
+    fprintf(stderr, "%d log calls\n", found);
+
+    return retVal;
+}